@@ -0,0 +1,11 @@
+
+IncludeDirs="-I ../../third_party/glm -I ../../third_party/gon -I ../../third_party/sdl2/include"
+
+# The level tool is headless so it only uses the SDL headers and links nothing.
+Libraries="-pthread"
+
+Defines="-D PLATFORM_LINUX"
+
+mkdir -p ../../binary/linux
+cd ../../binary/linux
+g++ -std=c++17 -O2 ../../source/level_tool.cpp -o level_tool $IncludeDirs $Defines $Libraries
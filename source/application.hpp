@@ -21,6 +21,7 @@ GLOBAL constexpr const char* APP_ARCH = "32-bit";
 
 GLOBAL constexpr const char* CRASH_DUMP_PATH = "crashes/";
 GLOBAL constexpr const char* BACKUPS_PATH = "backups/";
+GLOBAL constexpr const char* LEVEL_INDEX_PATH = "indices/";
 GLOBAL constexpr const char* LOGS_PATH = "logs/";
 
 GLOBAL SDL_Event main_event;
@@ -0,0 +1,268 @@
+// The manifest is laid out as follows (all little-endian):
+//
+//   u32 magic, u32 version, u32 head, u32 slot count
+//   (for each slot in the order they were written) u32 slot
+
+GLOBAL constexpr u32 BACKUP_MANIFEST_MAGIC   = 0x4D4B4254; // "TBKM"
+GLOBAL constexpr u32 BACKUP_MANIFEST_VERSION = 1;
+
+FILDEF bool internal__is_backup_ext (Backup_Type type, const std::string& ext)
+{
+    switch (type)
+    {
+        case (Backup_Type::LEVEL): return (ext == ".lvl" || ext == ".lvd");
+        case (Backup_Type::MAP  ): return (ext == ".csv");
+    }
+    return false;
+}
+
+FILDEF bool internal__load_backup_manifest (Backup_Manifest& manifest)
+{
+    FILE* file = fopen(manifest.file_name.c_str(), "rb");
+    if (!file) return false;
+    defer { fclose(file); };
+
+    size_t file_size = get_size_of_file(file);
+
+    u32 header[4];
+    if (fread(header, sizeof(u32), 4, file) != 4) return false;
+    for (auto& h: header) h = SDL_SwapLE32(h);
+
+    if (header[0] != BACKUP_MANIFEST_MAGIC  ) return false;
+    if (header[1] != BACKUP_MANIFEST_VERSION) return false;
+
+    u32 head  = header[2];
+    u32 count = header[3];
+
+    if (count > (file_size - sizeof(header)) / sizeof(u32)) return false;
+    if (count > 0 && head >= count) return false;
+
+    manifest.slots.resize(count);
+    if (count && fread(&manifest.slots[0], sizeof(u32), count, file) != count) return false;
+    for (auto& slot: manifest.slots) slot = SDL_SwapLE32(slot);
+
+    manifest.head = head;
+    return true;
+}
+
+FILDEF void internal__save_backup_manifest (const Backup_Manifest& manifest)
+{
+    std::vector<u32> buffer;
+    buffer.push_back(SDL_SwapLE32(BACKUP_MANIFEST_MAGIC));
+    buffer.push_back(SDL_SwapLE32(BACKUP_MANIFEST_VERSION));
+    buffer.push_back(SDL_SwapLE32(manifest.head));
+    buffer.push_back(SDL_SwapLE32(CAST(u32, manifest.slots.size())));
+    for (auto slot: manifest.slots) buffer.push_back(SDL_SwapLE32(slot));
+
+    FILE* file = fopen(manifest.file_name.c_str(), "wb");
+    if (!file)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to save backup manifest '%s'!", manifest.file_name.c_str());
+        return;
+    }
+    defer { fclose(file); };
+
+    fwrite(&buffer[0], sizeof(u32), buffer.size(), file);
+}
+
+FILDEF void internal__rebuild_backup_manifest (Backup_Type type, const std::string& path, const std::string& name, Backup_Manifest& manifest)
+{
+    LOG_DEBUG("Rebuilding Backup Manifest: %s", manifest.file_name.c_str());
+
+    // This is the only time the backup folder gets searched, we order the
+    // existing backups by their write times to recreate the ring buffer.
+    std::vector<std::string> files;
+    list_path_content(path, files);
+
+    std::vector<std::pair<u64, u32>> found;
+    for (auto& file: files)
+    {
+        size_t dot = file.find_last_of(".");
+        if (dot == std::string::npos || !internal__is_backup_ext(type, file.substr(dot))) continue;
+
+        // We strip extension twice because there are two extension parts to backups the .bak and the .lvl.
+        std::string slot_name(strip_file_path_and_ext(file));
+        size_t pos = slot_name.rfind(".bak");
+        if (pos == std::string::npos || !insensitive_compare(name, slot_name.substr(0, pos))) continue;
+
+        std::string number(slot_name.substr(pos+strlen(".bak")));
+        if (number.empty() || number.find_first_not_of("0123456789") != std::string::npos) continue;
+
+        found.push_back({ last_file_write_time(file), CAST(u32, strtoul(number.c_str(), NULL, 10)) });
+    }
+    std::sort(found.begin(), found.end());
+
+    // A level backup slot could briefly have both a .lvl and .lvd file so we
+    // only keep the most recent entry for each of the slots that were found.
+    manifest.slots.clear();
+    manifest.head = 0;
+    for (auto it=found.rbegin(); it!=found.rend(); ++it)
+    {
+        if (std::find(manifest.slots.begin(), manifest.slots.end(), it->second) == manifest.slots.end())
+        {
+            manifest.slots.push_back(it->second);
+        }
+    }
+    std::reverse(manifest.slots.begin(), manifest.slots.end());
+}
+
+// Slots that have been handed out by get_next_backup_slot but have not been
+// committed or abandoned yet, keyed by the manifest's file name. The manifest
+// on disk only ever records completed backups, so these get replayed over it
+// when planning, otherwise a second backup planned before the first one has
+// been written would be given the very same slot.
+
+GLOBAL std::map<std::string, std::vector<u32>> backup_reservations;
+
+FILDEF std::string internal__get_backup_manifest_name (Backup_Type type, const std::string& backup_path)
+{
+    return backup_path + ((type == Backup_Type::LEVEL) ? "level.manifest" : "map.manifest");
+}
+
+FILDEF void internal__open_backup_manifest (Backup_Type type, const std::string& backup_path, const std::string& name, Backup_Manifest& manifest)
+{
+    manifest.file_name = internal__get_backup_manifest_name(type, backup_path);
+    if (!internal__load_backup_manifest(manifest))
+    {
+        internal__rebuild_backup_manifest(type, backup_path, name, manifest);
+    }
+}
+
+FILDEF void internal__make_newest_backup_slot (Backup_Manifest& manifest, u32 index)
+{
+    // Unroll the ring so the oldest slot comes first and then move the slot
+    // to the end, as it is now the newest backup. This also means making the
+    // same slot the newest more than once is harmless.
+    std::vector<u32>& slots = manifest.slots;
+    if (!slots.empty()) std::rotate(slots.begin(), slots.begin()+manifest.head, slots.end());
+    slots.erase(std::remove(slots.begin(), slots.end(), index), slots.end());
+    slots.push_back(index);
+    manifest.head = 0;
+}
+
+// Splits the full path of a backup slot (without the extension) back up into
+// the folder, the name of the level/map, and the slot number within the ring.
+FILDEF bool internal__parse_backup_slot_name (const std::string& slot_name, std::string& backup_path, std::string& name, u32& index)
+{
+    size_t pos = slot_name.rfind(".bak");
+    if (pos == std::string::npos) return false;
+
+    std::string number(slot_name.substr(pos+strlen(".bak")));
+    if (number.empty() || number.find_first_not_of("0123456789") != std::string::npos) return false;
+
+    size_t slash = slot_name.find_last_of("/", pos);
+    size_t start = (slash == std::string::npos) ? 0 : slash+1;
+
+    backup_path = slot_name.substr(0, start);
+    name        = slot_name.substr(start, pos-start);
+    index       = CAST(u32, strtoul(number.c_str(), NULL, 10));
+
+    return true;
+}
+
+FILDEF bool internal__release_backup_slot (Backup_Type type, const std::string& slot_name, std::string& backup_path, std::string& name, u32& index)
+{
+    if (!internal__parse_backup_slot_name(slot_name, backup_path, name, index)) return false;
+
+    auto it = backup_reservations.find(internal__get_backup_manifest_name(type, backup_path));
+    if (it != backup_reservations.end())
+    {
+        auto& reserved = it->second;
+        auto slot = std::find(reserved.begin(), reserved.end(), index);
+        if (slot != reserved.end()) reserved.erase(slot);
+        if (reserved.empty()) backup_reservations.erase(it);
+    }
+
+    return true;
+}
+
+FILDEF bool get_next_backup_slot (Backup_Type type, const std::string& file_name, Backup_Slot& slot)
+{
+    slot = Backup_Slot();
+
+    // Determine how many backups the user wants saved for a given level/map.
+    int backup_count = editor_settings.backup_count;
+    if (backup_count <= 0) return false; // No backups are wanted!
+
+    std::string name((file_name.empty()) ? "untitled" : strip_file_path_and_ext(file_name));
+
+    // Create a folder for this particular level/map's backups if it does not exist.
+    // We make separate sub-folders in the backup directory for each level as
+    // there was an issue in older versions with the editor freezing when backing
+    // up levels to a backups folder with loads of saves. This was because the
+    // editor was searching the folder for old backups (leading to a freeze).
+    std::string backup_path(get_appdata_path() + BACKUPS_PATH + name + "/");
+    if (!does_path_exist(backup_path))
+    {
+        if (!create_path(backup_path))
+        {
+            const char* type_name = (type == Backup_Type::LEVEL) ? "level" : "map";
+            LOG_ERROR(ERR_MIN, "Failed to create backup for %s \"%s\"!", type_name, name.c_str());
+            return false;
+        }
+    }
+
+    // The ring as it will be once all of the reserved slots have been written.
+    Backup_Manifest manifest;
+    internal__open_backup_manifest(type, backup_path, name, manifest);
+    std::vector<u32>& reserved = backup_reservations[manifest.file_name];
+    for (auto index: reserved) internal__make_newest_backup_slot(manifest, index);
+
+    const std::vector<u32>& slots = manifest.slots;
+    u32 head = manifest.head;
+
+    std::string backup_name(backup_path + name + ".bak");
+    u32 count = CAST(u32, slots.size());
+    u32 index;
+
+    // If there is still room to create a new backup then that is what we do.
+    // Otherwise, we overwrite the oldest backup which is the ring's head. The
+    // slot is reserved until commit_backup_slot or abandon_backup_slot is called.
+    if (editor_settings.unlimited_backups || (CAST(int, count) < backup_count))
+    {
+        index = count;
+        while (std::find(slots.begin(), slots.end(), index) != slots.end()) ++index;
+
+        if (count > 0) slot.newest = backup_name + std::to_string(slots[(head+count-1) % count]);
+    }
+    else
+    {
+        index = slots[head];
+
+        // The backup written after the one being replaced may depend on it.
+        if (count > 1)
+        {
+            slot.newest = backup_name + std::to_string(slots[(head+count-1) % count]);
+            slot.next   = backup_name + std::to_string(slots[(head+1) % count]);
+        }
+    }
+
+    slot.name = backup_name + std::to_string(index);
+    reserved.push_back(index);
+
+    return true;
+}
+
+FILDEF void commit_backup_slot (Backup_Type type, const std::string& slot_name)
+{
+    std::string backup_path;
+    std::string name;
+    u32 index;
+
+    if (!internal__release_backup_slot(type, slot_name, backup_path, name, index)) return;
+
+    // Only completed backups are saved in the manifest, not the reservations.
+    Backup_Manifest manifest;
+    internal__open_backup_manifest(type, backup_path, name, manifest);
+    internal__make_newest_backup_slot(manifest, index);
+    internal__save_backup_manifest(manifest);
+}
+
+FILDEF void abandon_backup_slot (Backup_Type type, const std::string& slot_name)
+{
+    std::string backup_path;
+    std::string name;
+    u32 index;
+
+    internal__release_backup_slot(type, slot_name, backup_path, name, index);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+// Each level/map backup folder contains a small manifest that records which
+// backup slots exist and the order they were written in (as a ring buffer).
+// This means picking the next slot to write does not need to list the folder
+// or check the write time of every backup, which used to freeze the editor.
+//
+// If the manifest is missing or corrupted it gets rebuilt from the folder.
+
+enum class Backup_Type { LEVEL, MAP };
+
+struct Backup_Manifest
+{
+    std::string file_name;
+
+    // The slots (the N in <name>.bak<N>.<ext>) in the order they were written
+    // with the head being the index of the oldest backup, the next to replace.
+    std::vector<u32> slots;
+    u32 head;
+};
+
+// The names are the full path of the backup slot without the file extension.
+struct Backup_Slot
+{
+    std::string name;   // The slot that should be written to.
+    std::string newest; // The most recently written slot (if there is one).
+    std::string next;   // The slot written after the one being replaced (if any).
+};
+
+// Returns false if no backups are wanted or the backup folder is unavailable.
+// The slot is reserved so that any other backups planned before it is written
+// get different slots, and it has to be either committed or abandoned after.
+FILDEF bool get_next_backup_slot (Backup_Type type, const std::string& file_name, Backup_Slot& slot);
+// Records the slot as the newest backup, this should only be called once the
+// backup has been completely written, so a failed write never advances the
+// ring and the manifest can't end up pointing at a partially written slot.
+FILDEF void commit_backup_slot   (Backup_Type type, const std::string& slot_name);
+// Releases the slot without recording it, for backups that failed to write.
+FILDEF void abandon_backup_slot  (Backup_Type type, const std::string& slot_name);
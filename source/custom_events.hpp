@@ -11,6 +11,9 @@ GLOBAL constexpr u32 EDITOR_EVENT_GPAK_PROGRESS = 5;
 GLOBAL constexpr u32 EDITOR_EVENT_SHOW_TOOLTIP  = 6;
 GLOBAL constexpr u32 EDITOR_EVENT_SHOW_UPDATE   = 7;
 GLOBAL constexpr u32 EDITOR_EVENT_ARROW_PAN     = 8;
+GLOBAL constexpr u32 EDITOR_EVENT_LEVEL_SAVED   = 9;
+GLOBAL constexpr u32 EDITOR_EVENT_LEVEL_LOADING = 10;
+GLOBAL constexpr u32 EDITOR_EVENT_LEVEL_INDEXED = 11;
 
 FILDEF void push_editor_event (Editor_Event id,
                                void* data1,
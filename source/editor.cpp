@@ -16,6 +16,9 @@ FILDEF Tab& internal__create_new_tab_and_focus (Tab_Type type)
     editor.tabs.insert(editor.tabs.begin()+location, Tab());
     Tab& tab = editor.tabs.at(location);
 
+    reserve_emergency_dump(editor.tabs.size());
+
+    tab.id              = ++editor.next_tab_id;
     tab.type            = type;
     tab.camera.x        = 0;
     tab.camera.y        = 0;
@@ -64,7 +67,11 @@ FILDEF bool internal__restore_tab (std::string file_name)
     {
         create_new_level_tab_and_focus();
         Tab& tab = get_current_tab();
-        return load_restore_level(tab, file_name);
+        if (!load_restore_level(tab, file_name)) return false;
+        // We don't know what the file on disk contains so it's always unsaved.
+        tab.saved_hash = 0;
+        tab.unsaved_changes = true;
+        return true;
     }
     if (type == ".csv")
     {
@@ -163,6 +170,9 @@ FILDEF void init_editor (int argc, char** argv)
     editor.tabs.clear();
     editor.current_tab = INVALID_TAB;
 
+    // Needs to be ready before any tabs get opened (including restored ones).
+    init_emergency_dump();
+
     editor.cooldown_timer = 0;
 
     editor.grid_visible =  true;
@@ -172,6 +182,14 @@ FILDEF void init_editor (int argc, char** argv)
     init_level_editor();
     init_map_editor();
 
+    // The editor can still save without this, it will just be synchronous.
+    init_level_saver();
+    // Same for loading, levels will be loaded on the main thread without it.
+    init_level_loader();
+    // Levels can still be browsed without this, the folder indices just won't
+    // get the hashes and histograms of their levels filled in.
+    init_level_indexer();
+
     // Handle restoring levels/maps from a previous instance that crashed.
     LOG_DEBUG("Looking for level/map files to restore...");
     std::vector<std::string> restore_files = internal__get_restore_files();
@@ -223,6 +241,7 @@ FILDEF void init_editor (int argc, char** argv)
                 Tab* tab = NULL;
                 if      (ext == ".lvl") level_drop_file(tab, file);
                 else if (ext == ".csv") map_drop_file  (tab, file);
+                else if (ext == ".lvd") load_level_backup_tab(file);
             }
         }
     }
@@ -237,6 +256,19 @@ FILDEF void quit_editor ()
 {
     internal__save_session_tabs();
 
+    // Any background loads are no longer needed so stop them reading early.
+    for (auto& tab: editor.tabs)
+    {
+        if (is_level_tab_loading(tab)) cancel_level_load(*tab.level_load);
+    }
+
+    quit_level_loader();
+    quit_level_saver();
+    // The saves that finished while quitting still need their backups recorded.
+    handle_completed_level_saves();
+    quit_level_indexer();
+    quit_emergency_dump();
+
     if (editor.cooldown_timer) SDL_RemoveTimer(editor.cooldown_timer);
     if (editor.backup_timer)   SDL_RemoveTimer(editor.backup_timer);
     if (editor.panning_timer)  SDL_RemoveTimer(editor.panning_timer);
@@ -278,10 +310,23 @@ FILDEF void handle_editor_events ()
             std::string ext(file.substr(file.find_last_of(".")));
             if      (ext == ".lvl") level_drop_file(tab, file);
             else if (ext == ".csv") map_drop_file  (tab, file);
+            else if (ext == ".lvd") load_level_backup_tab(file);
         }
         SDL_free(main_event.drop.file); // Docs say to free it!
     }
 
+    // These can all complete whether or not there are any tabs still open, a
+    // save's results (e.g. its backup) still need handling if its tab closed.
+    if (main_event.type == SDL_USEREVENT)
+    {
+        switch (main_event.user.code)
+        {
+            case (EDITOR_EVENT_LEVEL_INDEXED): handle_completed_level_indexing(); break;
+            case (EDITOR_EVENT_LEVEL_SAVED  ): handle_completed_level_saves   (); break;
+            case (EDITOR_EVENT_LEVEL_LOADING): handle_completed_level_loads   (); break;
+        }
+    }
+
     if (!are_there_any_tabs()) return;
 
     push_editor_camera_transform();
@@ -572,6 +617,10 @@ FILDEF void create_new_level_tab_and_focus (int w, int h)
     tab.level_history.current_position = -1;
     tab.tool_info.select.cached_size   =  0;
     create_blank_level(tab.level, w, h);
+
+    // A new level counts as saved until it differs from being blank.
+    tab.saved_hash  = get_level_hash(tab.level);
+    tab.backup_hash = tab.saved_hash;
 }
 
 FILDEF void create_new_map_tab_and_focus ()
@@ -606,6 +655,11 @@ FILDEF void close_tab (size_t index)
 
     if (save_changes_prompt(editor.tabs.at(index)) != ALERT_RESULT_CANCEL)
     {
+        // The worker lets go of the load by itself once it notices the cancel.
+        if (is_level_tab_loading(editor.tabs.at(index)))
+        {
+            cancel_level_load(*editor.tabs.at(index).level_load);
+        }
         if (editor.closed_tabs.empty() || editor.closed_tabs.back() != editor.tabs.at(index).name)
         {
             editor.closed_tabs.push_back(editor.tabs.at(index).name);
@@ -707,7 +761,14 @@ FILDEF int save_changes_prompt (Tab& tab)
         // the user was going to perform in order to maintain the level/map data.
         switch (tab.type)
         {
-            case (Tab_Type::LEVEL): if (!le_save     (tab)) return ALERT_RESULT_CANCEL; break;
+            case (Tab_Type::LEVEL):
+            {
+                if (!le_save(tab)) return ALERT_RESULT_CANCEL;
+                // The level is about to go away so we need the save to finish.
+                wait_for_level_saves();
+                handle_completed_level_saves();
+                if (tab.unsaved_changes) return ALERT_RESULT_CANCEL;
+            } break;
             case (Tab_Type::MAP  ): if (!save_map_tab(tab)) return ALERT_RESULT_CANCEL; break;
         }
     }
@@ -720,7 +781,7 @@ FILDEF void backup_tab (Tab& tab)
 {
     switch (tab.type)
     {
-        case (Tab_Type::LEVEL): backup_level_tab(tab.level, tab.name); break;
+        case (Tab_Type::LEVEL): backup_level_tab(tab,       tab.name); break;
         case (Tab_Type::MAP  ): backup_map_tab  (tab,       tab.name); break;
     }
 }
@@ -787,15 +848,3 @@ FILDEF void open_recently_closed_tab ()
     }
 }
 
-FILDEF void save_restore_files ()
-{
-    for (size_t i=0; i<editor.tabs.size(); ++i)
-    {
-        std::string file_name;
-        if      (editor.tabs.at(i).type == Tab_Type::LEVEL) file_name = ".lvl.restore" + std::to_string(i);
-        else if (editor.tabs.at(i).type == Tab_Type::MAP  ) file_name = ".csv.restore" + std::to_string(i);
-        file_name = make_path_absolute(file_name);
-        if      (editor.tabs.at(i).type == Tab_Type::LEVEL) save_restore_level(editor.tabs.at(i), file_name);
-        else if (editor.tabs.at(i).type == Tab_Type::MAP  ) save_restore_map  (editor.tabs.at(i), file_name);
-    }
-}
@@ -21,6 +21,7 @@ enum class Tab_Type { LEVEL, MAP };
 struct Tab
 {
     // GENERAL
+    u64               id; // Unique for the session, unlike the tab's index.
     Tab_Type        type;
     std::string     name;
     Camera        camera;
@@ -30,6 +31,9 @@ struct Tab
     Level         level;
     Tool_Info     tool_info;
     Level_History level_history;
+    u64 saved_hash;  // Level hash of the file on disk, for telling if there are unsaved changes.
+    u64 backup_hash; // Level hash of the last backup, unchanged levels don't get backed up again.
+    std::shared_ptr<Level_Load> level_load; // Set whilst the level is being loaded in the background.
     bool tile_layer_active[LEVEL_LAYER_TOTAL];
     std::vector<Select_Bounds> old_select_state; // We use this for the selection history undo/redo system.
 
@@ -47,6 +51,7 @@ struct Editor
 
     std::vector<Tab> tabs;
     size_t current_tab;
+    u64 next_tab_id;
 
     SDL_TimerID backup_timer;
     SDL_TimerID cooldown_timer;
@@ -114,4 +119,3 @@ FILDEF bool save_prompt_all_editor_tabs ();
 
 FILDEF void open_recently_closed_tab ();
 
-FILDEF void save_restore_files ();
@@ -0,0 +1,127 @@
+struct Emergency_File
+{
+    Raw_File file;
+
+    std::string temp_name;
+    std::string level_name;
+    std::string map_name;
+};
+
+struct Emergency_Dump
+{
+    std::vector<Emergency_File> files;
+    std::vector<u8> buffer;
+
+    bool dumped;
+};
+
+GLOBAL Emergency_Dump emergency_dump;
+
+FILDEF void emergency_write (Emergency_Writer& writer, const void* data, size_t size)
+{
+    const u8* bytes = CAST(const u8*, data);
+    while (size && !writer.failed)
+    {
+        if (writer.used == EMERGENCY_BUFFER_SIZE) emergency_flush(writer);
+        size_t count = std::min(size, EMERGENCY_BUFFER_SIZE-writer.used);
+        memcpy(writer.buffer+writer.used, bytes, count);
+        writer.used += count;
+        bytes += count;
+        size -= count;
+    }
+}
+
+FILDEF bool emergency_flush (Emergency_Writer& writer)
+{
+    if (!writer.failed && writer.used)
+    {
+        writer.failed = !write_raw_file(writer.file, writer.buffer, writer.used);
+    }
+    writer.used = 0;
+    return !writer.failed;
+}
+
+FILDEF void init_emergency_dump ()
+{
+    emergency_dump.files.clear();
+    emergency_dump.buffer.resize(EMERGENCY_BUFFER_SIZE);
+    emergency_dump.dumped = false;
+}
+
+FILDEF void quit_emergency_dump ()
+{
+    // None of the scratch files are needed once the editor exits. This also
+    // covers files that failed to open or were left partial by a failed dump,
+    // complete dumps have already been renamed so they're not touched here.
+    for (auto& file: emergency_dump.files)
+    {
+        close_raw_file(file.file);
+        file.file = INVALID_RAW_FILE;
+        remove(file.temp_name.c_str());
+    }
+    emergency_dump.files.clear();
+}
+
+FILDEF void reserve_emergency_dump (size_t tab_count)
+{
+    // Files are never closed until the editor quits, so the number of files
+    // only needs to grow up to the most tabs that have been open at a time.
+    while (emergency_dump.files.size() < tab_count)
+    {
+        std::string index(std::to_string(emergency_dump.files.size()));
+
+        Emergency_File file;
+        file.temp_name  = make_path_absolute(".emergency"   + index);
+        file.level_name = make_path_absolute(".lvl.restore" + index);
+        file.map_name   = make_path_absolute(".csv.restore" + index);
+        file.file       = open_raw_file(file.temp_name);
+
+        if (file.file == INVALID_RAW_FILE)
+        {
+            LOG_ERROR(ERR_MIN, "Failed to open emergency file '%s'!", file.temp_name.c_str());
+        }
+
+        emergency_dump.files.push_back(file);
+    }
+}
+
+STDDEF void write_emergency_dump ()
+{
+    if (emergency_dump.dumped || emergency_dump.buffer.empty()) return;
+    emergency_dump.dumped = true;
+
+    size_t count = std::min(editor.tabs.size(), emergency_dump.files.size());
+    for (size_t i=0; i<count; ++i)
+    {
+        const Tab& tab = editor.tabs[i];
+        Emergency_File& file = emergency_dump.files[i];
+
+        if (file.file == INVALID_RAW_FILE) continue;
+
+        // Levels that are still loading have no changes that could be lost.
+        if (is_level_tab_loading(tab)) continue;
+
+        Emergency_Writer writer = { file.file, &emergency_dump.buffer[0], 0, false };
+
+        const char* restore_name = NULL;
+        bool success = false;
+
+        if (tab.type == Tab_Type::LEVEL)
+        {
+            restore_name = file.level_name.c_str();
+            success = dump_restore_level(tab, writer);
+        }
+        else if (tab.type == Tab_Type::MAP)
+        {
+            restore_name = file.map_name.c_str();
+            success = dump_restore_map(tab, writer);
+        }
+
+        close_raw_file(file.file);
+        file.file = INVALID_RAW_FILE;
+
+        // Only complete dumps are given the restore name, so a partial one is
+        // never going to be mistaken for a restore file on the next launch.
+        if (success) rename_raw_file(file.temp_name.c_str(), restore_name);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+// Restore files for all of the open tabs get written out when the editor
+// crashes. A crashed process can't be trusted to allocate memory, use stdio
+// or build up paths, so everything needed is prepared ahead of time instead.
+// The write buffer is allocated at startup and a file is opened for each tab
+// (under a temporary name) as soon as there are enough tabs to need it. The
+// dump then only encodes into the buffer and hands it to raw OS write calls,
+// before renaming each file to the restore name looked for on next launch.
+
+GLOBAL constexpr size_t EMERGENCY_BUFFER_SIZE = 256*1024;
+
+struct Emergency_Writer
+{
+    Raw_File file;
+    u8*      buffer;
+    size_t   used;
+    bool     failed;
+};
+
+// Buffers the data and writes it out whenever the buffer gets full. Once any
+// write fails the writer is marked as failed and everything else is ignored.
+FILDEF void emergency_write (Emergency_Writer& writer, const void* data, size_t size);
+FILDEF bool emergency_flush (Emergency_Writer& writer);
+
+FILDEF void init_emergency_dump    ();
+FILDEF void quit_emergency_dump    ();
+FILDEF void reserve_emergency_dump (size_t tab_count);
+
+// Only makes async-signal-safe calls so it can be called by the crash handler.
+// It only ever dumps the tabs once, any further calls after that do nothing.
+STDDEF void write_emergency_dump   ();
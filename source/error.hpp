@@ -6,6 +6,9 @@
 GLOBAL void(*error_terminate_callback)(void);
 GLOBAL void(*error_maximum_callback)(void);
 
+// Called from inside of the crash handler so it must be async-signal-safe.
+GLOBAL void(*error_crash_callback)(void);
+
 enum Error_Level { ERR_MIN, ERR_MED, ERR_MAX };
 
 FILDEF void quit_error_system ();
@@ -9,6 +9,7 @@ GLOBAL constexpr const char* KEY_BINDINGS_FALLBACK =
 "level_close { main [\"Ctrl\" \"W\"] }\n"
 "level_close_all { main [\"Ctrl\" \"Alt\" \"W\"] }\n"
 "level_resize { main [\"Ctrl\" \"R\"] }\n"
+"level_merge { main [\"Ctrl\" \"Shift\" \"M\"] }\n"
 "undo { main [\"Ctrl\" \"Z\"] }\n"
 "redo { main [\"Ctrl\" \"Y\"] }\n"
 "history_begin { main [\"Ctrl\" \"Shift\" \"Z\"] }\n"
@@ -227,6 +228,7 @@ FILDEF void internal__load_editor_key_bindings (const GonObject& a, const GonObj
     internal__add_key_binding(a, b, KB_LEVEL_CLOSE         , close_current_tab          );
     internal__add_key_binding(a, b, KB_LEVEL_CLOSE_ALL     , close_all_tabs             );
     internal__add_key_binding(a, b, KB_LEVEL_RESIZE        , le_resize                  );
+    internal__add_key_binding(a, b, KB_LEVEL_MERGE         , le_merge                   );
     internal__add_key_binding(a, b, KB_UNDO                , hb_undo_action             );
     internal__add_key_binding(a, b, KB_REDO                , hb_redo_action             );
     internal__add_key_binding(a, b, KB_HISTORY_BEGIN       , hb_history_begin           );
@@ -451,6 +453,7 @@ FILDEF void dump_editor_key_bindings ()
     LOG_DEBUG("%s \"%s\" (\"%s\")", KB_LEVEL_CLOSE, get_key_binding_main_string(KB_LEVEL_CLOSE).c_str(), get_key_binding_alt_string(KB_LEVEL_CLOSE).c_str());
     LOG_DEBUG("%s \"%s\" (\"%s\")", KB_LEVEL_CLOSE_ALL, get_key_binding_main_string(KB_LEVEL_CLOSE_ALL).c_str(), get_key_binding_alt_string(KB_LEVEL_CLOSE_ALL).c_str());
     LOG_DEBUG("%s \"%s\" (\"%s\")", KB_LEVEL_RESIZE, get_key_binding_main_string(KB_LEVEL_RESIZE).c_str(), get_key_binding_alt_string(KB_LEVEL_RESIZE).c_str());
+    LOG_DEBUG("%s \"%s\" (\"%s\")", KB_LEVEL_MERGE, get_key_binding_main_string(KB_LEVEL_MERGE).c_str(), get_key_binding_alt_string(KB_LEVEL_MERGE).c_str());
     LOG_DEBUG("%s \"%s\" (\"%s\")", KB_UNDO, get_key_binding_main_string(KB_UNDO).c_str(), get_key_binding_alt_string(KB_UNDO).c_str());
     LOG_DEBUG("%s \"%s\" (\"%s\")", KB_REDO, get_key_binding_main_string(KB_REDO).c_str(), get_key_binding_alt_string(KB_REDO).c_str());
     LOG_DEBUG("%s \"%s\" (\"%s\")", KB_HISTORY_BEGIN, get_key_binding_main_string(KB_HISTORY_BEGIN).c_str(), get_key_binding_alt_string(KB_HISTORY_BEGIN).c_str());
@@ -14,6 +14,7 @@ GLOBAL constexpr const char* KB_LEVEL_SAVE_AS        = "level_save_as";
 GLOBAL constexpr const char* KB_LEVEL_CLOSE          = "level_close";
 GLOBAL constexpr const char* KB_LEVEL_CLOSE_ALL      = "level_close_all";
 GLOBAL constexpr const char* KB_LEVEL_RESIZE         = "level_resize";
+GLOBAL constexpr const char* KB_LEVEL_MERGE          = "level_merge";
 GLOBAL constexpr const char* KB_UNDO                 = "undo";
 GLOBAL constexpr const char* KB_REDO                 = "redo";
 GLOBAL constexpr const char* KB_HISTORY_BEGIN        = "history_begin";
@@ -11,69 +11,232 @@ constexpr Level_Layer LEVEL_IO_ORDER[LEVEL_LAYER_TOTAL]
     LEVEL_LAYER_BACK2
 };
 
-FILDEF bool internal__load_level (FILE* file, Level& level)
+// The .lvl format stores all of its data as big-endian 32-bit integers so on
+// little-endian machines we need to swap every tile. We do this over a whole
+// layer at once so that it can be vectorized rather than going tile-by-tile.
+
+STDDEF void internal__swap_tile_endianness (Tile_ID* tiles, size_t count)
 {
-    LOG_DEBUG("Level Header: v%d %dx%dx%d", level.header.version, level.header.width, level.header.height, level.header.layers);
+    #if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    size_t i = 0;
+
+    #if defined(SIMD_AVX2)
+    const __m256i mask = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+                                          3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+    for (; (i+8)<=count; i+=8)
+    {
+        __m256i v = _mm256_loadu_si256(CAST(const __m256i*, tiles+i));
+        _mm256_storeu_si256(CAST(__m256i*, tiles+i), _mm256_shuffle_epi8(v, mask));
+    }
+    #elif defined(SIMD_SSE2)
+    // SSE2 has no byte shuffle so we swap the 16-bit halves of each tile and
+    // then swap the two bytes within each of those halves using some shifts.
+    for (; (i+4)<=count; i+=4)
+    {
+        __m128i v = _mm_loadu_si128(CAST(const __m128i*, tiles+i));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2,3,0,1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2,3,0,1));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(CAST(__m128i*, tiles+i), v);
+    }
+    #elif defined(SIMD_NEON)
+    for (; (i+4)<=count; i+=4)
+    {
+        uint8x16_t v = vld1q_u8(CAST(const u8*, tiles+i));
+        vst1q_u8(CAST(u8*, tiles+i), vrev32q_u8(v));
+    }
+    #endif
+
+    // Handle whatever is left over that could not fill a full vector.
+    for (; i<count; ++i)
+    {
+        tiles[i] = SDL_Swap32(tiles[i]);
+    }
+    #endif // SDL_LIL_ENDIAN
+}
+
+FILDEF size_t internal__get_remaining_file_size (FILE* file)
+{
+    long current = ftell(file);
+    fseek(file, 0L, SEEK_END);
+    long end = ftell(file);
+    fseek(file, current, SEEK_SET);
+    return (end > current) ? CAST(size_t, end - current) : 0;
+}
+
+// Checks that the header is sane and that there is enough data following it
+// for all of the layers. This is done before allocating anything so a corrupt
+// header can't make us allocate gigabytes of memory or read past the file end.
+// The data size passed in should be the total size including the header.
 
-    fread(&level.header.version, sizeof(s32), 1, file);
-    fread(&level.header.width  , sizeof(s32), 1, file);
-    fread(&level.header.height , sizeof(s32), 1, file);
-    fread(&level.header.layers , sizeof(s32), 1, file);
+FILDEF bool internal__validate_level_header (const Level_Header& header, size_t data_size, std::string& error)
+{
+    if (header.version != 1)
+    {
+        error = format_string("Invalid level file version '%d'!", header.version);
+        return false;
+    }
 
-    level.header.version = SDL_SwapBE32(level.header.version);
-    level.header.width   = SDL_SwapBE32(level.header.width  );
-    level.header.height  = SDL_SwapBE32(level.header.height );
-    level.header.layers  = SDL_SwapBE32(level.header.layers );
+    s32 lw = header.width;
+    s32 lh = header.height;
 
-    if (level.header.version != 1)
+    if (lw < MINIMUM_LEVEL_WIDTH || lw > MAXIMUM_LEVEL_WIDTH || lh < MINIMUM_LEVEL_HEIGHT || lh > MAXIMUM_LEVEL_HEIGHT)
     {
-        std::string msg(format_string("Invalid level file version '%d'!", level.header.version));
-        show_alert("Error", msg, ALERT_TYPE_ERROR, ALERT_BUTTON_OK, "Main");
+        error = format_string("Invalid level size '%dx%d'!", lw, lh);
         return false;
     }
 
-    s32 lw = level.header.width;
-    s32 lh = level.header.height;
+    size_t layer_size = CAST(size_t, lw) * CAST(size_t, lh);
+    if (data_size < (sizeof(Level_Header) + (layer_size * LEVEL_LAYER_TOTAL * sizeof(Tile_ID))))
+    {
+        error = format_string("Level file is truncated for size '%dx%d'!", lw, lh);
+        return false;
+    }
+
+    return true;
+}
+
+FILDEF void internal__decode_level_header (const s32 raw[4], Level_Header& header)
+{
+    header.version = SDL_SwapBE32(raw[0]);
+    header.width   = SDL_SwapBE32(raw[1]);
+    header.height  = SDL_SwapBE32(raw[2]);
+    header.layers  = SDL_SwapBE32(raw[3]);
+}
+
+// Does not report any errors itself so it is safe to call on other threads,
+// instead the reason for the failure is passed back through the error string.
+//
+// The callback is called after each band of rows is decoded with how much of
+// the level has been read so far (from zero to one). If it returns false the
+// load is stopped and fails with an empty error. It is of the following form:
+//
+//   bool callback (float progress);
+
+template<typename T>
+FILDEF bool internal__load_level (FILE* file, Level& level, std::string& error, T callback)
+{
+    size_t file_size = internal__get_remaining_file_size(file);
+
+    s32 header[4] = {};
+    if (fread(header, sizeof(s32), 4, file) != 4)
+    {
+        error = "Level file is too small to be valid!";
+        return false;
+    }
+
+    internal__decode_level_header(header, level.header);
+
+    if (!internal__validate_level_header(level.header, file_size, error))
+    {
+        return false;
+    }
+
+    int lw = level.header.width;
+    int lh = level.header.height;
+
+    // The layers are read in bands of rows one chunk high, so the scratch
+    // buffer stays small and all-empty chunks never get allocated at all.
+    std::vector<Tile_ID> buffer(CAST(size_t, lw) * TILE_CHUNK_SIZE);
+
+    float total_rows = CAST(float, lh) * LEVEL_LAYER_TOTAL;
 
     for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
     {
         auto& layer = level.data[LEVEL_IO_ORDER[i]];
-        layer.assign(lw*lh, 0);
-        for (auto& tile: layer)
+        resize_tile_layer(layer, lw, lh);
+        for (int y=0; y<lh; y+=TILE_CHUNK_SIZE)
         {
-            fread(&tile, sizeof(Tile_ID), 1, file);
-            tile = SDL_SwapBE32(tile);
+            int rows = std::min(TILE_CHUNK_SIZE, lh-y);
+            size_t count = CAST(size_t, lw) * rows;
+            if (fread(&buffer[0], sizeof(Tile_ID), count, file) != count)
+            {
+                error = "Failed to read level layer data!";
+                return false;
+            }
+            internal__swap_tile_endianness(&buffer[0], count);
+            write_tile_rect(layer, 0, y, lw, rows, &buffer[0]);
+
+            if (!callback(CAST(float, i*lh + y+rows) / total_rows))
+            {
+                error.clear();
+                return false;
+            }
         }
     }
 
     return true;
 }
 
-FILDEF void internal__save_level (FILE* file, const Level& level)
+FILDEF bool internal__load_level (FILE* file, Level& level, std::string& error)
 {
-    LOG_DEBUG("Level Header: v%d %dx%dx%d", level.header.version, level.header.width, level.header.height, level.header.layers);
+    return internal__load_level(file, level, error, [](float progress) { return true; });
+}
+
+FILDEF void internal__encode_level (FILE* file, const Level& level)
+{
+    s32 header[4];
+
+    header[0] = SDL_SwapBE32(level.header.version);
+    header[1] = SDL_SwapBE32(level.header.width  );
+    header[2] = SDL_SwapBE32(level.header.height );
+    header[3] = SDL_SwapBE32(level.header.layers );
 
-    s32 version = SDL_SwapBE32(level.header.version);
-    s32 width   = SDL_SwapBE32(level.header.width  );
-    s32 height  = SDL_SwapBE32(level.header.height );
-    s32 layers  = SDL_SwapBE32(level.header.layers );
+    fwrite(header, sizeof(s32), 4, file);
 
-    fwrite(&version, sizeof(s32), 1, file);
-    fwrite(&width  , sizeof(s32), 1, file);
-    fwrite(&height , sizeof(s32), 1, file);
-    fwrite(&layers , sizeof(s32), 1, file);
+    // Each layer is encoded into a scratch buffer in bands of rows one chunk
+    // high and then each of those bands are written out as a single block.
+    int lw = level.header.width;
+    int lh = level.header.height;
 
+    std::vector<Tile_ID> buffer(CAST(size_t, lw) * TILE_CHUNK_SIZE);
     for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
     {
-        auto& layer = level.data[LEVEL_IO_ORDER[i]];
-        for (auto& tile: layer)
+        const auto& layer = level.data[LEVEL_IO_ORDER[i]];
+        if (get_tile_layer_size(layer) == 0) continue;
+        for (int y=0; y<lh; y+=TILE_CHUNK_SIZE)
         {
-            Tile_ID id = SDL_SwapBE32(tile);
-            fwrite(&id, sizeof(Tile_ID), 1, file);
+            int rows = std::min(TILE_CHUNK_SIZE, lh-y);
+            size_t count = CAST(size_t, lw) * rows;
+            read_tile_rect(layer, 0, y, lw, rows, &buffer[0]);
+            internal__swap_tile_endianness(&buffer[0], count);
+            fwrite(&buffer[0], sizeof(Tile_ID), count, file);
         }
     }
 }
 
+FILDEF bool internal__write_level_file (const Level& level, std::string file_name)
+{
+    FILE* file = fopen(file_name.c_str(), "wb");
+    if (!file) return false;
+    internal__encode_level(file, level);
+    bool success = (ferror(file) == 0);
+    if (fclose(file) != 0) success = false;
+    return success;
+}
+
+FILDEF bool internal__write_level_file_atomic (const Level& level, std::string file_name)
+{
+    // Write to a temporary file and then replace the target with it so that
+    // the target is always either the old level or the complete new level.
+    std::string temp_name(file_name + ".tmp");
+    if (!internal__write_level_file(level, temp_name))
+    {
+        remove(temp_name.c_str());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_name, file_name, error);
+    if (error)
+    {
+        remove(temp_name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 STDDEF bool load_level (Level& level, std::string file_name)
 {
     // We don't make the path absolute or anything becuase if that is needed
@@ -81,17 +244,37 @@ STDDEF bool load_level (Level& level, std::string file_name)
 
     LOG_DEBUG("Loading Level: %s", file_name.c_str());
 
+    std::string error;
+    if (!read_level(level, file_name, error))
+    {
+        LOG_ERROR(ERR_MED, "%s", error.c_str());
+        return false;
+    }
+
+    LOG_DEBUG("Level Header: v%d %dx%dx%d", level.header.version, level.header.width, level.header.height, level.header.layers);
+    return true;
+}
+
+template<typename T>
+FILDEF bool internal__read_level (Level& level, std::string file_name, std::string& error, T callback)
+{
     FILE* file = fopen(file_name.c_str(), "rb");
     if (!file)
     {
-        LOG_ERROR(ERR_MED, "Failed to load level file '%s'!", file_name.c_str());
+        error = format_string("Failed to load level file '%s'!", file_name.c_str());
         return false;
     }
     defer { fclose(file); };
 
     // If the level is empty/blank we just create a blank default level.
     if (get_size_of_file(file) == 0) return create_blank_level(level);
-    else                             return internal__load_level(file, level);
+
+    return internal__load_level(file, level, error, callback);
+}
+
+STDDEF bool read_level (Level& level, std::string file_name, std::string& error)
+{
+    return internal__read_level(level, file_name, error, [](float progress) { return true; });
 }
 
 STDDEF bool save_level (const Level& level, std::string file_name)
@@ -100,19 +283,205 @@ STDDEF bool save_level (const Level& level, std::string file_name)
     // then it should be handled by a higher-level than this internal system.
 
     LOG_DEBUG("Saving Level: %s", file_name.c_str());
+    LOG_DEBUG("Level Header: v%d %dx%dx%d", level.header.version, level.header.width, level.header.height, level.header.layers);
 
-    FILE* file = fopen(file_name.c_str(), "wb");
-    if (!file)
+    if (!internal__write_level_file_atomic(level, file_name))
     {
         LOG_ERROR(ERR_MED, "Failed to save level file '%s'!", file_name.c_str());
         return false;
     }
-    defer { fclose(file); };
 
-    internal__save_level(file, level);
     return true;
 }
 
+// Restore files are written from the crash handler so they need to be small
+// and quick to write. Most layers are almost entirely zero so we run-length
+// encode each layer and store a checksum of the decoded tiles so that any
+// corrupted restore data is detected rather than loaded in as a bad level.
+//
+// After the level name the data is laid out as follows (all little-endian):
+//
+//   u32 magic, u32 version, s32 version/width/height/layers
+//   (for each layer in IO order) u32 run count, u32 checksum, runs...
+//   (for each run) u32 length, s32 tile ID
+//
+// Older restore files just contain a normal level after the name, these are
+// detected by the missing magic number and are still loaded in the old way.
+
+GLOBAL constexpr u32 RESTORE_MAGIC   = 0x53455254; // "TRES"
+GLOBAL constexpr u32 RESTORE_VERSION = 1;
+
+GLOBAL constexpr u32 FNV_OFFSET_BASIS = 2166136261u;
+GLOBAL constexpr u32 FNV_PRIME        = 16777619u;
+
+FILDEF u32 internal__checksum_tiles (const Tile_ID* tiles, size_t count, u32 hash = FNV_OFFSET_BASIS)
+{
+    // FNV-1a over the tile values.
+    for (size_t i=0; i<count; ++i)
+    {
+        hash = (hash ^ CAST(u32, tiles[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+FILDEF u32 internal__checksum_layer (const Tile_Layer& layer)
+{
+    // The same as checksumming all the tiles of the layer in row-major order.
+    std::vector<Tile_ID> row(layer.width);
+    u32 hash = FNV_OFFSET_BASIS;
+    for (int y=0; y<layer.height; ++y)
+    {
+        read_tile_row(layer, 0, y, layer.width, row.data());
+        hash = internal__checksum_tiles(row.data(), row.size(), hash);
+    }
+    return hash;
+}
+
+FILDEF void internal__put_u32 (std::vector<u8>& buffer, u32 value)
+{
+    value = SDL_SwapLE32(value);
+    const u8* bytes = CAST(const u8*, &value);
+    buffer.insert(buffer.end(), bytes, bytes+sizeof(u32));
+}
+
+FILDEF bool internal__get_u32 (const std::vector<u8>& buffer, size_t& cursor, u32& value)
+{
+    if (cursor+sizeof(u32) > buffer.size()) return false;
+    memcpy(&value, &buffer[cursor], sizeof(u32));
+    value = SDL_SwapLE32(value);
+    cursor += sizeof(u32);
+    return true;
+}
+
+// Calls the callback with each run of identical tiles in the layer (in row-
+// major order, with runs carrying on across rows) and checksums the tiles as
+// they are visited. Does not allocate, the row buffer must be layer width.
+
+template<typename T>
+FILDEF u32 internal__for_each_tile_run (const Tile_Layer& layer, Tile_ID* row, T callback)
+{
+    u32 hash = FNV_OFFSET_BASIS;
+    u32 run_length = 0;
+    Tile_ID run_id = 0;
+
+    for (int y=0; y<layer.height; ++y)
+    {
+        read_tile_row(layer, 0, y, layer.width, row);
+        hash = internal__checksum_tiles(row, layer.width, hash);
+        for (int x=0; x<layer.width; ++x)
+        {
+            if (run_length && row[x] != run_id)
+            {
+                callback(run_length, run_id);
+                run_length = 0;
+            }
+            run_id = row[x];
+            ++run_length;
+        }
+    }
+    if (run_length) callback(run_length, run_id);
+
+    return hash;
+}
+
+// Restore files are written from the crash handler so encoding them can not
+// allocate any memory. Instead each layer is walked twice, once to count its
+// runs and once to write them, with every u32 being passed to the callback.
+
+template<typename T>
+FILDEF void internal__encode_restore_level (const Level& level, Tile_ID* row, T write_u32)
+{
+    write_u32(RESTORE_MAGIC);
+    write_u32(RESTORE_VERSION);
+
+    write_u32(CAST(u32, level.header.version));
+    write_u32(CAST(u32, level.header.width  ));
+    write_u32(CAST(u32, level.header.height ));
+    write_u32(CAST(u32, level.header.layers ));
+
+    for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        const auto& layer = level.data[LEVEL_IO_ORDER[i]];
+
+        u32 run_count = 0;
+        u32 checksum = internal__for_each_tile_run(layer, row, [&run_count](u32 length, Tile_ID id)
+        {
+            ++run_count;
+        });
+
+        write_u32(run_count);
+        write_u32(checksum);
+
+        internal__for_each_tile_run(layer, row, [&write_u32](u32 length, Tile_ID id)
+        {
+            write_u32(length);
+            write_u32(CAST(u32, id));
+        });
+    }
+}
+
+FILDEF bool internal__decode_restore_level (const std::vector<u8>& buffer, size_t cursor, Level& level)
+{
+    u32 magic = 0, version = 0;
+    if (!internal__get_u32(buffer, cursor, magic  ) || magic   != RESTORE_MAGIC  ) return false;
+    if (!internal__get_u32(buffer, cursor, version) || version != RESTORE_VERSION) return false;
+
+    u32 header[4];
+    for (auto& h: header) if (!internal__get_u32(buffer, cursor, h)) return false;
+
+    level.header.version = CAST(s32, header[0]);
+    level.header.width   = CAST(s32, header[1]);
+    level.header.height  = CAST(s32, header[2]);
+    level.header.layers  = CAST(s32, header[3]);
+
+    s32 lw = level.header.width;
+    s32 lh = level.header.height;
+
+    if (lw < MINIMUM_LEVEL_WIDTH || lw > MAXIMUM_LEVEL_WIDTH || lh < MINIMUM_LEVEL_HEIGHT || lh > MAXIMUM_LEVEL_HEIGHT)
+    {
+        return false;
+    }
+
+    size_t layer_size = CAST(size_t, lw) * CAST(size_t, lh);
+    std::vector<Tile_ID> row(lw);
+    for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        auto& layer = level.data[LEVEL_IO_ORDER[i]];
+        resize_tile_layer(layer, lw, lh);
+
+        u32 run_count = 0, checksum = 0;
+        if (!internal__get_u32(buffer, cursor, run_count)) return false;
+        if (!internal__get_u32(buffer, cursor, checksum )) return false;
+
+        // Runs are expanded into a row at a time which is written out once full.
+        size_t pos = 0;
+        for (u32 j=0; j<run_count; ++j)
+        {
+            u32 length = 0, id = 0;
+            if (!internal__get_u32(buffer, cursor, length)) return false;
+            if (!internal__get_u32(buffer, cursor, id    )) return false;
+            if (pos+length > layer_size) return false;
+            while (length)
+            {
+                int x = CAST(int, pos % lw);
+                int count = std::min(CAST(int, length), lw-x);
+                std::fill(row.begin()+x, row.begin()+x+count, CAST(Tile_ID, id));
+                if (x+count == lw) write_tile_row(layer, 0, CAST(int, pos / lw), lw, row.data());
+                pos += count;
+                length -= count;
+            }
+        }
+
+        if (pos != layer_size) return false;
+        if (internal__checksum_layer(layer) != checksum) return false;
+    }
+
+    return true;
+}
+
+// Restore files hold the tab's name so they are only part of the editor build.
+#if !defined(BUILD_HEADLESS)
+
 STDDEF bool load_restore_level (Tab& tab, std::string file_name)
 {
     LOG_DEBUG("Loading Restore Level: %s", file_name.c_str());
@@ -130,7 +499,7 @@ STDDEF bool load_restore_level (Tab& tab, std::string file_name)
     char c = 0;
     do
     {
-        fread(&c, sizeof(char), 1, file);
+        if (fread(&c, sizeof(char), 1, file) != 1) c = 0;
         if (c) { level_name.push_back(c); }
     }
     while (c);
@@ -138,38 +507,842 @@ STDDEF bool load_restore_level (Tab& tab, std::string file_name)
     // Set the name of the level for the tab we are loading into.
     tab.name = level_name;
 
-    internal__load_level(file, tab.level);
+    // Check for the magic number to see if it's the compressed format or not.
+    long level_start = ftell(file);
+    u32 magic = 0;
+    if (fread(&magic, sizeof(u32), 1, file) != 1 || SDL_SwapLE32(magic) != RESTORE_MAGIC)
+    {
+        fseek(file, level_start, SEEK_SET);
+        std::string error;
+        if (!internal__load_level(file, tab.level, error))
+        {
+            show_alert("Error", error, ALERT_TYPE_ERROR, ALERT_BUTTON_OK, "Main");
+            return false;
+        }
+        return true;
+    }
+    fseek(file, level_start, SEEK_SET);
+
+    std::vector<u8> buffer(internal__get_remaining_file_size(file));
+    if (buffer.empty() || fread(&buffer[0], sizeof(u8), buffer.size(), file) != buffer.size())
+    {
+        LOG_ERROR(ERR_MED, "Failed to read restore file '%s'!", file_name.c_str());
+        return false;
+    }
+    if (!internal__decode_restore_level(buffer, 0, tab.level))
+    {
+        LOG_ERROR(ERR_MED, "Restore file '%s' is corrupted!", file_name.c_str());
+        return false;
+    }
+
     return true;
 }
 
-STDDEF bool save_restore_level (const Tab& tab, std::string file_name)
+// Scratch row for dumping restore levels. It is static so that the crash
+// handler never needs to allocate one while it is writing out the tabs.
+GLOBAL Tile_ID restore_level_row[MAXIMUM_LEVEL_WIDTH];
+
+STDDEF bool dump_restore_level (const Tab& tab, Emergency_Writer& writer)
 {
-    LOG_DEBUG("Saving Restore Level: %s", file_name.c_str());
+    if (tab.level.header.width > MAXIMUM_LEVEL_WIDTH) return false;
 
-    FILE* file = fopen(file_name.c_str(), "wb");
+    // Write the name of the level + null-terminator for later restoration.
+    const char* name = tab.name.c_str();
+    emergency_write(writer, name, strlen(name)+1);
+
+    internal__encode_restore_level(tab.level, restore_level_row, [&writer](u32 value)
+    {
+        value = SDL_SwapLE32(value);
+        emergency_write(writer, &value, sizeof(value));
+    });
+
+    return emergency_flush(writer);
+}
+
+#endif // !BUILD_HEADLESS
+
+// Delta backups only store the tiles that have changed since the previous
+// backup of the level. A full keyframe (a normal level file) gets written
+// periodically, or whenever a delta does not make sense, so that rebuilding
+// any single backup only ever requires reading a short chain of files.
+//
+// Delta backup files (.lvd) are laid out as follows (all little-endian):
+//
+//   u32 magic, u32 version, u32 base slot, u32 base checksum, u32 checksum
+//   s32 version/width/height/layers, u32 change count
+//   (for each change) u32 layer << 25 | tile index, s32 tile ID
+//
+// The slots are the N in the <name>.bak<N>.<ext> backup naming scheme.
+
+GLOBAL constexpr u32 DELTA_BACKUP_MAGIC   = 0x544C4454; // "TDLT"
+GLOBAL constexpr u32 DELTA_BACKUP_VERSION = 1;
+
+GLOBAL constexpr int DELTA_BACKUP_KEYFRAME_INTERVAL = 10;
+GLOBAL constexpr int DELTA_BACKUP_MAX_CHAIN         = 64; // Guards against broken/cyclic chains.
+
+GLOBAL constexpr u32 DELTA_BACKUP_INDEX_BITS = 25;
+GLOBAL constexpr u32 DELTA_BACKUP_INDEX_MASK = (1u << DELTA_BACKUP_INDEX_BITS) - 1;
+
+FILDEF u32 internal__checksum_level (const Level& level)
+{
+    u32 hash = FNV_OFFSET_BASIS;
+    for (auto& layer: level.data)
+    {
+        hash = (hash ^ internal__checksum_layer(layer)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+FILDEF bool internal__get_backup_slot (const std::string& file_name, std::string& slot_name, u32& slot)
+{
+    // Strips <name>.bak<N>.<ext> down to <name>.bak<N> and pulls out the N.
+    slot_name = strip_file_ext(file_name);
+    size_t pos = slot_name.rfind(".bak");
+    if (pos == std::string::npos) return false;
+    std::string number(slot_name.substr(pos+strlen(".bak")));
+    if (number.empty() || number.find_first_not_of("0123456789") != std::string::npos) return false;
+    slot = CAST(u32, strtoul(number.c_str(), NULL, 10));
+    return true;
+}
+
+FILDEF std::string internal__get_backup_slot_file (const std::string& slot_name)
+{
+    // A slot only ever holds one of the two, but if a write was interrupted
+    // before the old file could be removed the newer file type is preferred.
+    // We use the error code overloads because this is called on the worker.
+    // NOTE: tools/flattenbackup.py follows the same rule and must be kept in sync!
+    std::string delta_name(slot_name + ".lvd");
+    std::string full_name (slot_name + ".lvl");
+
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(delta_name, error)) return full_name;
+    if (!std::filesystem::is_regular_file(full_name,  error)) return delta_name;
+
+    auto delta_time = std::filesystem::last_write_time(delta_name, error);
+    auto full_time  = std::filesystem::last_write_time(full_name,  error);
+
+    return (delta_time >= full_time) ? delta_name : full_name;
+}
+
+FILDEF bool internal__read_file_buffer (std::string file_name, std::vector<u8>& buffer)
+{
+    FILE* file = fopen(file_name.c_str(), "rb");
+    if (!file) return false;
+    defer { fclose(file); };
+
+    buffer.resize(internal__get_remaining_file_size(file));
+    if (buffer.empty()) return false;
+    return (fread(&buffer[0], sizeof(u8), buffer.size(), file) == buffer.size());
+}
+
+FILDEF bool internal__read_delta_base_slot (std::string file_name, u32& base_slot)
+{
+    FILE* file = fopen(file_name.c_str(), "rb");
+    if (!file) return false;
+    defer { fclose(file); };
+
+    u32 raw[3] = {};
+    if (fread(raw, sizeof(u32), 3, file) != 3) return false;
+    if (SDL_SwapLE32(raw[0]) != DELTA_BACKUP_MAGIC  ) return false;
+    if (SDL_SwapLE32(raw[1]) != DELTA_BACKUP_VERSION) return false;
+
+    base_slot = SDL_SwapLE32(raw[2]);
+    return true;
+}
+
+// Does not report any errors so that it can be used from the save worker.
+STDDEF bool internal__read_level_backup (Level& level, std::string file_name, int depth, int& chain)
+{
+    if (depth >= DELTA_BACKUP_MAX_CHAIN) return false;
+
+    size_t dot = file_name.find_last_of(".");
+    if (dot == std::string::npos || file_name.substr(dot) != ".lvd")
+    {
+        FILE* file = fopen(file_name.c_str(), "rb");
+        if (!file) return false;
+        defer { fclose(file); };
+
+        chain = 0;
+        std::string error;
+        return internal__load_level(file, level, error);
+    }
+
+    std::vector<u8> buffer;
+    if (!internal__read_file_buffer(file_name, buffer)) return false;
+
+    size_t cursor = 0;
+
+    u32 magic, version, base_slot, base_checksum, checksum;
+    if (!internal__get_u32(buffer, cursor, magic  ) || magic   != DELTA_BACKUP_MAGIC  ) return false;
+    if (!internal__get_u32(buffer, cursor, version) || version != DELTA_BACKUP_VERSION) return false;
+    if (!internal__get_u32(buffer, cursor, base_slot    )) return false;
+    if (!internal__get_u32(buffer, cursor, base_checksum)) return false;
+    if (!internal__get_u32(buffer, cursor, checksum     )) return false;
+
+    u32 header[4];
+    for (auto& h: header) if (!internal__get_u32(buffer, cursor, h)) return false;
+
+    std::string slot_name;
+    u32 slot;
+    if (!internal__get_backup_slot(file_name, slot_name, slot)) return false;
+    if (slot == base_slot) return false;
+
+    // Rebuild the backup this delta was taken against and then apply it.
+    std::string base_name(slot_name.substr(0, slot_name.rfind(".bak")) + ".bak" + std::to_string(base_slot));
+    if (!internal__read_level_backup(level, internal__get_backup_slot_file(base_name), depth+1, chain)) return false;
+    if (internal__checksum_level(level) != base_checksum) return false;
+
+    if (level.header.width  != CAST(s32, header[1])) return false;
+    if (level.header.height != CAST(s32, header[2])) return false;
+
+    u32 change_count;
+    if (!internal__get_u32(buffer, cursor, change_count)) return false;
+    for (u32 i=0; i<change_count; ++i)
+    {
+        u32 packed, id;
+        if (!internal__get_u32(buffer, cursor, packed)) return false;
+        if (!internal__get_u32(buffer, cursor, id    )) return false;
+
+        u32 layer = packed >> DELTA_BACKUP_INDEX_BITS;
+        u32 index = packed &  DELTA_BACKUP_INDEX_MASK;
+        if (layer >= LEVEL_LAYER_TOTAL || index >= get_tile_layer_size(level.data[layer])) return false;
+
+        int lw = level.data[layer].width;
+        set_tile(level.data[layer], index % lw, index / lw, CAST(Tile_ID, id));
+    }
+
+    ++chain;
+    return (internal__checksum_level(level) == checksum);
+}
+
+FILDEF bool internal__write_level_delta (const Level& level, const Level& base, u32 base_slot, std::string file_name)
+{
+    std::vector<u8> buffer;
+
+    internal__put_u32(buffer, DELTA_BACKUP_MAGIC);
+    internal__put_u32(buffer, DELTA_BACKUP_VERSION);
+    internal__put_u32(buffer, base_slot);
+    internal__put_u32(buffer, internal__checksum_level(base));
+    internal__put_u32(buffer, internal__checksum_level(level));
+
+    internal__put_u32(buffer, CAST(u32, level.header.version));
+    internal__put_u32(buffer, CAST(u32, level.header.width  ));
+    internal__put_u32(buffer, CAST(u32, level.header.height ));
+    internal__put_u32(buffer, CAST(u32, level.header.layers ));
+
+    size_t count_pos = buffer.size();
+    internal__put_u32(buffer, 0);
+
+    // Chunks that are still shared with the base, or are empty in both, can
+    // be skipped entirely as they cannot contain any of the changed tiles.
+    Tile_ID new_row[TILE_CHUNK_SIZE];
+    Tile_ID old_row[TILE_CHUNK_SIZE];
+
+    u32 change_count = 0;
+    for (u32 i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        const auto& new_layer = level.data[i];
+        const auto& old_layer = base.data[i];
+        for (int cy=0; cy<new_layer.chunks_h; ++cy)
+        {
+            for (int cx=0; cx<new_layer.chunks_w; ++cx)
+            {
+                if (is_tile_chunk_shared(new_layer, old_layer, cx, cy)) continue;
+
+                int x0 = cx << TILE_CHUNK_SHIFT, x1 = std::min(x0+TILE_CHUNK_SIZE, new_layer.width );
+                int y0 = cy << TILE_CHUNK_SHIFT, y1 = std::min(y0+TILE_CHUNK_SIZE, new_layer.height);
+                for (int y=y0; y<y1; ++y)
+                {
+                    read_tile_row(new_layer, x0, y, x1-x0, new_row);
+                    read_tile_row(old_layer, x0, y, x1-x0, old_row);
+                    for (int x=x0; x<x1; ++x)
+                    {
+                        if (new_row[x-x0] != old_row[x-x0])
+                        {
+                            u32 index = CAST(u32, y) * CAST(u32, new_layer.width) + CAST(u32, x);
+                            internal__put_u32(buffer, (i << DELTA_BACKUP_INDEX_BITS) | index);
+                            internal__put_u32(buffer, CAST(u32, new_row[x-x0]));
+                            ++change_count;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    u32 count = SDL_SwapLE32(change_count);
+    memcpy(&buffer[count_pos], &count, sizeof(u32));
+
+    // Like the full backups, the delta replaces the slot only once complete.
+    std::string temp_name(file_name + ".tmp");
+    FILE* file = fopen(temp_name.c_str(), "wb");
+    if (!file) return false;
+    fwrite(&buffer[0], sizeof(u8), buffer.size(), file);
+    bool success = (ferror(file) == 0);
+    if (fclose(file) != 0) success = false;
+
+    std::error_code error;
+    if (success) std::filesystem::rename(temp_name, file_name, error);
+    if (!success || error)
+    {
+        remove(temp_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+STDDEF bool load_level_backup (Level& level, std::string file_name)
+{
+    LOG_DEBUG("Loading Level Backup: %s", file_name.c_str());
+
+    int chain = 0;
+    if (!internal__read_level_backup(level, file_name, 0, chain))
+    {
+        LOG_ERROR(ERR_MED, "Failed to rebuild level backup '%s'!", file_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+STDDEF bool load_level_header (Level_Header& header, std::string file_name)
+{
+    FILE* file = fopen(file_name.c_str(), "rb");
     if (!file)
     {
-        LOG_ERROR(ERR_MED, "Failed to save restore file '%s'!", file_name.c_str());
+        LOG_ERROR(ERR_MIN, "Failed to load level header '%s'!", file_name.c_str());
         return false;
     }
     defer { fclose(file); };
 
-    // Write the name of the level + null-terminator for later restoration.
-    if (tab.name.empty())
+    size_t file_size = internal__get_remaining_file_size(file);
+
+    // Empty files get treated as blank default sized levels by the editor.
+    if (file_size == 0)
+    {
+        header.version = 1;
+        header.width   = CAST(s32, DEFAULT_LEVEL_WIDTH);
+        header.height  = CAST(s32, DEFAULT_LEVEL_HEIGHT);
+        header.layers  = LEVEL_LAYER_TOTAL;
+        return true;
+    }
+
+    s32 raw[4] = {};
+    if (fread(raw, sizeof(s32), 4, file) != 4) return false;
+    internal__decode_level_header(raw, header);
+
+    std::string error;
+    return internal__validate_level_header(header, file_size, error);
+}
+
+STDDEF bool open_mapped_level (Mapped_Level& level, std::string file_name)
+{
+    LOG_DEBUG("Mapping Level: %s", file_name.c_str());
+
+    level = Mapped_Level();
+    if (!map_file(level.file, file_name))
+    {
+        LOG_ERROR(ERR_MIN, "Failed to map level file '%s'!", file_name.c_str());
+        return false;
+    }
+
+    // Empty files get treated as blank default sized levels by the editor.
+    // We just create the blank data up-front as there is nothing to decode.
+    if (level.file.size == 0)
+    {
+        Level blank;
+        create_blank_level(blank);
+        level.header = blank.header;
+        level.data = std::move(blank.data);
+        for (auto& decoded: level.decoded) decoded = true;
+        return true;
+    }
+
+    if (level.file.size < sizeof(Level_Header))
+    {
+        LOG_ERROR(ERR_MIN, "Level file '%s' is too small to be valid!", file_name.c_str());
+        close_mapped_level(level);
+        return false;
+    }
+
+    s32 raw[4];
+    memcpy(raw, level.file.data, sizeof(raw));
+    internal__decode_level_header(raw, level.header);
+
+    std::string error;
+    if (!internal__validate_level_header(level.header, level.file.size, error))
+    {
+        LOG_ERROR(ERR_MIN, "%s (%s)", error.c_str(), file_name.c_str());
+        close_mapped_level(level);
+        return false;
+    }
+
+    // Work out where each layer's big-endian data lives inside of the file.
+    size_t layer_size = CAST(size_t, level.header.width) * CAST(size_t, level.header.height);
+    const u8* cursor = level.file.data + sizeof(Level_Header);
+    for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        level.raw[LEVEL_IO_ORDER[i]] = cursor;
+        cursor += layer_size * sizeof(Tile_ID);
+    }
+
+    return true;
+}
+
+STDDEF void close_mapped_level (Mapped_Level& level)
+{
+    unmap_file(level.file);
+    level.raw.fill(NULL);
+}
+
+STDDEF const Tile_Layer& get_mapped_level_layer (Mapped_Level& level, Level_Layer layer)
+{
+    ASSERT(layer < LEVEL_LAYER_TOTAL);
+
+    if (!level.decoded[layer])
+    {
+        auto& tiles = level.data[layer];
+        if (level.raw[layer])
+        {
+            int lw = level.header.width;
+            int lh = level.header.height;
+
+            resize_tile_layer(tiles, lw, lh);
+
+            std::vector<Tile_ID> buffer(CAST(size_t, lw) * TILE_CHUNK_SIZE);
+            for (int y=0; y<lh; y+=TILE_CHUNK_SIZE)
+            {
+                int rows = std::min(TILE_CHUNK_SIZE, lh-y);
+                size_t count = CAST(size_t, lw) * rows;
+                memcpy(&buffer[0], level.raw[layer] + (CAST(size_t, y) * lw * sizeof(Tile_ID)), count * sizeof(Tile_ID));
+                internal__swap_tile_endianness(&buffer[0], count);
+                write_tile_rect(tiles, 0, y, lw, rows, &buffer[0]);
+            }
+        }
+        level.decoded[layer] = true;
+    }
+
+    return level.data[layer];
+}
+
+STDDEF bool load_mapped_level (Mapped_Level& mapped, Level& level)
+{
+    level.header = mapped.header;
+    for (Level_Layer i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        // Once a layer has been moved out the mapping has to decode it again.
+        get_mapped_level_layer(mapped, i);
+        level.data[i] = std::move(mapped.data[i]);
+        mapped.decoded[i] = false;
+    }
+    return true;
+}
+
+// The save worker needs SDL threads and events so is only part of the editor.
+#if !defined(BUILD_HEADLESS)
+
+// The save worker does not call into the debug/error log systems as they are
+// not safe to use from other threads. Results are handed back to the main
+// thread which is then responsible for reporting any of the failed saves.
+
+struct Level_Save_Job
+{
+    Level level;
+
+    std::string file_name;
+
+    Level_Backup_Plan backup;
+
+    u64 tab_id;
+    u64 hash;
+};
+
+struct Level_Saver
+{
+    SDL_Thread* thread;
+    SDL_mutex*  mutex;
+    SDL_cond*   work;
+    SDL_cond*   done;
+
+    std::deque<Level_Save_Job*> queue;
+    std::vector<Level_Save_Result> results;
+
+    bool busy;
+    bool quit;
+};
+
+GLOBAL Level_Saver level_saver;
+
+STDDEF bool write_level_backup (const Level& level, const Level_Backup_Plan& plan)
+{
+    std::string slot_name;
+    u32 slot;
+    if (!internal__get_backup_slot(plan.slot_name + ".lvl", slot_name, slot)) return false;
+
+    // Any delta that was taken against the backup we are about to overwrite is
+    // flattened into a keyframe first, otherwise its chain would be broken.
+    if (!plan.rebase_name.empty())
+    {
+        std::string rebase_name(internal__get_backup_slot_file(plan.rebase_name));
+        u32 base_slot;
+        if (internal__read_delta_base_slot(rebase_name, base_slot) && base_slot == slot)
+        {
+            Level rebased;
+            int chain = 0;
+            if (internal__read_level_backup(rebased, rebase_name, 0, chain) && internal__write_level_file_atomic(rebased, plan.rebase_name + ".lvl"))
+            {
+                remove(rebase_name.c_str());
+            }
+        }
+    }
+
+    // Only store a delta if the previous backup can be rebuilt, is the same
+    // size, and the chain has not yet reached the point of needing a keyframe.
+    if (plan.delta && !plan.base_name.empty())
+    {
+        std::string base_name(internal__get_backup_slot_file(plan.base_name));
+        std::string base_slot_name;
+        u32 base_slot;
+
+        Level base;
+        int chain = 0;
+
+        if (internal__get_backup_slot(base_name, base_slot_name, base_slot) && base_slot != slot &&
+            internal__read_level_backup(base, base_name, 0, chain) && chain+1 < DELTA_BACKUP_KEYFRAME_INTERVAL &&
+            base.header.width == level.header.width && base.header.height == level.header.height)
+        {
+            if (internal__write_level_delta(level, base, base_slot, slot_name + ".lvd"))
+            {
+                remove((slot_name + ".lvl").c_str());
+                return true;
+            }
+        }
+    }
+
+    if (!internal__write_level_file_atomic(level, slot_name + ".lvl")) return false;
+    remove((slot_name + ".lvd").c_str());
+    return true;
+}
+
+// Jobs without a file name only write the backup, these are the timed backups.
+FILDEF Level_Save_Result internal__do_level_save_job (const Level_Save_Job& job)
+{
+    Level_Save_Result result;
+    result.tab_id      = job.tab_id;
+    result.hash        = job.hash;
+    result.file_name   = job.file_name;
+    result.success     = (job.file_name.empty()) || internal__write_level_file_atomic(job.level, job.file_name);
+    result.backup_name = job.backup.slot_name;
+    result.backed_up   = false;
+
+    // Failing to backup is not considered a failure to save the level.
+    if (result.success && !job.backup.slot_name.empty())
+    {
+        result.backed_up = write_level_backup(job.level, job.backup);
+    }
+
+    return result;
+}
+
+STDDEF int internal__level_saver_thread_main (void* user_data)
+{
+    while (true)
+    {
+        SDL_LockMutex(level_saver.mutex);
+        while (level_saver.queue.empty() && !level_saver.quit)
+        {
+            SDL_CondWait(level_saver.work, level_saver.mutex);
+        }
+        if (level_saver.queue.empty() && level_saver.quit)
+        {
+            SDL_UnlockMutex(level_saver.mutex);
+            break;
+        }
+        Level_Save_Job* job = level_saver.queue.front();
+        level_saver.queue.pop_front();
+        level_saver.busy = true;
+        SDL_UnlockMutex(level_saver.mutex);
+
+        Level_Save_Result result(internal__do_level_save_job(*job));
+        delete job;
+
+        SDL_LockMutex(level_saver.mutex);
+        level_saver.results.push_back(result);
+        level_saver.busy = false;
+        SDL_CondBroadcast(level_saver.done);
+        SDL_UnlockMutex(level_saver.mutex);
+
+        push_editor_event(EDITOR_EVENT_LEVEL_SAVED, NULL, NULL);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+FILDEF bool init_level_saver ()
+{
+    level_saver.busy = false;
+    level_saver.quit = false;
+
+    level_saver.mutex = SDL_CreateMutex();
+    level_saver.work  = SDL_CreateCond();
+    level_saver.done  = SDL_CreateCond();
+
+    if (!level_saver.mutex || !level_saver.work || !level_saver.done)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to create level saver sync objects! (%s)", SDL_GetError());
+        return false;
+    }
+
+    level_saver.thread = SDL_CreateThread(internal__level_saver_thread_main, "SaveLevel", NULL);
+    if (!level_saver.thread)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to create level saver thread! (%s)", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+FILDEF void quit_level_saver ()
+{
+    if (!level_saver.thread) return;
+
+    // Any saves that are still queued get finished before we leave.
+    SDL_LockMutex(level_saver.mutex);
+    level_saver.quit = true;
+    SDL_CondSignal(level_saver.work);
+    SDL_UnlockMutex(level_saver.mutex);
+
+    SDL_WaitThread(level_saver.thread, NULL);
+    level_saver.thread = NULL;
+
+    SDL_DestroyCond(level_saver.done);
+    SDL_DestroyCond(level_saver.work);
+    SDL_DestroyMutex(level_saver.mutex);
+
+    // The results of the last saves can still be collected after this point.
+    level_saver.done  = NULL;
+    level_saver.work  = NULL;
+    level_saver.mutex = NULL;
+}
+
+FILDEF bool internal__queue_level_save_job (const Level& level, std::string file_name, const Level_Backup_Plan& backup, u64 tab_id, u64 hash)
+{
+    // The snapshot shares the level's chunks until either of them is written
+    // to, which is much cheaper than encoding it, so the editor can continue
+    // to edit the level while the worker writes it out.
+    Level_Save_Job* job = new Level_Save_Job;
+    job->level      = level;
+    job->file_name  = file_name;
+    job->backup     = backup;
+    job->tab_id     = tab_id;
+    job->hash       = hash;
+
+    // If the worker could not be started we just save on the calling thread.
+    if (!level_saver.thread)
+    {
+        Level_Save_Result result(internal__do_level_save_job(*job));
+        delete job;
+        level_saver.results.push_back(result);
+        push_editor_event(EDITOR_EVENT_LEVEL_SAVED, NULL, NULL);
+        return result.success;
+    }
+
+    SDL_LockMutex(level_saver.mutex);
+    level_saver.queue.push_back(job);
+    SDL_CondSignal(level_saver.work);
+    SDL_UnlockMutex(level_saver.mutex);
+
+    return true;
+}
+
+STDDEF bool save_level_async (const Level& level, std::string file_name, const Level_Backup_Plan& backup, u64 tab_id, u64 hash)
+{
+    LOG_DEBUG("Saving Level (Async): %s", file_name.c_str());
+    return internal__queue_level_save_job(level, file_name, backup, tab_id, hash);
+}
+
+STDDEF bool backup_level_async (const Level& level, const Level_Backup_Plan& backup, u64 tab_id, u64 hash)
+{
+    LOG_DEBUG("Backing Up Level (Async): %s", backup.slot_name.c_str());
+    return internal__queue_level_save_job(level, "", backup, tab_id, hash);
+}
+
+FILDEF void wait_for_level_saves ()
+{
+    if (!level_saver.thread) return;
+
+    SDL_LockMutex(level_saver.mutex);
+    while (!level_saver.queue.empty() || level_saver.busy)
+    {
+        SDL_CondWait(level_saver.done, level_saver.mutex);
+    }
+    SDL_UnlockMutex(level_saver.mutex);
+}
+
+struct Level_Loader
+{
+    SDL_Thread* thread;
+    SDL_mutex*  mutex;
+    SDL_cond*   work;
+
+    std::deque<std::shared_ptr<Level_Load>> queue;
+    std::shared_ptr<Level_Load> current; // The load being read by the worker.
+
+    bool quit;
+};
+
+GLOBAL Level_Loader level_loader;
+
+FILDEF void internal__read_level_load (Level_Load& load)
+{
+    // Only push an event when the displayed percentage actually changes, so
+    // huge levels don't flood the event queue with thousands of redraws.
+    int percent = 0;
+
+    load.success = internal__read_level(load.level, load.file_name, load.error,
+    [&load, &percent](float progress)
     {
-        char null_terminator = '\0';
-        fwrite(&null_terminator, sizeof(char), 1, file);
+        load.progress.store(progress);
+        if (CAST(int, progress * 100) != percent && !load.cancel.load())
+        {
+            percent = CAST(int, progress * 100);
+            push_editor_event(EDITOR_EVENT_LEVEL_LOADING, NULL, NULL);
+        }
+        return !load.cancel.load();
+    });
+
+    load.complete.store(true);
+
+    // Nothing is waiting on a cancelled load so its result is just dropped.
+    if (!load.cancel.load()) push_editor_event(EDITOR_EVENT_LEVEL_LOADING, NULL, NULL);
+}
+
+STDDEF int internal__level_loader_thread_main (void* user_data)
+{
+    while (true)
+    {
+        SDL_LockMutex(level_loader.mutex);
+        while (level_loader.queue.empty() && !level_loader.quit)
+        {
+            SDL_CondWait(level_loader.work, level_loader.mutex);
+        }
+        if (level_loader.quit)
+        {
+            SDL_UnlockMutex(level_loader.mutex);
+            break;
+        }
+        level_loader.current = std::move(level_loader.queue.front());
+        level_loader.queue.pop_front();
+        SDL_UnlockMutex(level_loader.mutex);
+
+        // Loads that got cancelled whilst they were queued are never read.
+        if (!level_loader.current->cancel.load())
+        {
+            internal__read_level_load(*level_loader.current);
+        }
+
+        SDL_LockMutex(level_loader.mutex);
+        level_loader.current.reset();
+        SDL_UnlockMutex(level_loader.mutex);
     }
-    else
+
+    return EXIT_SUCCESS;
+}
+
+FILDEF bool init_level_loader ()
+{
+    level_loader.quit = false;
+
+    level_loader.mutex = SDL_CreateMutex();
+    level_loader.work  = SDL_CreateCond();
+
+    if (!level_loader.mutex || !level_loader.work)
     {
-        const char* name = tab.name.c_str();
-        fwrite(name, sizeof(char), strlen(name)+1, file);
+        LOG_ERROR(ERR_MIN, "Failed to create level loader sync objects! (%s)", SDL_GetError());
+        return false;
+    }
+
+    level_loader.thread = SDL_CreateThread(internal__level_loader_thread_main, "LoadLevel", NULL);
+    if (!level_loader.thread)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to create level loader thread! (%s)", SDL_GetError());
+        return false;
     }
 
-    internal__save_level(file, tab.level);
     return true;
 }
 
+FILDEF void quit_level_loader ()
+{
+    if (!level_loader.thread) return;
+
+    // Unlike saves any pending loads are no longer needed, so the one being
+    // read is cancelled (which makes it stop early) and the rest are dropped.
+    SDL_LockMutex(level_loader.mutex);
+    level_loader.quit = true;
+    for (auto& load: level_loader.queue) load->cancel.store(true);
+    level_loader.queue.clear();
+    if (level_loader.current) level_loader.current->cancel.store(true);
+    SDL_CondSignal(level_loader.work);
+    SDL_UnlockMutex(level_loader.mutex);
+
+    SDL_WaitThread(level_loader.thread, NULL);
+    level_loader.thread = NULL;
+
+    SDL_DestroyCond(level_loader.work);
+    SDL_DestroyMutex(level_loader.mutex);
+}
+
+STDDEF std::shared_ptr<Level_Load> load_level_async (std::string file_name)
+{
+    LOG_DEBUG("Loading Level (Async): %s", file_name.c_str());
+
+    std::shared_ptr<Level_Load> load = std::make_shared<Level_Load>();
+
+    load->file_name = file_name;
+    load->success   = false;
+
+    load->progress.store(0);
+    load->complete.store(false);
+    load->cancel.store(false);
+
+    // If the worker could not be started we just load on the calling thread.
+    if (!level_loader.thread)
+    {
+        load->success = read_level(load->level, load->file_name, load->error);
+        load->progress.store(1);
+        load->complete.store(true);
+
+        push_editor_event(EDITOR_EVENT_LEVEL_LOADING, NULL, NULL);
+        return load;
+    }
+
+    // The queue holds its own reference to the load so that it stays alive
+    // even if the tab that wanted it gets closed before the load is finished.
+    SDL_LockMutex(level_loader.mutex);
+    level_loader.queue.push_back(load);
+    SDL_CondSignal(level_loader.work);
+    SDL_UnlockMutex(level_loader.mutex);
+
+    return load;
+}
+
+FILDEF void cancel_level_load (Level_Load& load)
+{
+    load.cancel.store(true);
+}
+
+FILDEF std::vector<Level_Save_Result> get_completed_level_saves ()
+{
+    std::vector<Level_Save_Result> results;
+    if (level_saver.mutex) SDL_LockMutex(level_saver.mutex);
+    results.swap(level_saver.results);
+    if (level_saver.mutex) SDL_UnlockMutex(level_saver.mutex);
+    return results;
+}
+
+#endif // !BUILD_HEADLESS
+
 FILDEF bool create_blank_level (Level& level, int w, int h)
 {
     level.header.version = 1;
@@ -180,7 +1353,28 @@ FILDEF bool create_blank_level (Level& level, int w, int h)
     s32 lw = level.header.width;
     s32 lh = level.header.height;
 
-    for (auto& layer: level.data) layer.assign(lw*lh, 0);
+    for (auto& layer: level.data) resize_tile_layer(layer, lw, lh);
 
     return true;
 }
+
+FILDEF u64 get_level_hash (const Level& level)
+{
+    // The layer hashes are combined in order (unlike the tiles within them)
+    // so that moving content between layers still counts as a change.
+    u64 hash = 0xCBF29CE484222325ULL;
+    auto combine = [&](u64 value)
+    {
+        hash = (hash ^ value) * 0x100000001B3ULL;
+        hash ^= hash >> 32;
+    };
+
+    combine(CAST(u32, level.header.version));
+    combine(CAST(u32, level.header.width  ));
+    combine(CAST(u32, level.header.height ));
+    combine(CAST(u32, level.header.layers ));
+
+    for (auto& layer: level.data) combine(get_tile_layer_hash(layer));
+
+    return hash;
+}
@@ -16,7 +16,10 @@ GLOBAL constexpr Level_Layer LEVEL_LAYER_BACK1   = 3;
 GLOBAL constexpr Level_Layer LEVEL_LAYER_BACK2   = 4;
 GLOBAL constexpr Level_Layer LEVEL_LAYER_TOTAL   = 5;
 
-typedef s32 Tile_ID;
+GLOBAL constexpr Tile_ID CAMERA_ID = 20000;
+
+// All of the tiles from this ID up are Entities, the ones below are Basics.
+GLOBAL constexpr Tile_ID ENTITY_ID_START = 40000;
 
 struct Level_Header
 {
@@ -26,7 +29,7 @@ struct Level_Header
     s32 layers;
 };
 
-typedef std::array<std::vector<Tile_ID>, LEVEL_LAYER_TOTAL> Level_Data;
+typedef std::array<Tile_Layer, LEVEL_LAYER_TOTAL> Level_Data;
 
 struct Level
 {
@@ -34,20 +37,154 @@ struct Level
     Level_Data data;
 };
 
+// Saving writes to a temporary file that then replaces the target, so a save
+// that gets interrupted part way never leaves behind a truncated level file.
 STDDEF bool load_level         (      Level& level, std::string file_name);
 STDDEF bool save_level         (const Level& level, std::string file_name);
 
-// A custom file format. Exactly the same as the default level format except
-// the first part of the file until zero is the name of the level. This is
-// done so that the name of the file can also be restored when the editor
-// is loaded again after a fatal failure occurs and restore files are saved.
+// Same as load_level except any problem is passed back rather than reported
+// to the user, so it is also safe to call from other threads than the main.
+STDDEF bool read_level         (      Level& level, std::string file_name, std::string& error);
+
+// Only reads and validates the header, none of the tile data gets touched.
+STDDEF bool load_level_header  (Level_Header& header, std::string file_name);
+
+// A read-only memory mapped view of a level file. The layers are left in their
+// big-endian file form and are only decoded the first time they're requested
+// so systems that are scanning many levels only pay for the data they touch.
+
+struct Mapped_Level
+{
+    Level_Header header;
+    File_Mapping file;
+
+    std::array<const u8*, LEVEL_LAYER_TOTAL> raw;
+    Level_Data data;
+
+    bool decoded[LEVEL_LAYER_TOTAL];
+};
+
+STDDEF bool open_mapped_level  (Mapped_Level& level, std::string file_name);
+STDDEF void close_mapped_level (Mapped_Level& level);
+
+STDDEF const Tile_Layer& get_mapped_level_layer (Mapped_Level& level, Level_Layer layer);
+
+// Moves all of the (decoded) layers out of the mapped level into a level.
+STDDEF bool load_mapped_level  (Mapped_Level& mapped, Level& level);
+
+// Backups can optionally be stored as deltas (.lvd) that only contain the tiles
+// which changed since the previous backup, with a full keyframe written every
+// so often. The plan is worked out by the editor (which knows the settings and
+// existing backups) so the backup itself can be written on the save worker.
+
+struct Level_Backup_Plan
+{
+    // These are all the paths of backup slots, without the file extensions.
+    std::string   slot_name; // The backup to write.
+    std::string   base_name; // The most recent other backup.
+    std::string rebase_name; // The backup that may be a delta of the one being replaced.
+
+    bool delta;
+};
+
+// Rebuilds any backup, following the chain of deltas back to a keyframe.
+STDDEF bool load_level_backup  (Level& level, std::string file_name);
+
+#if !defined(BUILD_HEADLESS)
+
+// Writing backups is part of the save worker so it is only in the editor.
+STDDEF bool write_level_backup (const Level& level, const Level_Backup_Plan& plan);
+
+// Saves can be performed on a background worker so that writing large levels
+// does not stall the editor. A snapshot of the level is taken at the time of
+// the request and it is written to a temporary file that then replaces the
+// target, so a crash mid-write never leaves the user with a truncated level.
+//
+// The tab ID and level hash are passed back with the result so the editor
+// knows which tab and what content the file on disk now matches. Whether the
+// backup was written is also passed back, as the backup manifest is only
+// updated by the main thread once the backup slot has been fully written.
+
+struct Level_Save_Result
+{
+    u64 tab_id;
+    u64 hash;
+
+    std::string file_name;
+    std::string backup_name;
+
+    bool success;
+    bool backed_up;
+};
+
+FILDEF bool init_level_saver ();
+FILDEF void quit_level_saver ();
+
+STDDEF bool save_level_async (const Level& level, std::string file_name, const Level_Backup_Plan& backup, u64 tab_id, u64 hash);
+
+// Queues just a backup of the level (e.g. the timed backups). It goes through
+// the same worker as the saves so that every backup is written by the one
+// thread, in the order they were planned. The result has no file name.
+STDDEF bool backup_level_async (const Level& level, const Level_Backup_Plan& backup, u64 tab_id, u64 hash);
+
+FILDEF void wait_for_level_saves ();
+
+FILDEF std::vector<Level_Save_Result> get_completed_level_saves ();
+
+// Loads can also be performed on a background worker so that opening large
+// levels does not stall the editor. Loads are queued for a single worker that
+// reads and decodes each level a band of rows at a time, updating progress
+// and checking for a cancel as it goes. The level is only handed over to the
+// editor once the load is complete, so a tab never sees a partial level.
+//
+// Loads that are cancelled (e.g. their tab was closed) are dropped by the
+// worker without ever posting an event, and any that are still pending when
+// the loader is shut down are cancelled, as the worker is joined on quit.
+
+struct Level_Load
+{
+    std::string file_name;
+
+    Level level;       // Only safe to access once the load is complete.
+    std::string error; // Why the load failed, empty if it was cancelled.
+
+    std::atomic<float> progress; // From zero to one.
+    std::atomic<bool>  complete;
+    std::atomic<bool>  cancel;
+
+    bool success;
+};
+
+FILDEF bool init_level_loader ();
+FILDEF void quit_level_loader ();
+
+STDDEF std::shared_ptr<Level_Load> load_level_async (std::string file_name);
+
+FILDEF void cancel_level_load (Level_Load& load);
+
+// A custom file format. The first part of the file until zero is the name of
+// the level. This is done so that the name of the file can also be restored
+// when the editor is loaded again after a fatal failure occurs and restore
+// files are saved. The level data after the name is run-length compressed
+// and checksummed (see <level.cpp> for details), though older uncompressed
+// restore files are also still understood by the loader.
+//
+// Restore files are only ever saved from the crash path so they are dumped
+// through an emergency writer, which does not allocate (see <emergency.hpp>).
 
 struct Tab; // Defined in <editor.hpp>
 
 STDDEF bool load_restore_level (      Tab&   tab,   std::string file_name);
-STDDEF bool save_restore_level (const Tab&   tab,   std::string file_name);
+STDDEF bool dump_restore_level (const Tab&   tab,   Emergency_Writer& writer);
+
+#endif // !BUILD_HEADLESS
 
 
 
 FILDEF bool create_blank_level (Level& level, int w = DEFAULT_LEVEL_WIDTH,
                                               int h = DEFAULT_LEVEL_HEIGHT);
+
+// A hash of everything that gets written to a level file, so the editor can
+// tell whether a level really differs from when it was last saved/backed up.
+// This is cheap to call every frame as each layer keeps its hash up to date.
+FILDEF u64 get_level_hash (const Level& level);
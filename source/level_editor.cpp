@@ -1,5 +1,4 @@
-GLOBAL constexpr float   GHOSTED_CURSOR_ALPHA =   .5f;
-GLOBAL constexpr Tile_ID CAMERA_ID            = 20000;
+GLOBAL constexpr float GHOSTED_CURSOR_ALPHA = .5f;
 
 FILDEF quad& internal__get_tile_graphic_clip (Texture_Atlas& atlas, Tile_ID id)
 {
@@ -22,7 +21,7 @@ FILDEF bool internal__are_active_layers_in_bounds_empty (int x, int y, int w, in
             {
                 for (int ix=x; ix<(x+w); ++ix)
                 {
-                    Tile_ID id = tile_layer.at(iy*tab.level.header.width+ix);
+                    Tile_ID id = get_tile(tile_layer, ix, iy);
                     if (id != 0) return false;
                 }
             }
@@ -37,36 +36,281 @@ FILDEF Level_History_State& internal__get_current_history_state ()
     return tab.level_history.state[tab.level_history.current_position];
 }
 
-FILDEF bool internal__tile_in_bounds (int x, int y)
+FILDEF Level_History_Extra& internal__get_history_extra (Level_History_State& state)
 {
-    const Tab& tab = get_current_tab();
+    if (!state.extra) state.extra = std::make_shared<Level_History_Extra>();
+    return *state.extra;
+}
 
-    int w = tab.level.header.width;
-    int h = tab.level.header.height;
+FILDEF bool internal__is_history_state_empty (const Level_History_State& state)
+{
+    return (state.info.empty() && state.runs.empty());
+}
 
-    return (x >= 0 && x < w && y >= 0 && y < h);
+FILDEF size_t internal__get_history_state_memory (const Level_History_State& state)
+{
+    size_t memory = sizeof(Level_History_State);
+
+    memory += state.info.capacity() * sizeof(Level_History_Info);
+    memory += state.runs.capacity() * sizeof(Level_History_Run);
+
+    // Each entry in the index is a separately allocated node plus a bucket.
+    memory += state.info_index.size() * (sizeof(std::pair<u64, size_t>) + (sizeof(void*) * 2));
+    memory += state.info_index.bucket_count() * sizeof(void*);
+
+    if (state.extra)
+    {
+        const Level_History_Extra& extra = *state.extra;
+
+        memory += sizeof(Level_History_Extra);
+        memory += extra.old_select_state.capacity() * sizeof(Select_Bounds);
+        memory += extra.new_select_state.capacity() * sizeof(Select_Bounds);
+
+        // A merge only changes some chunks of the level, the rest are shared
+        // between the old and new data (and the level) so aren't counted. The
+        // changed chunks are counted on both sides, even though the new ones
+        // are usually still shared with the level, so it errs on the high side.
+        for (Level_Layer i=0; i<LEVEL_LAYER_TOTAL; ++i)
+        {
+            memory += get_tile_layer_memory(extra.old_data[i], &extra.new_data[i]);
+            memory += get_tile_layer_memory(extra.new_data[i], &extra.old_data[i]);
+        }
+
+        for (auto& crop: extra.cropped)
+        {
+            memory += sizeof(Level_History_Crop);
+            for (auto& layer: crop.data) memory += get_tile_layer_memory(layer);
+        }
+    }
+
+    return memory;
 }
 
-FILDEF void internal__place_tile_clear (int x, int y, Tile_ID id, Level_Layer tile_layer)
+// Packs a finished state and works out how much memory it takes up from then on.
+FILDEF void internal__pack_history_state (Level_History_State& state)
 {
-    Tab& tab = get_current_tab();
+    pack_level_history_state(state);
+    state.memory = internal__get_history_state_memory(state);
+}
 
-    if (!tab.tile_layer_active[tile_layer]) return;
-    if (!internal__tile_in_bounds(x, y))    return;
+// Drops the oldest states until the history fits within the memory limit. The
+// current state is always kept, so the last action can at least be undone.
 
-    auto& layer = tab.level.data[tile_layer];
+FILDEF void internal__limit_level_history_memory (Tab& tab)
+{
+    if (editor_settings.history_memory <= 0) return;
 
-    Level_History_Info info = {};
-    info.x                  = x;
-    info.y                  = y;
-    info.old_id             = layer[y * tab.level.header.width + x];
-    info.new_id             = id;
-    info.tile_layer         = tile_layer;
-    add_to_history_clear_state(info);
+    size_t limit = CAST(size_t, editor_settings.history_memory) * 1024 * 1024;
+    size_t memory = get_level_history_memory(tab);
+
+    int evict = 0;
+    while (memory > limit && evict < tab.level_history.current_position)
+    {
+        memory -= tab.level_history.state[evict].memory;
+        ++evict;
+    }
+
+    if (evict > 0)
+    {
+        auto begin = tab.level_history.state.begin();
+        tab.level_history.state.erase(begin, begin+evict);
+        tab.level_history.current_position -= evict;
+
+        LOG_DEBUG("Dropped %d history states to stay under %d MB", evict, editor_settings.history_memory);
+    }
+}
+
+FILDEF void internal__set_level_tab_saved (Tab& tab)
+{
+    // The level matches the file on disk so there's no need to back it up yet
+    // and the folder's index can pick up the new version of the file.
+    tab.saved_hash      = get_level_hash(tab.level);
+    tab.backup_hash     = tab.saved_hash;
+    tab.unsaved_changes = false;
+
+    update_level_index(tab.name);
+}
+
+FILDEF void internal__begin_level_tab_load (Tab& tab)
+{
+    // The tab shows the load's progress until the level has been swapped in
+    // by handle_completed_level_loads. Any load it already had gets dropped.
+    if (tab.level_load) cancel_level_load(*tab.level_load);
+    tab.level_load = load_level_async(tab.name);
+}
+
+FILDEF void internal__do_level_loading (const Tab& tab)
+{
+    // Drawn in the same style as the GPAK progress windows (see <gpak.cpp>).
+    constexpr float PANEL_W = 320;
+    constexpr float XPAD    =   8;
+    constexpr float YPAD    =   4;
+    constexpr float LABEL_H =  24;
+    constexpr float BAR_H   =  20;
+    constexpr float BTN_H   =  24;
+
+    float vw = get_viewport().w;
+    float vh = get_viewport().h;
+
+    quad p1;
+
+    p1.w = std::min(PANEL_W, vw);
+    p1.h = (YPAD*2) + LABEL_H + (YPAD*2) + BAR_H + (YPAD*3) + BTN_H + (YPAD*2);
+    p1.x = roundf((vw - p1.w) / 2);
+    p1.y = roundf((vh - p1.h) / 2);
+
+    set_ui_font(&get_editor_regular_font());
+
+    begin_panel(p1, UI_NONE, ui_color_ex_dark);
+    begin_panel(1, 1, p1.w-2, p1.h-2, UI_NONE, ui_color_medium);
+
+    vec2 cursor(XPAD, YPAD*2);
+
+    set_panel_cursor_dir(UI_DIR_DOWN);
+    set_panel_cursor(&cursor);
+
+    std::string label(format_string("Loading %s...", strip_file_path(tab.name).c_str()));
+    do_label(UI_ALIGN_LEFT,UI_ALIGN_CENTER, p1.w-2-(XPAD*2), LABEL_H, label);
+
+    cursor.y += (YPAD*2);
+
+    float total_width = p1.w - 2 - (XPAD*2);
+    float current_width = total_width * tab.level_load->progress.load();
+
+    float x1 = cursor.x;
+    float y1 = cursor.y;
+    float x2 = cursor.x + current_width;
+    float y2 = cursor.y + BAR_H;
+
+    set_draw_color(ui_color_light);
+    fill_quad(x1-2, y1-2, cursor.x+total_width+2, y2+2);
+    set_draw_color(ui_color_ex_dark);
+    fill_quad(x1-1, y1-1, cursor.x+total_width+1, y2+1);
+
+    begin_draw(Buffer_Mode::TRIANGLE_STRIP);
+    put_vertex(x1, y2, GPAK_PROGRESS_BAR_MIN_COLOR); // BL
+    put_vertex(x1, y1, GPAK_PROGRESS_BAR_MIN_COLOR); // TL
+    put_vertex(x2, y2, GPAK_PROGRESS_BAR_MAX_COLOR); // BR
+    put_vertex(x2, y1, GPAK_PROGRESS_BAR_MAX_COLOR); // TR
+    end_draw();
+
+    cursor.y = y2 + (YPAD*3);
+
+    // Cancelling just closes the tab, which stops the worker from going on.
+    if (do_button_txt(NULL, total_width, BTN_H, UI_NONE, "Cancel"))
+    {
+        cancel_level_tab_load();
+    }
+
+    end_panel();
+    end_panel();
+}
+
+FILDEF void internal__update_level_unsaved_changes (Tab& tab)
+{
+    // This means undoing back to the saved state clears the unsaved marker.
+    tab.unsaved_changes = (get_level_hash(tab.level) != tab.saved_hash);
+}
+
+FILDEF void internal__new_level_history_state (Tab& tab, Level_History_Action action)
+{
+    // Don't bother creating a new state if the current erase/place action is
+    // empty otherwise we will end up with a bunch of empty states in the list.
+    if (tab.level_history.current_position > -1)
+    {
+        Level_History_State& current = tab.level_history.state[tab.level_history.current_position];
+        if (internal__is_history_state_empty(current) && current.action == action && action == Level_History_Action::NORMAL)
+        {
+            return;
+        }
+    }
+
+    // Clear all the history after the current position, if there is any, as it
+    // will no longer apply to the timeline of level editor actions anymore.
+    int delete_position = tab.level_history.current_position+1;
+    if (delete_position < CAST(int, tab.level_history.state.size()))
+    {
+        auto begin = tab.level_history.state.begin();
+        auto end = tab.level_history.state.end();
+
+        tab.level_history.state.erase(begin+delete_position, end);
+    }
+
+    // If it's a selection action then we don't need to modify this.
+    if (action != Level_History_Action::SELECT_STATE)
+    {
+        tab.unsaved_changes = true;
+    }
+
+    // The previous state is done with now so it can be packed down, and then
+    // we make sure the history as a whole still fits in the memory limit.
+    if (tab.level_history.current_position > -1)
+    {
+        internal__pack_history_state(tab.level_history.state[tab.level_history.current_position]);
+        internal__limit_level_history_memory(tab);
+    }
+
+    tab.level_history.state.push_back(Level_History_State());
+    tab.level_history.state.back().action = action;
 
-    layer[y * tab.level.header.width + x] = id;
+    if (action != Level_History_Action::NORMAL)
+    {
+        Level_History_Extra& extra = internal__get_history_extra(tab.level_history.state.back());
+
+        // Also deal with the layer states for flip actions.
+        if (action == Level_History_Action::FLIP_LEVEL_H || action == Level_History_Action::FLIP_LEVEL_V)
+        {
+            for (Level_Layer i=LEVEL_LAYER_TAG; i<LEVEL_LAYER_TOTAL; ++i)
+            {
+                extra.tile_layer_active[i] = tab.tile_layer_active[i];
+            }
+        }
+
+        // Also deal with the select bounds for selection actions.
+        if (action == Level_History_Action::SELECT_STATE || action == Level_History_Action::MERGE)
+        {
+            extra.old_select_state = tab.old_select_state;
+            extra.new_select_state = tab.tool_info.select.bounds;
+        }
+
+        // Also deal with width and height for resizing.
+        if (action == Level_History_Action::RESIZE)
+        {
+            extra.resize_dir = get_resize_dir();
+            extra.old_width  = tab.level.header.width;
+            extra.old_height = tab.level.header.height;
+            extra.new_width  = get_resize_w();
+            extra.new_height = get_resize_h();
+        }
+    }
+
+    ++tab.level_history.current_position;
+}
+
+// Adds a normal state holding all of the changes to any tab's history, not
+// just the current one's, for tools that are able to edit other open tabs.
+
+FILDEF void internal__add_level_history_state (Tab& tab, std::vector<Level_History_Info>& info, u64 group)
+{
+    internal__new_level_history_state(tab, Level_History_Action::NORMAL);
+
+    Level_History_State& state = tab.level_history.state[tab.level_history.current_position];
+    state.info.swap(info);
+    state.group = group;
+
+    // The state is already complete so it can be packed straight away.
+    internal__pack_history_state(state);
+    internal__limit_level_history_memory(tab);
+}
+
+FILDEF bool internal__tile_in_bounds (int x, int y)
+{
+    const Tab& tab = get_current_tab();
+
+    int w = tab.level.header.width;
+    int h = tab.level.header.height;
 
-    get_current_tab().unsaved_changes = true;
+    return (x >= 0 && x < w && y >= 0 && y < h);
 }
 
 FILDEF void internal__place_tile (int x, int y, Tile_ID id, Level_Layer tile_layer)
@@ -81,17 +325,17 @@ FILDEF void internal__place_tile (int x, int y, Tile_ID id, Level_Layer tile_lay
     Level_History_Info info = {};
     info.x                  = x;
     info.y                  = y;
-    info.old_id             = layer[y * tab.level.header.width + x];
+    info.old_id             = get_tile(layer, x, y);
     info.new_id             = id;
     info.tile_layer         = tile_layer;
     add_to_history_normal_state(info);
 
-    layer[y * tab.level.header.width + x] = id;
+    set_tile(layer, x, y, id);
 
-    get_current_tab().unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
-FILDEF void internal__place_mirrored_tile_clear (int x, int y, Tile_ID id, Level_Layer tile_layer)
+FILDEF void internal__place_mirrored_tile (int x, int y, Tile_ID id, Level_Layer tile_layer)
 {
     bool both = (level_editor.mirror_h && level_editor.mirror_v);
 
@@ -100,13 +344,90 @@ FILDEF void internal__place_mirrored_tile_clear (int x, int y, Tile_ID id, Level
     int lw = tab.level.header.width-1;
     int lh = tab.level.header.height-1;
 
-                               internal__place_tile_clear(   x,    y,                                                 id  , tile_layer);
-    if (level_editor.mirror_h) internal__place_tile_clear(lw-x,    y, get_tile_horizontal_flip                       (id) , tile_layer);
-    if (level_editor.mirror_v) internal__place_tile_clear(   x, lh-y,                          get_tile_vertical_flip(id) , tile_layer);
-    if (both)                  internal__place_tile_clear(lw-x, lh-y, get_tile_horizontal_flip(get_tile_vertical_flip(id)), tile_layer);
+                               internal__place_tile(   x,    y,                                                 id  , tile_layer);
+    if (level_editor.mirror_h) internal__place_tile(lw-x,    y, get_tile_horizontal_flip                       (id) , tile_layer);
+    if (level_editor.mirror_v) internal__place_tile(   x, lh-y,                          get_tile_vertical_flip(id) , tile_layer);
+    if (both)                  internal__place_tile(lw-x, lh-y, get_tile_horizontal_flip(get_tile_vertical_flip(id)), tile_layer);
 }
 
-FILDEF void internal__place_mirrored_tile (int x, int y, Tile_ID id, Level_Layer tile_layer)
+// Writes a w*h block of tiles into the layer at x,y, with the tiles for each row
+// of the block given by the callback. The block is clipped to the level once
+// up front and then written a whole row at a time, with a history run being
+// added for each run of tiles on a row that changed to the same thing. Every
+// tile of the row is written unless the callback clears its entry in the mask
+// (which starts out all set), so masked blits can be done without having to
+// reserve a tile ID to mean "skip". The callback is of the following form:
+//
+//   void get_row (int row, Tile_ID* tiles, u8* mask);
+
+template<typename T>
+FILDEF void internal__write_tile_block (Level_Layer tile_layer, int x, int y, int w, int h, T get_row, std::vector<Level_History_Run>& history)
+{
+    Tab& tab = get_current_tab();
+
+    if (!tab.tile_layer_active[tile_layer]) return;
+
+    int x0 = std::max(x, 0), x1 = std::min(x+w, tab.level.header.width);
+    int y0 = std::max(y, 0), y1 = std::min(y+h, tab.level.header.height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    auto& layer = tab.level.data[tile_layer];
+
+    int cw = x1-x0;
+
+    std::vector<Tile_ID> block_row(w);
+    std::vector<u8>      block_mask(w);
+    std::vector<Tile_ID> old_row(cw);
+    std::vector<Tile_ID> new_row(cw);
+
+    for (int iy=y0; iy<y1; ++iy)
+    {
+        std::fill(block_mask.begin(), block_mask.end(), 1);
+        get_row(iy-y, &block_row[0], &block_mask[0]);
+        read_tile_row(layer, x0, iy, cw, &old_row[0]);
+
+        const Tile_ID* tiles = &block_row [x0-x];
+        const u8*      mask  = &block_mask[x0-x];
+        for (int i=0; i<cw; ++i)
+        {
+            new_row[i] = (mask[i]) ? tiles[i] : old_row[i];
+        }
+
+        bool changed = false;
+        for (int i=0; i<cw;)
+        {
+            if (old_row[i] == new_row[i]) { ++i; continue; }
+
+            int j = i+1;
+            while (j < cw && old_row[j] == old_row[i] && new_row[j] == new_row[i]) ++j;
+
+            Level_History_Run run;
+            run.x          = CAST(u16, x0+i);
+            run.y          = CAST(u16, iy);
+            run.length     = CAST(u16, j-i);
+            run.tile_layer = CAST(u16, tile_layer);
+            run.old_id     = old_row[i];
+            run.new_id     = new_row[i];
+            history.push_back(run);
+
+            changed = true;
+            i = j;
+        }
+
+        if (changed) write_tile_row(layer, x0, iy, cw, &new_row[0]);
+    }
+}
+
+// Flips the IDs of a row of tiles.
+FILDEF void internal__flip_tile_row (Tile_ID* tiles, int count, bool h, bool v)
+{
+    if (v) remap_tiles(tiles, count, get_tile_vertical_flip_table  ());
+    if (h) remap_tiles(tiles, count, get_tile_horizontal_flip_table());
+}
+
+// The mirrored copies of the block are written as up to three more blocks.
+template<typename T>
+FILDEF void internal__write_mirrored_tile_block (Level_Layer tile_layer, int x, int y, int w, int h, T get_row, std::vector<Level_History_Run>& history)
 {
     bool both = (level_editor.mirror_h && level_editor.mirror_v);
 
@@ -115,10 +436,30 @@ FILDEF void internal__place_mirrored_tile (int x, int y, Tile_ID id, Level_Layer
     int lw = tab.level.header.width-1;
     int lh = tab.level.header.height-1;
 
-                               internal__place_tile(   x,    y,                                                 id  , tile_layer);
-    if (level_editor.mirror_h) internal__place_tile(lw-x,    y, get_tile_horizontal_flip                       (id) , tile_layer);
-    if (level_editor.mirror_v) internal__place_tile(   x, lh-y,                          get_tile_vertical_flip(id) , tile_layer);
-    if (both)                  internal__place_tile(lw-x, lh-y, get_tile_horizontal_flip(get_tile_vertical_flip(id)), tile_layer);
+    auto get_row_h = [&](int row, Tile_ID* tiles, u8* mask)
+    {
+        get_row(row, tiles, mask);
+        reverse_tiles(tiles, w);
+        std::reverse(mask, mask+w);
+        internal__flip_tile_row(tiles, w, true, false);
+    };
+    auto get_row_v = [&](int row, Tile_ID* tiles, u8* mask)
+    {
+        get_row((h-1)-row, tiles, mask);
+        internal__flip_tile_row(tiles, w, false, true);
+    };
+    auto get_row_hv = [&](int row, Tile_ID* tiles, u8* mask)
+    {
+        get_row((h-1)-row, tiles, mask);
+        reverse_tiles(tiles, w);
+        std::reverse(mask, mask+w);
+        internal__flip_tile_row(tiles, w, true, true);
+    };
+
+                               internal__write_tile_block(tile_layer,          x,          y, w, h, get_row,    history);
+    if (level_editor.mirror_h) internal__write_tile_block(tile_layer, lw-(x+w-1),          y, w, h, get_row_h,  history);
+    if (level_editor.mirror_v) internal__write_tile_block(tile_layer,          x, lh-(y+h-1), w, h, get_row_v,  history);
+    if (both)                  internal__write_tile_block(tile_layer, lw-(x+w-1), lh-(y+h-1), w, h, get_row_hv, history);
 }
 
 FILDEF bool internal__clipboard_empty ()
@@ -127,7 +468,7 @@ FILDEF bool internal__clipboard_empty ()
     {
         for (auto& layer: clipboard.data)
         {
-            if (!layer.empty()) return false;
+            if (get_tile_layer_size(layer) != 0) return false;
         }
     }
     return true;
@@ -163,7 +504,7 @@ FILDEF void internal__copy ()
                 int h = (t-b)+1;
 
                 // Resize the clipboard tile buffer to be the new selection box size.
-                for (auto& layer: clipboard.data) layer.assign(w*h, 0);
+                for (auto& layer: clipboard.data) resize_tile_layer(layer, w, h);
 
                 // Important to cache so we can use during paste.
                 clipboard.x = l - sl;
@@ -172,6 +513,7 @@ FILDEF void internal__copy ()
                 clipboard.h = h;
 
                 // Copy the selected tiles into the buffer.
+                std::vector<Tile_ID> row(w);
                 for (size_t i=0; i<clipboard.data.size(); ++i)
                 {
                     if (!tab.tile_layer_active[i]) continue;
@@ -180,10 +522,8 @@ FILDEF void internal__copy ()
                     auto& dst_layer = clipboard.data[i];
                     for (int y=b; y<=t; ++y)
                     {
-                        for (int x=l; x<=r; ++x)
-                        {
-                            dst_layer[(y-b) * w + (x-l)] = src_layer[y * tab.level.header.width + x];
-                        }
+                        read_tile_row (src_layer, l, y,   w, row.data());
+                        write_tile_row(dst_layer, 0, y-b, w, row.data());
                     }
                 }
             }
@@ -220,126 +560,217 @@ FILDEF Tile_ID internal__get_fill_find_id (int x, int y, Level_Layer layer)
 {
     if (!internal__tile_in_bounds(x, y)) return 0;
     const auto& tab = get_current_tab();
-    return tab.level.data[layer][y * tab.level.header.width + x];
+    return get_tile(tab.level.data[layer], x, y);
 }
 
-FILDEF bool internal__inside_select_bounds (int x, int y)
+FILDEF void internal__fill_span (Tile_Layer& layer, Level_Layer tile_layer, const Tile_Span& span, Tile_ID id,
+                                 std::vector<Tile_ID>& tiles, std::vector<Level_History_Info>& history)
 {
-    if (!are_there_any_tabs()) return false;
-
-    const Tab& tab = get_current_tab();
-    for (auto& bounds: tab.tool_info.select.bounds)
+    tiles.resize(span.w);
+    read_tile_row(layer, span.x, span.y, span.w, &tiles[0]);
+    for (int i=0; i<span.w; ++i)
     {
-        if (bounds.visible)
-        {
-            int sl,st,sr,sb; get_ordered_select_bounds(bounds, &sl,&st,&sr,&sb);
-            if (x >= sl && x <= sr && y >= sb && y <= st) return true;
-        }
-    }
-    return false;
-}
+        if (tiles[i] == id) continue;
 
-FILDEF void internal__check_fill_neighbour (int x, int y)
-{
-    Tab& tab = get_current_tab();
-
-    // If the select box is visible then check if we should be filling inside
-    // or outside of the select box bounds. Based on that case we discard any
-    // tiles/spawns that do not fit in the bounds we are to be filling within.
-    if (are_any_select_boxes_visible())
-    {
-        if (tab.tool_info.fill.inside_select)
-        {
-            if (!internal__inside_select_bounds(x, y)) return;
-        }
-        else
-        {
-            if (internal__inside_select_bounds(x, y)) return;
-        }
-    }
-
-    // If we have already visited this space then we don't need to again.
-    size_t index = y * tab.level.header.width + x;
-    if (tab.tool_info.fill.searched.at(index)) return;
+        Level_History_Info info = {};
+        info.x                  = span.x+i;
+        info.y                  = span.y;
+        info.old_id             = tiles[i];
+        info.new_id             = id;
+        info.tile_layer         = tile_layer;
+        history.push_back(info);
 
-    if (internal__get_fill_find_id(x, y, tab.tool_info.fill.layer) == tab.tool_info.fill.find_id)
-    {
-        internal__place_mirrored_tile(x, y, tab.tool_info.fill.replace_id, tab.tool_info.fill.layer);
-        tab.tool_info.fill.frontier.push_back({ CAST(float, x), CAST(float, y) });
+        tiles[i] = id;
     }
-
-    tab.tool_info.fill.searched.at(index) = true; // Mark as searched!
+    write_tile_row(layer, span.x, span.y, span.w, &tiles[0]);
 }
 
 FILDEF void internal__fill ()
 {
     Tab& tab = get_current_tab();
 
-    int w = tab.level.header.width;
-    int h = tab.level.header.height;
+    Level_Layer tile_layer = tab.tool_info.fill.layer;
+    if (!tab.tile_layer_active[tile_layer]) return;
+
+    auto& layer = tab.level.data[tile_layer];
 
-    tab.tool_info.fill.searched.resize(w*h, false);
+    const Select_Mask& select_mask = get_select_mask();
+    bool any_selected = (select_mask.w > 0);
 
     int start_x = CAST(int, tab.tool_info.fill.start.x);
     int start_y = CAST(int, tab.tool_info.fill.start.y);
 
-    // Start tile marked searched as we can just replace it now.
-    internal__place_mirrored_tile(start_x, start_y, tab.tool_info.fill.replace_id, tab.tool_info.fill.layer);
+    // The whole region is found before anything is placed, so the mirrored
+    // copies of the fill can't cut it short by being placed inside it first.
+    std::vector<Tile_Span> spans;
+    get_tile_fill_spans(layer, start_x, start_y, [&](int x, int y)
+    {
+        // If the select box is visible then check if we should be filling inside
+        // or outside of the select box bounds. Based on that case we discard any
+        // tiles/spawns that do not fit in the bounds we are to be filling within.
+        if (!any_selected) return true;
+        return (is_tile_selected(select_mask, x, y) == tab.tool_info.fill.inside_select);
+    },
+    spans);
 
-    tab.tool_info.fill.searched.at(start_y * w + start_x) = true;
-    tab.tool_info.fill.frontier.push_back(tab.tool_info.fill.start);
+    bool both = (level_editor.mirror_h && level_editor.mirror_v);
 
-    // Once the frontier is empty this means all tiles within the potentially
-    // enclosed space have been filled and there is no where else to expand
-    // to within the level. Meaning that the fill is complete and we can leave.
-    while (tab.tool_info.fill.frontier.size() > 0)
+    int lw = tab.level.header.width-1;
+    int lh = tab.level.header.height-1;
+
+    Tile_ID id    = tab.tool_info.fill.replace_id;
+    Tile_ID id_h  = get_tile_horizontal_flip(id);
+    Tile_ID id_v  = get_tile_vertical_flip(id);
+    Tile_ID id_hv = get_tile_horizontal_flip(get_tile_vertical_flip(id));
+
+    std::vector<Tile_ID> tiles;
+    std::vector<Level_History_Info> history;
+
+    for (auto& span: spans)
     {
-        vec2 temp = tab.tool_info.fill.frontier.at(0);
+        Tile_Span span_h  = { lw-(span.x+span.w-1),    span.y, span.w };
+        Tile_Span span_v  = { span.x,               lh-span.y, span.w };
+        Tile_Span span_hv = { span_h.x,             lh-span.y, span.w };
 
-        int cx = CAST(int, temp.x);
-        int cy = CAST(int, temp.y);
+                                   internal__fill_span(layer, tile_layer, span,    id,    tiles, history);
+        if (level_editor.mirror_h) internal__fill_span(layer, tile_layer, span_h,  id_h,  tiles, history);
+        if (level_editor.mirror_v) internal__fill_span(layer, tile_layer, span_v,  id_v,  tiles, history);
+        if (both)                  internal__fill_span(layer, tile_layer, span_hv, id_hv, tiles, history);
+    }
 
-        tab.tool_info.fill.frontier.erase(tab.tool_info.fill.frontier.begin());
+    if (history.empty()) return;
 
-        // Check the neighbors, but don't try to access outside level bounds.
-        if (cy > 0)     internal__check_fill_neighbour(cx,   cy-1);
-        if (cx < (w-1)) internal__check_fill_neighbour(cx+1, cy  );
-        if (cy < (h-1)) internal__check_fill_neighbour(cx,   cy+1);
-        if (cx > 0)     internal__check_fill_neighbour(cx-1, cy  );
+    add_to_history_normal_state(history);
+    level_has_unsaved_changes();
+}
+
+// Appends the parts of the span that are inside (or outside) of the selected
+// spans on its row. The mask's spans are sorted so a single pass is enough.
+
+FILDEF void internal__clip_span_to_selection (const Tile_Span& span, const Select_Mask& mask, bool inside, std::vector<Tile_Span>& pieces)
+{
+    size_t first = 0, last = 0;
+    int row = span.y - mask.y;
+    if (row >= 0 && row < mask.h)
+    {
+        first = mask.rows[row];
+        last  = mask.rows[row+1];
+    }
+
+    int x   = span.x;
+    int end = span.x+span.w;
+
+    for (size_t i=first; i<last && x<end; ++i)
+    {
+        const Tile_Span& selected = mask.spans[i];
+        int l = std::max(x,   selected.x);
+        int r = std::min(end, selected.x+selected.w);
+        if (inside)
+        {
+            if (l < r) pieces.push_back({ l, span.y, r-l });
+        }
+        else
+        {
+            int gap_end = std::min(end, selected.x);
+            if (x < gap_end) pieces.push_back({ x, span.y, gap_end-x });
+            x = std::max(x, selected.x+selected.w);
+        }
     }
 
-    tab.tool_info.fill.searched.clear();
-    tab.tool_info.fill.frontier.clear();
+    if (!inside && x < end) pieces.push_back({ x, span.y, end-x });
 }
 
-FILDEF void internal__replace ()
+FILDEF void internal__replace_tiles (Tab& tab, Level_Layer tile_layer, Tile_ID find_id, Tile_ID replace_id,
+                                     const Select_Mask* mask, bool inside, std::vector<Level_History_Info>& history)
 {
-    Tab& tab = get_current_tab();
+    auto& layer = tab.level.data[tile_layer];
 
-    auto& layer = tab.level.data[tab.tool_info.fill.layer];
-    for (int y=0; y<tab.level.header.height; ++y)
+    int lw = tab.level.header.width;
+    int lh = tab.level.header.height;
+
+    std::vector<Tile_ID> row(lw);
+    std::vector<Tile_Span> matches;
+    std::vector<Tile_Span> pieces;
+
+    for (int y=0; y<lh; ++y)
     {
-        for (int x=0; x<tab.level.header.width; ++x)
+        read_tile_row(layer, 0, y, lw, &row[0]);
+
+        matches.clear();
+        find_tile_spans(&row[0], lw, y, find_id, matches);
+
+        for (auto& match: matches)
         {
             // If the select box is visible then check if we should be replacing inside
             // or outside of the select box bounds. Based on that case we discard any
             // tiles/spawns that do not fit in the bounds we are to be replacing within.
-            if (are_any_select_boxes_visible())
+            pieces.clear();
+            if (mask) internal__clip_span_to_selection(match, *mask, inside, pieces);
+            else pieces.push_back(match);
+
+            for (auto& piece: pieces)
             {
-                if (tab.tool_info.fill.inside_select)
-                {
-                    if (!internal__inside_select_bounds(x, y)) continue;
-                }
-                else
+                for (int x=piece.x; x<piece.x+piece.w; ++x)
                 {
-                    if (internal__inside_select_bounds(x, y)) continue;
+                    Level_History_Info info = {};
+                    info.x                  = x;
+                    info.y                  = y;
+                    info.old_id             = find_id;
+                    info.new_id             = replace_id;
+                    info.tile_layer         = tile_layer;
+                    history.push_back(info);
                 }
+                std::fill(row.begin()+piece.x, row.begin()+piece.x+piece.w, replace_id);
+                write_tile_row(layer, piece.x, y, piece.w, &row[piece.x]);
             }
+        }
+    }
+}
 
-            if (layer[y * tab.level.header.width + x] == tab.tool_info.fill.find_id)
-            {
-                internal__place_tile(x, y, tab.tool_info.fill.replace_id, tab.tool_info.fill.layer);
-            }
+// Replacing can also be done on all of the active layers at once, and/or in all
+// of the open level tabs. Each tab gets all of its changes as a single state,
+// all linked by the same group so one undo reverts the replace in every tab.
+// The selection only applies to the current tab as that is where it was made.
+
+FILDEF void internal__replace (bool all_layers, bool all_tabs)
+{
+    Tab& current = get_current_tab();
+
+    const Select_Mask& select_mask = get_select_mask();
+    const Select_Mask* mask = (select_mask.w > 0) ? &select_mask : NULL;
+
+    Tile_ID find_id    = current.tool_info.fill.find_id;
+    Tile_ID replace_id = current.tool_info.fill.replace_id;
+    bool    inside     = current.tool_info.fill.inside_select;
+
+    std::vector<Level_History_Info> history;
+
+    u64 group = (all_tabs) ? ++level_editor.history_group : 0;
+
+    for (auto& tab: editor.tabs)
+    {
+        bool is_current = (&tab == &current);
+        if (!is_current && (!all_tabs || tab.type != Tab_Type::LEVEL || is_level_tab_loading(tab))) continue;
+
+        history.clear();
+        for (Level_Layer i=LEVEL_LAYER_TAG; i<LEVEL_LAYER_TOTAL; ++i)
+        {
+            if (!tab.tile_layer_active[i]) continue;
+            if (!all_layers && i != current.tool_info.fill.layer) continue;
+            internal__replace_tiles(tab, i, find_id, replace_id, (is_current) ? mask : NULL, inside, history);
+        }
+
+        if (history.empty()) continue;
+
+        if (is_current)
+        {
+            add_to_history_normal_state(history);
+            if (tab.level_history.current_position > -1) internal__get_current_history_state().group = group;
+            level_has_unsaved_changes();
+        }
+        else
+        {
+            internal__add_level_history_state(tab, history, group);
         }
     }
 }
@@ -366,22 +797,18 @@ FILDEF void internal__handle_fill ()
 
     // Determine if the origin of the fill is inside a selection box or not.
     // This part does not matter if a selection box is not currently present.
-    tab.tool_info.fill.inside_select = false;
-    for (auto& bounds: tab.tool_info.select.bounds)
-    {
-        if (bounds.visible)
-        {
-            int sl,st,sr,sb; get_ordered_select_bounds(bounds, &sl,&st,&sr,&sb);
-            if (x >= sl && x <= sr && y >= sb && y <= st) tab.tool_info.fill.inside_select = true;
-        }
-    }
+    tab.tool_info.fill.inside_select = is_tile_selected(get_select_mask(), x, y);
 
     // If the IDs are the same there is no need to fill.
     if (tab.tool_info.fill.find_id == tab.tool_info.fill.replace_id) return;
 
-    // Determine if we are doing a fill or find/replace.
-    if (is_key_mod_state_active(KMOD_ALT)) internal__replace();
-    else                                   internal__fill();
+    // Determine if we are doing a fill or find/replace. Adding shift replaces
+    // on all active layers and adding ctrl replaces in all open level tabs.
+    if      (is_key_mod_state_active(KMOD_ALT                      )) internal__replace(false, false);
+    else if (is_key_mod_state_active(KMOD_ALT|KMOD_SHIFT           )) internal__replace(true,  false);
+    else if (is_key_mod_state_active(KMOD_ALT|KMOD_CTRL            )) internal__replace(false, true );
+    else if (is_key_mod_state_active(KMOD_ALT|KMOD_CTRL|KMOD_SHIFT)) internal__replace(true,  true );
+    else                                                                internal__fill();
 }
 
 FILDEF void internal__restore_select_state (const std::vector<Select_Bounds>& select_state)
@@ -480,86 +907,26 @@ FILDEF void internal__flip_level_h (const bool tile_layer_active[LEVEL_LAYER_TOT
 {
     Tab& tab = get_current_tab();
 
-    int lw = tab.level.header.width;
-    int lh = tab.level.header.height;
-
-    int x = 0;
-    int y = 0;
-    int w = lw;
-    int h = lh;
-
     // Flip all of the level's tiles.
     for (Level_Layer i=0; i<LEVEL_LAYER_TOTAL; ++i)
     {
-        if (!tile_layer_active[i]) continue;
-
-        auto& layer = tab.level.data[i];
-        // Swap the tile columns from left-to-right for each row.
-        for (int j=y; j<(y+h); ++j)
-        {
-            int r = x + (j*lw) + (w-1);
-            int l = x + (j*lw);
-
-            // Stop after we hit the middle point (no need to flip).
-            while (l < r)
-            {
-                Tile_ID rt = layer[r];
-                Tile_ID lt = layer[l];
-
-                layer[r--] = get_tile_horizontal_flip(lt);
-                layer[l++] = get_tile_horizontal_flip(rt);
-            }
-        }
+        if (tile_layer_active[i]) flip_tile_layer_h(tab.level.data[i], get_tile_horizontal_flip_table());
     }
 
-    get_current_tab().unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
 FILDEF void internal__flip_level_v (const bool tile_layer_active[LEVEL_LAYER_TOTAL])
 {
     Tab& tab = get_current_tab();
 
-    int lw = tab.level.header.width;
-    int lh = tab.level.header.height;
-
-    int x = 0;
-    int y = 0;
-    int w = lw;
-    int h = lh;
-
     // Flip all of the level's tiles.
-    std::vector<Tile_ID> temp_row;
-    temp_row.resize(w);
-
     for (Level_Layer i=0; i<LEVEL_LAYER_TOTAL; ++i)
     {
-        if (!tile_layer_active[i]) continue;
-
-        auto& layer = tab.level.data[i];
-        size_t pitch = w * sizeof(Tile_ID);
-
-        int b = (y * lw) + x;
-        int t = ((y+h-1) * lw) + x;
-
-        // Stop after we hit the middle point (no need to flip).
-        while (b < t)
-        {
-            memcpy(&temp_row[0], &layer   [b], pitch);
-            memcpy(&layer   [b], &layer   [t], pitch);
-            memcpy(&layer   [t], &temp_row[0], pitch);
-
-            for (int j=0; j<lw; ++j)
-            {
-                layer[t+j] = get_tile_vertical_flip(layer[t+j]);
-                layer[b+j] = get_tile_vertical_flip(layer[b+j]);
-            }
-
-            b += lw;
-            t -= lw;
-        }
+        if (tile_layer_active[i]) flip_tile_layer_v(tab.level.data[i], get_tile_vertical_flip_table());
     }
 
-    get_current_tab().unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
 FILDEF void internal__draw_cursor (int x, int y, Tile_ID id)
@@ -709,9 +1076,9 @@ FILDEF void internal__draw_clipboard (UI_Dir xdir, UI_Dir ydir)
             const auto& layer = clipboard.data[i];
             auto& layer_space_occupied = tile_space_occupied[i];
 
-            for (size_t j=0; j<layer.size(); ++j)
+            for (size_t j=0; j<get_tile_layer_size(layer); ++j)
             {
-                Tile_ID id = layer[j];
+                Tile_ID id = get_tile(layer, CAST(int, j % layer.width), CAST(int, j / layer.width));
                 if (id) // No point drawing empty tiles...
                 {
                     if (!layer_space_occupied.count(j))
@@ -804,13 +1171,14 @@ FILDEF void internal__dump_level_history ()
             case (Level_History_Action::SELECT_STATE ): history_state += "| SELECT | "; break;
             case (Level_History_Action::CLEAR        ): history_state += "| CLEAR  | "; break;
             case (Level_History_Action::RESIZE       ): history_state += "| RESIZE | "; break;
+            case (Level_History_Action::MERGE        ): history_state += "| MERGE  | "; break;
         }
 
-        history_state += format_string("%5zd | ", s.info.size());
+        history_state += format_string("%5zd | %5zd | ", s.info.size(), s.runs.size());
 
         if (s.action == Level_History_Action::FLIP_LEVEL_H || s.action == Level_History_Action::FLIP_LEVEL_V)
         {
-            for (const auto& tile_layer: s.tile_layer_active)
+            for (const auto& tile_layer: s.extra->tile_layer_active)
             {
                 history_state += (tile_layer) ? "X" : ".";
             }
@@ -831,24 +1199,13 @@ FILDEF void internal__dump_level_history ()
     */
 }
 
-FILDEF void internal__resize (Resize_Dir dir, int nw, int nh)
-{
-    Tab& tab = get_current_tab();
+// Works out where the content of the level ends up after it is resized, the w*h
+// rect at sx,sy in the level before the resize gets moved to dx,dy after it.
 
-    int lw = tab.level.header.width;
-    int lh = tab.level.header.height;
-
-    int dx = nw - lw;
-    int dy = nh - lh;
-
-    if (dx == 0 && dy == 0) return;
-
-    Level_Data old_data = tab.level.data;
-    for (auto& layer: tab.level.data)
-    {
-        layer.clear();
-        layer.resize(nw*nh, 0);
-    }
+FILDEF void internal__get_resize_rect (Resize_Dir dir, int lw, int lh, int nw, int nh, int* sx, int* sy, int* w, int* h, int* dx, int* dy)
+{
+    int xdiff = nw - lw;
+    int ydiff = nh - lh;
 
     int lvlw = lw;
     int lvlh = lh;
@@ -859,17 +1216,17 @@ FILDEF void internal__resize (Resize_Dir dir, int nw, int nh)
     int offy = 0;
 
     // Determine the content offset needed if shrinking the level down.
-    if (dx < 0)
+    if (xdiff < 0)
     {
-        if      (resize_dir_is_west (dir)) lvlw -= abs(dx);
-        else if (resize_dir_is_east (dir)) lvlw -= abs(dx), offx += abs(dx);
-        else                               lvlw -= abs(dx), offx += abs(dx) / 2;
+        if      (resize_dir_is_west (dir)) lvlw -= abs(xdiff);
+        else if (resize_dir_is_east (dir)) lvlw -= abs(xdiff), offx += abs(xdiff);
+        else                               lvlw -= abs(xdiff), offx += abs(xdiff) / 2;
     }
-    if (dy < 0)
+    if (ydiff < 0)
     {
-        if      (resize_dir_is_north(dir)) lvlh -= abs(dy);
-        else if (resize_dir_is_south(dir)) lvlh -= abs(dy), offy += abs(dy);
-        else                               lvlh -= abs(dy), offy += abs(dy) / 2;
+        if      (resize_dir_is_north(dir)) lvlh -= abs(ydiff);
+        else if (resize_dir_is_south(dir)) lvlh -= abs(ydiff), offy += abs(ydiff);
+        else                               lvlh -= abs(ydiff), offy += abs(ydiff) / 2;
     }
 
     // Determine the horizontal position of the level content.
@@ -883,29 +1240,97 @@ FILDEF void internal__resize (Resize_Dir dir, int nw, int nh)
     if (lvlx < 0) lvlx = 0;
     if (lvly < 0) lvly = 0;
 
-    for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
-    {
-        auto& new_layer = tab.level.data.at(i);
-        auto& old_layer = old_data.at(i);
+    *sx = offx, *sy = offy;
+    *w  = lvlw, *h  = lvlh;
+    *dx = lvlx, *dy = lvly;
+}
 
-        for (int iy=0; iy<lvlh; ++iy)
+FILDEF void internal__resize (Resize_Dir dir, int nw, int nh, std::vector<Level_History_Crop>* cropped = NULL)
+{
+    Tab& tab = get_current_tab();
+
+    int lw = tab.level.header.width;
+    int lh = tab.level.header.height;
+
+    if (nw == lw && nh == lh) return;
+
+    int sx,sy, w,h, dx,dy;
+    internal__get_resize_rect(dir, lw,lh, nw,nh, &sx,&sy, &w,&h, &dx,&dy);
+
+    // Keep hold of the strips of the level around the kept content that are
+    // going to be cropped away, so that they can be put back when undoing.
+    if (cropped)
+    {
+        Level_History_Crop strips[4] =
         {
-            for (int ix=0; ix<lvlw; ++ix)
-            {
-                int npos = (iy+lvly) * nw + (ix+lvlx);
-                int opos = (iy+offy) * lw + (ix+offx);
+            { 0,    0,    lw,        sy,        {} }, // North.
+            { 0,    sy+h, lw,        lh-(sy+h), {} }, // South.
+            { 0,    sy,   sx,        h,         {} }, // West.
+            { sx+w, sy,   lw-(sx+w), h,         {} }  // East.
+        };
+        for (auto& strip: strips)
+        {
+            if (strip.w <= 0 || strip.h <= 0) continue;
 
-                new_layer.at(npos) = old_layer.at(opos);
+            bool empty = true;
+            for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
+            {
+                auto& crop_layer = strip.data[i];
+                resize_tile_layer(crop_layer, strip.w, strip.h);
+                for_each_tile_run(tab.level.data[i], strip.x, strip.y, strip.w, strip.h, [&](int x, int y, const Tile_ID* tiles, int count)
+                {
+                    write_tile_row(crop_layer, x-strip.x, y-strip.y, count, tiles);
+                });
+                if (!is_tile_layer_empty(crop_layer)) empty = false;
             }
+            if (!empty) cropped->push_back(std::move(strip));
         }
     }
 
+    for (auto& layer: tab.level.data)
+    {
+        resize_tile_layer_keep(layer, nw,nh, sx,sy, w,h, dx,dy);
+    }
+
     tab.level.header.width  = nw;
     tab.level.header.height = nh;
 
     level_has_unsaved_changes();
 }
 
+// The content is moved back to where it was and the cropped parts are then put
+// back around it, which leaves the level exactly as it was before the resize.
+
+FILDEF void internal__undo_resize (const Level_History_Extra& extra)
+{
+    Tab& tab = get_current_tab();
+
+    int sx,sy, w,h, dx,dy;
+    internal__get_resize_rect(extra.resize_dir, extra.old_width,extra.old_height, extra.new_width,extra.new_height, &sx,&sy, &w,&h, &dx,&dy);
+
+    for (auto& layer: tab.level.data)
+    {
+        resize_tile_layer_keep(layer, extra.old_width,extra.old_height, dx,dy, w,h, sx,sy);
+    }
+
+    for (auto& crop: extra.cropped)
+    {
+        for (int i=0; i<LEVEL_LAYER_TOTAL; ++i)
+        {
+            auto& layer = tab.level.data[i];
+            for_each_tile_run(crop.data[i], [&](int x, int y, const Tile_ID* tiles, int count)
+            {
+                write_tile_row(layer, crop.x+x, crop.y+y, count, tiles);
+            });
+        }
+    }
+
+    tab.level.header.width  = extra.old_width;
+    tab.level.header.height = extra.old_height;
+
+    level_has_unsaved_changes();
+}
+
 FILDEF void init_level_editor ()
 {
     level_editor.tool_state = Tool_State::IDLE;
@@ -936,6 +1361,16 @@ FILDEF void do_level_editor ()
 
     begin_panel(p1.x, p1.y, p1.w, p1.h, UI_NONE);
 
+    // Nothing can be done with the level until it has finished loading.
+    if (is_level_tab_loading(get_current_tab()))
+    {
+        set_cursor(Cursor::ARROW);
+        level_editor.viewport = get_viewport();
+        internal__do_level_loading(get_current_tab());
+        end_panel();
+        return;
+    }
+
     // We cache the mouse position so that systems such as paste which can
     // potentially happen outside of this section of code (where the needed
     // transforms will be applied) can use the mouse position reliably as
@@ -950,6 +1385,8 @@ FILDEF void do_level_editor ()
     // We cache this just in case anyone else wants to use it (status bar).
     level_editor.viewport = get_viewport();
 
+    internal__update_level_unsaved_changes(get_current_tab());
+
     const Tab& tab = get_current_tab();
 
     // If we're in the level editor viewport then the cursor can be one of
@@ -1039,26 +1476,22 @@ FILDEF void do_level_editor ()
         }
 
         // We draw from the top-to-bottom, left-to-right, so that elements
-        // in the level editor stack up nicely on top of each other.
-        float ty = y+DEFAULT_TILE_SIZE_HALF;
-        float tx = x+DEFAULT_TILE_SIZE_HALF;
-
-        const auto& layer = tab.level.data[i];
-        for (int j=0; j<CAST(int, layer.size()); ++j)
+        // in the level editor stack up nicely on top of each other. Chunks
+        // of the layer that are completely empty get skipped over entirely.
+        for_each_tile_run(tab.level.data[i], [&](int rx, int ry, const Tile_ID* tiles, int count)
         {
-            if (layer[j] != 0) // No point drawing empty tiles...
-            {
-                draw_batched_tile(tx, ty, &internal__get_tile_graphic_clip(atlas, layer[j]));
-            }
+            float ty = y+(ry*DEFAULT_TILE_SIZE)+DEFAULT_TILE_SIZE_HALF;
+            float tx = x+(rx*DEFAULT_TILE_SIZE)+DEFAULT_TILE_SIZE_HALF;
 
-            // Move to the next tile in the row, move down if needed.
-            tx += DEFAULT_TILE_SIZE;
-            if (tx >= (x + w))
+            for (int j=0; j<count; ++j)
             {
-                ty += DEFAULT_TILE_SIZE;
-                tx = x+DEFAULT_TILE_SIZE_HALF;
+                if (tiles[j] != 0) // No point drawing empty tiles...
+                {
+                    draw_batched_tile(tx, ty, &internal__get_tile_graphic_clip(atlas, tiles[j]));
+                }
+                tx += DEFAULT_TILE_SIZE;
             }
-        }
+        });
     }
 
     flush_batched_tile();
@@ -1091,36 +1524,23 @@ FILDEF void do_level_editor ()
         // create a bounding box of the top, left, right, and down-most camera tile placements.
         //
         // So in order to get the most accurate camera bounding box for the editor we too must
-        // obtain these values by searching through the level data, and then rendering this.
+        // obtain these values from the level data. The tag layer keeps an index of where its
+        // camera tiles are as they get placed and removed, so this doesn't have to search.
 
         int lw = tab.level.header.width;
         int lh = tab.level.header.height;
 
-        auto& tag_layer = tab.level.data[LEVEL_LAYER_TAG];
+        // Asking for the bounds can update the layer's index so it can't be const.
+        auto& tag_layer = get_current_tab().level.data[LEVEL_LAYER_TAG];
 
         int cl = lw-1;
         int ct = lh-1;
         int cr = 0;
         int cb = 0;
 
-        int camera_tile_count = 0;
+        size_t camera_tile_count = 0;
 
-        for (int iy=0; iy<lh; ++iy)
-        {
-            for (int ix=0; ix<lw; ++ix)
-            {
-                Tile_ID id = tag_layer[iy * tab.level.header.width + ix];
-                if (id == CAMERA_ID)
-                {
-                    ++camera_tile_count;
-
-                    cl = std::min(cl, ix);
-                    ct = std::min(ct, iy);
-                    cr = std::max(cr, ix);
-                    cb = std::max(cb, iy);
-                }
-            }
-        }
+        get_tile_bounds(tag_layer, CAMERA_ID, cl, ct, cr, cb, &camera_tile_count);
 
         // If we have a camera tile selected we can also use that to showcase how it will impact the bounds.
         if (level_editor.tool_type != Tool_Type::SELECT)
@@ -1227,43 +1647,50 @@ FILDEF void do_level_editor ()
             const float LINE_WIDTH = (DEFAULT_TILE_SIZE / 3) * 2; // 2/3
             const float OFFSET = roundf(LINE_WIDTH / 2);
 
-            float ty = y+DEFAULT_TILE_SIZE_HALF;
-            float tx = x+DEFAULT_TILE_SIZE_HALF;
+            // Only the entities whose guides could overlap the visible area of the
+            // level get visited. Guides can be bigger than a tile so the area gets
+            // grown by the largest of the entity graphics to catch the edge ones.
+            float margin = 0;
+            for (auto it=atlas.clips.lower_bound(ENTITY_ID_START); it!=atlas.clips.end(); ++it)
+            {
+                margin = std::max(margin, std::max(it->second.w, it->second.h) * tile_scale / 2);
+            }
+
+            quad viewport = get_viewport();
 
-            auto& layer = tab.level.data[LEVEL_LAYER_ACTIVE];
-            for (int i=0; i<CAST(int, layer.size()); ++i)
+            vec2 va = screen_to_world(vec2(viewport.x,            viewport.y           ));
+            vec2 vb = screen_to_world(vec2(viewport.x+viewport.w, viewport.y+viewport.h));
+
+            int vx1 = CAST(int, floorf((std::min(va.x, vb.x) - margin - x) / DEFAULT_TILE_SIZE));
+            int vy1 = CAST(int, floorf((std::min(va.y, vb.y) - margin - y) / DEFAULT_TILE_SIZE));
+            int vx2 = CAST(int, ceilf ((std::max(va.x, vb.x) + margin - x) / DEFAULT_TILE_SIZE));
+            int vy2 = CAST(int, ceilf ((std::max(va.y, vb.y) + margin - y) / DEFAULT_TILE_SIZE));
+
+            // Querying the layer's entity index can update it so it can't be const.
+            auto& layer = get_current_tab().level.data[LEVEL_LAYER_ACTIVE];
+            for_each_tile_from_id(layer, ENTITY_ID_START, vx1, vy1, vx2-vx1, vy2-vy1, [&](int rx, int ry, Tile_ID id)
             {
-                // Ensures that the tile is an Entity and not a Basic.
-                Tile_ID id = layer[i];
-                if ((id != 0) && ((id-40000) >= 0))
-                {
-                    quad& b = internal__get_tile_graphic_clip(atlas, id);
+                float ty = y+(ry*DEFAULT_TILE_SIZE)+DEFAULT_TILE_SIZE_HALF;
+                float tx = x+(rx*DEFAULT_TILE_SIZE)+DEFAULT_TILE_SIZE_HALF;
 
-                    float hw = (b.w * tile_scale) / 2;
-                    float hh = (b.h * tile_scale) / 2;
+                quad& b = internal__get_tile_graphic_clip(atlas, id);
 
-                    color.a = .20f;
-                    set_draw_color(color);
+                float hw = (b.w * tile_scale) / 2;
+                float hh = (b.h * tile_scale) / 2;
 
-                    fill_quad(tx-hw, ty-hh, tx+hw, ty+hh);
+                color.a = .20f;
+                set_draw_color(color);
 
-                    color.a = .85f;
-                    set_draw_color(color);
+                fill_quad(tx-hw, ty-hh, tx+hw, ty+hh);
 
-                    draw_line(tx-OFFSET, ty, tx+OFFSET, ty);
-                    draw_line(tx, ty-OFFSET, tx, ty+OFFSET);
+                color.a = .85f;
+                set_draw_color(color);
 
-                    draw_quad(tx-hw, ty-hh, tx+hw, ty+hh);
-                }
+                draw_line(tx-OFFSET, ty, tx+OFFSET, ty);
+                draw_line(tx, ty-OFFSET, tx, ty+OFFSET);
 
-                // Move to the next tile in the row, move down if needed.
-                tx += DEFAULT_TILE_SIZE;
-                if (tx >= (x + w))
-                {
-                    ty += DEFAULT_TILE_SIZE;
-                    tx = x+DEFAULT_TILE_SIZE_HALF;
-                }
-            }
+                draw_quad(tx-hw, ty-hh, tx+hw, ty+hh);
+            });
 
             end_scissor();
         }
@@ -1324,6 +1751,17 @@ FILDEF void handle_level_editor_events ()
         return;
     }
 
+    // The only thing that can be done whilst loading is cancelling the load.
+    if (is_level_tab_loading(*tab))
+    {
+        level_editor.tool_state = Tool_State::IDLE;
+        if (main_event.type == SDL_KEYDOWN && main_event.key.keysym.sym == SDLK_ESCAPE)
+        {
+            cancel_level_tab_load();
+        }
+        return;
+    }
+
     switch (main_event.type)
     {
         case (SDL_MOUSEBUTTONDOWN):
@@ -1455,116 +1893,73 @@ FILDEF bool mouse_inside_level_editor_viewport ()
 FILDEF void new_level_history_state (Level_History_Action action)
 {
     if (action == Level_History_Action::NORMAL && !mouse_inside_level_editor_viewport()) return;
+    internal__new_level_history_state(get_current_tab(), action);
+}
 
-    Tab& tab = get_current_tab();
+FILDEF void add_to_history_normal_state (Level_History_Info info)
+{
+    if (!mouse_inside_level_editor_viewport()) return;
 
-    // Don't bother creating a new state if the current erase/place action is
-    // empty otherwise we will end up with a bunch of empty states in the list.
-    if (tab.level_history.current_position > -1)
-    {
-        Level_History_State& current = internal__get_current_history_state();
-        if (current.info.empty() && current.action == action && action == Level_History_Action::NORMAL)
-        {
-            return;
-        }
-    }
+    Tab& tab = get_current_tab();
 
-    // Clear all the history after the current position, if there is any, as it
-    // will no longer apply to the timeline of level editor actions anymore.
-    int delete_position = tab.level_history.current_position+1;
-    if (delete_position < CAST(int, tab.level_history.state.size()))
+    // If there is no current action then we create one. This resolved some
+    // potential bugs that can occur when undoing/redoing mid stroke, etc.
+    if (tab.level_history.current_position <= -1)
     {
-        auto begin = tab.level_history.state.begin();
-        auto end = tab.level_history.state.end();
-
-        tab.level_history.state.erase(begin+delete_position, end);
+        new_level_history_state(Level_History_Action::NORMAL);
     }
 
-    // If it's a selection action then we don't need to modify this.
-    if (action != Level_History_Action::SELECT_STATE)
+    // We also check if the current state is not of type normal because if
+    // it is then we need to add a new normal state (because flip states
+    // do not ever need to call this function). This resolves the issues of
+    // the history getting messed up if the user flips the level mid-stroke.
+    if (internal__get_current_history_state().action != Level_History_Action::NORMAL)
     {
-        get_current_tab().unsaved_changes = true;
+        new_level_history_state(Level_History_Action::NORMAL);
     }
 
-    tab.level_history.state.push_back(Level_History_State());
-    tab.level_history.state.back().action = action;
+    add_level_history_info(internal__get_current_history_state(), info);
+}
 
-    // Also deal with the layer states for flip actions.
-    if (action == Level_History_Action::FLIP_LEVEL_H || action == Level_History_Action::FLIP_LEVEL_V)
-    {
-        for (Level_Layer i=LEVEL_LAYER_TAG; i<LEVEL_LAYER_TOTAL; ++i)
-        {
-            tab.level_history.state.back().tile_layer_active[i] = tab.tile_layer_active[i];
-        }
-    }
+FILDEF void add_to_history_normal_state (const std::vector<Level_History_Info>& info)
+{
+    if (!mouse_inside_level_editor_viewport()) return;
 
-    // Also deal with the select bounds for selection actions.
-    if (action == Level_History_Action::SELECT_STATE)
-    {
-        tab.level_history.state.back().old_select_state = tab.old_select_state;
-        tab.level_history.state.back().new_select_state = tab.tool_info.select.bounds;
-    }
+    Tab& tab = get_current_tab();
 
-    // Also deal with width and height for resizing.
-    if (action == Level_History_Action::RESIZE)
+    if (tab.level_history.current_position <= -1 || internal__get_current_history_state().action != Level_History_Action::NORMAL)
     {
-        tab.level_history.state.back().resize_dir = get_resize_dir();
-        tab.level_history.state.back().old_width  = tab.level.header.width;
-        tab.level_history.state.back().old_height = tab.level.header.height;
-        tab.level_history.state.back().new_width  = get_resize_w();
-        tab.level_history.state.back().new_height = get_resize_h();
+        new_level_history_state(Level_History_Action::NORMAL);
     }
 
-    ++tab.level_history.current_position;
+    Level_History_State& state = internal__get_current_history_state();
+    state.info.reserve(state.info.size()+info.size());
+    for (auto& i: info) add_level_history_info(state, i);
 }
 
-FILDEF void add_to_history_normal_state (Level_History_Info info)
+FILDEF void add_to_history_normal_state (const std::vector<Level_History_Run>& runs)
 {
     if (!mouse_inside_level_editor_viewport()) return;
 
     Tab& tab = get_current_tab();
 
-    // If there is no current action then we create one. This resolved some
-    // potential bugs that can occur when undoing/redoing mid stroke, etc.
-    if (tab.level_history.current_position <= -1)
-    {
-        new_level_history_state(Level_History_Action::NORMAL);
-    }
-
-    // We also check if the current state is not of type normal because if
-    // it is then we need to add a new normal state (because flip states
-    // do not ever need to call this function). This resolves the issues of
-    // the history getting messed up if the user flips the level mid-stroke.
-    if (internal__get_current_history_state().action != Level_History_Action::NORMAL)
+    if (tab.level_history.current_position <= -1 || internal__get_current_history_state().action != Level_History_Action::NORMAL)
     {
         new_level_history_state(Level_History_Action::NORMAL);
     }
 
-    // Don't add the same spawns/tiles repeatedly, otherwise add the spawn/tile.
-    Level_History_State& state = internal__get_current_history_state();
-    if (!state.info.empty())
-    {
-        const Level_History_Info& n = info;
-        for (auto& o: state.info)
-        {
-            if (o.x == n.x && o.y == n.y && o.tile_layer == n.tile_layer && o.new_id != n.new_id)
-            {
-                o.new_id = n.new_id;
-            }
-            if (o.x == n.x && o.y == n.y && o.tile_layer == n.tile_layer && o.new_id == n.new_id)
-            {
-                return;
-            }
-        }
-    }
-
-    state.info.push_back(info);
+    add_level_history_runs(internal__get_current_history_state(), runs);
 }
 
-FILDEF void add_to_history_clear_state (Level_History_Info info)
+FILDEF size_t get_level_history_memory (const Tab& tab)
 {
-    ASSERT(internal__get_current_history_state().action == Level_History_Action::CLEAR);
-    internal__get_current_history_state().info.push_back(info);
+    size_t memory = 0;
+    for (auto& state: tab.level_history.state)
+    {
+        // States that are still being added to haven't worked out their size.
+        memory += (state.memory) ? state.memory : internal__get_history_state_memory(state);
+    }
+    return memory;
 }
 
 FILDEF bool are_all_layers_inactive ()
@@ -1636,6 +2031,136 @@ FILDEF void get_total_select_boundary (int* l, int* t, int* r, int* b)
     if (b) *b = min_b;
 }
 
+FILDEF bool internal__same_select_bounds (const std::vector<Select_Bounds>& a, const std::vector<Select_Bounds>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i=0; i<a.size(); ++i)
+    {
+        if (a[i].top     != b[i].top    || a[i].right != b[i].right ||
+            a[i].bottom  != b[i].bottom || a[i].left  != b[i].left  ||
+            a[i].visible != b[i].visible)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+FILDEF void internal__set_select_mask_bits (std::vector<u64>& bits, size_t begin, size_t end)
+{
+    // Sets every bit in the range [begin, end) a whole word at a time.
+    while (begin < end)
+    {
+        size_t word = begin >> 6;
+        size_t shift = begin & 63;
+        size_t count = std::min(CAST(size_t, 64)-shift, end-begin);
+        u64 bit_mask = (count == 64) ? ~CAST(u64, 0) : (((CAST(u64, 1) << count)-1) << shift);
+        bits[word] |= bit_mask;
+        begin += count;
+    }
+}
+
+FILDEF void internal__build_select_mask (Select_Mask& mask, const std::vector<Select_Bounds>& bounds, int lw, int lh)
+{
+    mask.bounds       = bounds;
+    mask.level_width  = lw;
+    mask.level_height = lh;
+    mask.built        = true;
+
+    mask.bits.clear();
+    mask.spans.clear();
+    mask.rows.clear();
+
+    // Order and clamp the boxes once, they can be out of bounds after a resize.
+    std::vector<Select_Bounds> boxes;
+    int min_l = INT_MAX, max_t = INT_MIN, max_r = INT_MIN, min_b = INT_MAX;
+    for (auto& b: bounds)
+    {
+        if (!b.visible) continue;
+        Select_Bounds box = {};
+        get_ordered_select_bounds(b, &box.left, &box.top, &box.right, &box.bottom);
+        box.left   = std::max(box.left,   0);
+        box.bottom = std::max(box.bottom, 0);
+        box.right  = std::min(box.right,  lw-1);
+        box.top    = std::min(box.top,    lh-1);
+        if (box.left > box.right || box.bottom > box.top) continue;
+        min_l = std::min(min_l, box.left);
+        max_t = std::max(max_t, box.top);
+        max_r = std::max(max_r, box.right);
+        min_b = std::min(min_b, box.bottom);
+        boxes.push_back(box);
+    }
+
+    if (boxes.empty())
+    {
+        mask.x = mask.y = mask.w = mask.h = 0;
+        return;
+    }
+
+    mask.x = min_l;
+    mask.y = min_b;
+    mask.w = (max_r-min_l)+1;
+    mask.h = (max_t-min_b)+1;
+
+    mask.bits.resize((CAST(size_t, mask.w)*mask.h + 63) / 64, 0);
+    mask.rows.reserve(mask.h+1);
+
+    // Each row's spans are the overlapping boxes' ranges sorted and merged.
+    std::vector<std::pair<int,int>> ranges;
+    for (int y=mask.y; y<mask.y+mask.h; ++y)
+    {
+        mask.rows.push_back(mask.spans.size());
+
+        ranges.clear();
+        for (auto& box: boxes)
+        {
+            if (y >= box.bottom && y <= box.top) ranges.push_back({ box.left, box.right });
+        }
+        std::sort(ranges.begin(), ranges.end());
+
+        for (size_t i=0; i<ranges.size(); ++i)
+        {
+            int l = ranges[i].first;
+            int r = ranges[i].second;
+            while (i+1 < ranges.size() && ranges[i+1].first <= r+1) r = std::max(r, ranges[++i].second);
+
+            mask.spans.push_back({ l, y, (r-l)+1 });
+
+            size_t row = CAST(size_t, y-mask.y)*mask.w;
+            internal__set_select_mask_bits(mask.bits, row+(l-mask.x), row+(r-mask.x)+1);
+        }
+    }
+    mask.rows.push_back(mask.spans.size());
+}
+
+FILDEF const Select_Mask& get_select_mask ()
+{
+    Tab& tab = get_current_tab();
+    Select_Mask& mask = tab.tool_info.select.mask;
+
+    int lw = tab.level.header.width;
+    int lh = tab.level.header.height;
+
+    // Rebuilding lazily means dragging out a select box doesn't rebuild the
+    // mask every frame, only when a tool actually goes on to make use of it.
+    if (!mask.built || mask.level_width != lw || mask.level_height != lh ||
+        !internal__same_select_bounds(mask.bounds, tab.tool_info.select.bounds))
+    {
+        internal__build_select_mask(mask, tab.tool_info.select.bounds, lw, lh);
+    }
+
+    return mask;
+}
+
+FILDEF bool is_tile_selected (const Select_Mask& mask, int x, int y)
+{
+    x -= mask.x;
+    y -= mask.y;
+    if (x < 0 || x >= mask.w || y < 0 || y >= mask.h) return false;
+    size_t index = CAST(size_t, y)*mask.w+x;
+    return ((mask.bits[index >> 6] >> (index & 63)) & 1);
+}
+
 FILDEF void load_level_tab (std::string file_name)
 {
     // If there is just one tab and it is completely empty with no changes
@@ -1660,17 +2185,28 @@ FILDEF void load_level_tab (std::string file_name)
         tab.name = file_name;
         set_main_window_subtitle_for_tab(tab.name);
 
-        if (!load_level(tab.level, tab.name))
-        {
-            close_current_tab();
-        }
+        internal__begin_level_tab_load(tab);
     }
 
     need_to_scroll_next_update();
 }
 
+FILDEF void internal__save_level_tab (Tab& tab)
+{
+    // Saves also write a backup, unless the level was already backed up as is.
+    u64 hash = get_level_hash(tab.level);
+    Level_Backup_Plan backup;
+    if (hash != tab.backup_hash && get_level_backup_plan(tab.name, backup))
+    {
+        tab.backup_hash = hash; // Put back if the backup ends up failing.
+    }
+    save_level_async(tab.level, tab.name, backup, tab.id, hash);
+}
+
 FILDEF bool le_save (Tab& tab)
 {
+    if (is_level_tab_loading(tab)) return false;
+
     // If the current file already has a name (has been saved before) then we
     // just do a normal Save to that file. Otherwise, we perform a Save As.
     if (tab.name.empty())
@@ -1679,11 +2215,18 @@ FILDEF bool le_save (Tab& tab)
         if (file_name.empty()) return false;
         tab.name = file_name;
     }
+    else
+    {
+        // The file already holds exactly this level so don't write it again.
+        if (get_level_hash(tab.level) == tab.saved_hash && does_file_exist(tab.name))
+        {
+            tab.unsaved_changes = false;
+            return true;
+        }
+    }
 
-    save_level(tab.level, tab.name);
-    backup_level_tab(tab.level, tab.name);
-
-    tab.unsaved_changes = false;
+    // The unsaved changes flag gets cleared once the save actually completes.
+    internal__save_level_tab(tab);
     set_main_window_subtitle_for_tab(tab.name);
 
     return true;
@@ -1691,16 +2234,15 @@ FILDEF bool le_save (Tab& tab)
 
 FILDEF bool le_save_as ()
 {
+    if (is_level_tab_loading(get_current_tab())) return false;
+
     std::string file_name = save_dialog(Dialog_Type::LVL);
     if (file_name.empty()) return false;
 
     Tab& tab = get_current_tab();
 
     tab.name = file_name;
-    save_level(tab.level, tab.name);
-    backup_level_tab(tab.level, tab.name);
-
-    tab.unsaved_changes = false;
+    internal__save_level_tab(tab);
     set_main_window_subtitle_for_tab(tab.name);
 
     return true;
@@ -1709,42 +2251,44 @@ FILDEF bool le_save_as ()
 FILDEF void le_clear_select ()
 {
     if (!current_tab_is_level() || !are_any_select_boxes_visible()) return;
+    if (is_level_tab_loading(get_current_tab())) return;
 
     Tab& tab = get_current_tab();
 
     new_level_history_state(Level_History_Action::CLEAR);
-    for (auto& bounds: tab.tool_info.select.bounds)
+
+    // Clear all of the tiles within the selection as a block over the select
+    // boundary, masked by the mask's spans so only the selected tiles go.
+    const Select_Mask& select_mask = get_select_mask();
+    std::vector<Level_History_Run> history;
+    for (Level_Layer i=LEVEL_LAYER_TAG; i<LEVEL_LAYER_TOTAL; ++i)
     {
-        if (bounds.visible)
+        internal__write_mirrored_tile_block(i, select_mask.x, select_mask.y, select_mask.w, select_mask.h, [&](int row, Tile_ID* tiles, u8* mask)
         {
-            int l, t, r, b;
-            get_ordered_select_bounds(bounds, &l, &t, &r, &b);
-
-            // Clear all of the tiles within the selection.
-            for (Level_Layer i=LEVEL_LAYER_TAG; i<LEVEL_LAYER_TOTAL; ++i)
+            std::fill(tiles, tiles+select_mask.w, 0);
+            std::fill(mask,  mask +select_mask.w, 0);
+            for (size_t j=select_mask.rows[row]; j<select_mask.rows[row+1]; ++j)
             {
-                for (int y=b; y<=t; ++y)
-                {
-                    for (int x=l; x<=r; ++x)
-                    {
-                        internal__place_mirrored_tile_clear(x, y, 0, i);
-                    }
-                }
+                const Tile_Span& span = select_mask.spans[j];
+                std::fill(mask+(span.x-select_mask.x), mask+(span.x-select_mask.x)+span.w, 1);
             }
-        }
+        },
+        history);
     }
+    add_level_history_runs(tab.level_history.state.back(), history);
 
     // We also deselect the select box(es) afterwards -- feels right.
-    tab.level_history.state.back().old_select_state = tab.tool_info.select.bounds;
+    Level_History_Extra& extra = internal__get_history_extra(tab.level_history.state.back());
+    extra.old_select_state = tab.tool_info.select.bounds;
     internal__deselect();
-    tab.level_history.state.back().new_select_state = tab.tool_info.select.bounds;
+    extra.new_select_state = tab.tool_info.select.bounds;
 
-    get_current_tab().unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
 FILDEF void le_deselect ()
 {
-    if (!current_tab_is_level()) return;
+    if (!current_tab_is_level() || is_level_tab_loading(get_current_tab())) return;
 
     Tab& tab = get_current_tab();
     tab.old_select_state = tab.tool_info.select.bounds;
@@ -1757,7 +2301,7 @@ FILDEF void le_deselect ()
 
 FILDEF void le_select_all ()
 {
-    if (!current_tab_is_level()) return;
+    if (!current_tab_is_level() || is_level_tab_loading(get_current_tab())) return;
 
     Tab& tab = get_current_tab();
 
@@ -1779,6 +2323,7 @@ FILDEF void le_select_all ()
 FILDEF void le_copy ()
 {
     if (!current_tab_is_level() || !are_any_select_boxes_visible()) return;
+    if (is_level_tab_loading(get_current_tab())) return;
     internal__copy();
     le_deselect(); // We also deselect the region afterwards, feels right.
 }
@@ -1786,18 +2331,21 @@ FILDEF void le_copy ()
 FILDEF void le_cut ()
 {
     if (!current_tab_is_level() || !are_any_select_boxes_visible()) return;
+    if (is_level_tab_loading(get_current_tab())) return;
     internal__copy();
     le_clear_select(); // Does deselect for us.
-    get_current_tab().unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
 FILDEF void le_paste ()
 {
     if (!current_tab_is_level() || internal__clipboard_empty()) return;
+    if (is_level_tab_loading(get_current_tab())) return;
 
     vec2 tile_pos = level_editor.mouse_tile;
     new_level_history_state(Level_History_Action::NORMAL);
 
+    std::vector<Level_History_Run> history;
     for (auto& clipboard: level_editor.clipboard)
     {
         int x = CAST(int, tile_pos.x) + clipboard.x;
@@ -1809,23 +2357,23 @@ FILDEF void le_paste ()
         for (size_t i=0; i<clipboard.data.size(); ++i)
         {
             const auto& src_layer = clipboard.data[i];
-            for (int iy=y; iy<(y+h); ++iy)
+            internal__write_mirrored_tile_block(CAST(Level_Layer, i), x, y, w, h, [&](int row, Tile_ID* tiles, u8* mask)
             {
-                for (int ix=x; ix<(x+w); ++ix)
-                {
-                    internal__place_mirrored_tile(ix, iy, src_layer[(iy-y)*w+(ix-x)], CAST(Level_Layer, i));
-                }
-            }
+                read_tile_row(src_layer, 0, row, w, tiles);
+            },
+            history);
         }
     }
+    if (history.empty()) return;
 
-    get_current_tab().unsaved_changes = true;
+    add_to_history_normal_state(history);
+    level_has_unsaved_changes();
 }
 
 FILDEF void flip_level_h ()
 {
     // If all layers are inactive then there is no point in doing the flip.
-    if (are_all_layers_inactive()) return;
+    if (are_all_layers_inactive() || is_level_tab_loading(get_current_tab())) return;
 
     const Tab& tab = get_current_tab();
 
@@ -1842,7 +2390,7 @@ FILDEF void flip_level_h ()
 FILDEF void flip_level_v ()
 {
     // If all layers are inactive then there is no point in doing the flip.
-    if (are_all_layers_inactive()) return;
+    if (are_all_layers_inactive() || is_level_tab_loading(get_current_tab())) return;
 
     const Tab& tab = get_current_tab();
 
@@ -1858,12 +2406,43 @@ FILDEF void flip_level_v ()
 
 FILDEF void level_has_unsaved_changes ()
 {
-    get_current_tab().unsaved_changes = true;
+    Tab& tab = get_current_tab();
+    tab.unsaved_changes = true;
+}
+
+// Undoes/redoes the states linked to the one that was just undone/redone in
+// the current tab. A tab is only affected if the linked state is still right
+// at its current position, so any later changes made in that tab are kept.
+
+FILDEF void internal__apply_linked_history_states (u64 group, bool undo)
+{
+    if (!group) return;
+
+    const Tab& current = get_current_tab();
+    for (auto& tab: editor.tabs)
+    {
+        if (&tab == &current || tab.type != Tab_Type::LEVEL || is_level_tab_loading(tab)) continue;
+
+        Level_History& history = tab.level_history;
+        int position = (undo) ? history.current_position : history.current_position+1;
+        if (position < 0 || position >= CAST(int, history.state.size())) continue;
+
+        Level_History_State& state = history.state[position];
+        if (state.group != group) continue;
+
+        // The state could still be unpacked if that tab was the current one.
+        internal__pack_history_state(state);
+        apply_level_history_runs(tab.level.data, state, undo);
+        history.current_position = (undo) ? position-1 : position;
+
+        internal__update_level_unsaved_changes(tab);
+    }
 }
 
 FILDEF void le_undo ()
 {
     Tab& tab = get_current_tab();
+    if (is_level_tab_loading(tab)) return;
 
     // There is no history or we are already at the beginning.
     if (tab.level_history.current_position <= -1) return;
@@ -1871,24 +2450,32 @@ FILDEF void le_undo ()
     bool normal_state_empty = false;
 
     Level_History_State& state = internal__get_current_history_state();
+
+    // We may be undoing mid-stroke, in which case the state is still unpacked.
+    internal__pack_history_state(state);
+
     switch (state.action)
     {
         case (Level_History_Action::RESIZE):
         {
-            internal__resize(state.resize_dir, state.old_width, state.old_height);
-            tab.level.data = state.old_data;
+            internal__undo_resize(*state.extra);
+        } break;
+        case (Level_History_Action::MERGE):
+        {
+            tab.level.data = state.extra->old_data;
+            internal__restore_select_state(state.extra->old_select_state);
         } break;
         case (Level_History_Action::SELECT_STATE):
         {
-            internal__restore_select_state(state.old_select_state);
+            internal__restore_select_state(state.extra->old_select_state);
         } break;
         case (Level_History_Action::FLIP_LEVEL_H):
         {
-            internal__flip_level_h(state.tile_layer_active);
+            internal__flip_level_h(state.extra->tile_layer_active);
         } break;
         case (Level_History_Action::FLIP_LEVEL_V):
         {
-            internal__flip_level_v(state.tile_layer_active);
+            internal__flip_level_v(state.extra->tile_layer_active);
         } break;
         case (Level_History_Action::NORMAL):
         case (Level_History_Action::CLEAR):
@@ -1896,21 +2483,19 @@ FILDEF void le_undo ()
             // We check if the normal state we're undoing is empty or not. If it is
             // then we mark it as such and then if there is another state before it
             // we undo that one as well. This just feels a nicer than not doing it.
-            if (state.info.empty()) normal_state_empty = true;
+            if (state.runs.empty()) normal_state_empty = true;
 
-            for (auto& i: state.info)
-            {
-                int pos = i.y * tab.level.header.width + i.x;
-                tab.level.data[i.tile_layer][pos] = i.old_id;
-            }
+            apply_level_history_runs(tab.level.data, state, true);
 
             if (state.action == Level_History_Action::CLEAR)
             {
-                internal__restore_select_state(state.old_select_state);
+                internal__restore_select_state(state.extra->old_select_state);
             }
         } break;
     }
 
+    internal__apply_linked_history_states(state.group, true);
+
     if (tab.level_history.current_position > -1)
     {
         --tab.level_history.current_position;
@@ -1923,13 +2508,14 @@ FILDEF void le_undo ()
 
     if (state.action != Level_History_Action::SELECT_STATE)
     {
-        tab.unsaved_changes = true;
+        level_has_unsaved_changes();
     }
 }
 
 FILDEF void le_redo ()
 {
     Tab& tab = get_current_tab();
+    if (is_level_tab_loading(tab)) return;
 
     // There is no history or we are already at the end.
     if (tab.level_history.current_position >= CAST(int, tab.level_history.state.size())-1) return;
@@ -1941,37 +2527,39 @@ FILDEF void le_redo ()
     {
         case (Level_History_Action::RESIZE):
         {
-            internal__resize(state.resize_dir, state.new_width, state.new_height);
-            tab.level.data = state.new_data;
+            internal__resize(state.extra->resize_dir, state.extra->new_width, state.extra->new_height);
+        } break;
+        case (Level_History_Action::MERGE):
+        {
+            tab.level.data = state.extra->new_data;
+            internal__restore_select_state(state.extra->new_select_state);
         } break;
         case (Level_History_Action::SELECT_STATE):
         {
-            internal__restore_select_state(state.new_select_state);
+            internal__restore_select_state(state.extra->new_select_state);
         } break;
         case (Level_History_Action::FLIP_LEVEL_H):
         {
-            internal__flip_level_h(state.tile_layer_active);
+            internal__flip_level_h(state.extra->tile_layer_active);
         } break;
         case (Level_History_Action::FLIP_LEVEL_V):
         {
-            internal__flip_level_v(state.tile_layer_active);
+            internal__flip_level_v(state.extra->tile_layer_active);
         } break;
         case (Level_History_Action::NORMAL):
         case (Level_History_Action::CLEAR):
         {
-            for (auto& i: state.info)
-            {
-                int pos = i.y * tab.level.header.width + i.x;
-                tab.level.data[i.tile_layer][pos] = i.new_id;
-            }
+            apply_level_history_runs(tab.level.data, state, false);
 
             if (state.action == Level_History_Action::CLEAR)
             {
-                internal__restore_select_state(state.new_select_state);
+                internal__restore_select_state(state.extra->new_select_state);
             }
         } break;
     }
 
+    internal__apply_linked_history_states(state.group, false);
+
     // If we end on an empty normal state and we are not already at the end of
     // the redo history then we redo again as it feels nicer. This action is
     // the inverse of what we do when we do an undo with blank normal actions.
@@ -1981,7 +2569,7 @@ FILDEF void le_redo ()
         ++tab.level_history.current_position;
         Level_History_State& next_state = internal__get_current_history_state();
 
-        if (next_state.action != Level_History_Action::NORMAL || !next_state.info.empty())
+        if (next_state.action != Level_History_Action::NORMAL || !internal__is_history_state_empty(next_state))
         {
             --tab.level_history.current_position;
         }
@@ -1989,28 +2577,30 @@ FILDEF void le_redo ()
 
     if (state.action != Level_History_Action::SELECT_STATE)
     {
-        tab.unsaved_changes = true;
+        level_has_unsaved_changes();
     }
 }
 
 FILDEF void le_history_begin ()
 {
     Tab& tab = get_current_tab();
+    if (is_level_tab_loading(tab)) return;
     while (tab.level_history.current_position > -1) le_undo();
-    tab.unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
 FILDEF void le_history_end ()
 {
     Tab& tab = get_current_tab();
+    if (is_level_tab_loading(tab)) return;
     int maximum = CAST(int, tab.level_history.state.size()-1);
     while (tab.level_history.current_position < maximum) le_redo();
-    tab.unsaved_changes = true;
+    level_has_unsaved_changes();
 }
 
 FILDEF void le_resize ()
 {
-    if (!current_tab_is_level()) return;
+    if (!current_tab_is_level() || is_level_tab_loading(get_current_tab())) return;
     const Tab& tab = get_current_tab();
     open_resize(tab.level.header.width, tab.level.header.height);
 }
@@ -2032,100 +2622,133 @@ FILDEF void le_resize_okay ()
     if (dx == 0 && dy == 0) return;
 
     new_level_history_state(Level_History_Action::RESIZE);
-    internal__get_current_history_state().old_data = tab.level.data;
-    internal__resize(get_resize_dir(), nw, nh);
-    internal__get_current_history_state().new_data = tab.level.data;
+    internal__resize(get_resize_dir(), nw, nh, &internal__get_current_history_state().extra->cropped);
 }
 
-FILDEF void le_load_prev_level ()
+FILDEF std::vector<Select_Bounds> internal__get_merge_conflict_bounds (const std::vector<Level_Merge_Conflict>& conflicts)
 {
-    if (!current_tab_is_level()) return;
+    // The conflicts from all the layers are flattened into runs along each row
+    // and runs that line up on the rows below are grown into a single box, so
+    // large conflicting areas do not end up as thousands of tiny select boxes.
+    std::vector<std::pair<int,int>> tiles; // (y,x) so they sort in row order.
+    tiles.reserve(conflicts.size());
+    for (auto& conflict: conflicts) tiles.push_back({ conflict.y, conflict.x });
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
 
-    Tab& tab = get_current_tab();
+    std::vector<Select_Bounds> bounds;
+    std::map<std::pair<int,int>, size_t> open_boxes; // Keyed by the left and right.
 
-    std::string path(strip_file_name(tab.name));
+    for (size_t i=0; i<tiles.size();)
+    {
+        int y = tiles[i].first;
+        int l = tiles[i].second;
+        int r = l;
+        for (++i; i<tiles.size() && tiles[i].first == y && tiles[i].second == r+1; ++i) ++r;
 
-    std::vector<std::string> files;
-    list_path_files(path, files);
-    if (files.size() <= 1) return;
+        auto it = open_boxes.find({ l, r });
+        if (it != open_boxes.end() && bounds[it->second].bottom == y-1)
+        {
+            bounds[it->second].bottom = y;
+        }
+        else
+        {
+            Select_Bounds box;
+            box.left    = l;
+            box.top     = y;
+            box.right   = r;
+            box.bottom  = y;
+            box.visible = true;
+            open_boxes[{ l, r }] = bounds.size();
+            bounds.push_back(box);
+        }
+    }
 
-    files.erase(std::remove_if(files.begin(), files.end(),
-    [](const std::string& s)
-    {
-        return s.substr(s.find_last_of(".")) != ".lvl";
-    }),
-    files.end());
+    return bounds;
+}
 
-    // We strip the extensions then sort the files as they can interfere with
-    // getting a good alphabetical sort on the strings. We add them back later.
-    for (auto& f: files) f = strip_file_ext(f);
-    std::sort(files.begin(), files.end());
+FILDEF void le_merge ()
+{
+    if (!current_tab_is_level() || is_level_tab_loading(get_current_tab())) return;
 
-    // Find our current location and move on to the prev file.
-    std::string current(strip_file_ext(tab.name));
-    auto iter = std::find(files.begin(), files.end(), current);
-    if (iter == files.end()) return; // Shouldn't happen...
+    // The current tab is our version of the level, so we need to know which
+    // level both versions started from and then their version of the level.
+    if (show_alert("Merge", "Select the base level that both versions started from.", ALERT_TYPE_INFO, ALERT_BUTTON_OK_CANCEL, "Main") != ALERT_RESULT_OK) return;
+    std::vector<std::string> base_file = open_dialog(Dialog_Type::LVL, false);
+    if (base_file.empty()) return;
 
-    std::string prev;
-    if (iter == files.begin()) prev = *(files.end()-1);
-    else prev = *(iter-1);
+    if (show_alert("Merge", "Select their version of the level to merge in.", ALERT_TYPE_INFO, ALERT_BUTTON_OK_CANCEL, "Main") != ALERT_RESULT_OK) return;
+    std::vector<std::string> their_file = open_dialog(Dialog_Type::LVL, false);
+    if (their_file.empty()) return;
 
-    prev += ".lvl";
+    Level base, theirs;
+    if (!load_level(base,   base_file .at(0))) return;
+    if (!load_level(theirs, their_file.at(0))) return;
 
-    if (save_changes_prompt(tab) == ALERT_RESULT_CANCEL)
+    Tab& tab = get_current_tab();
+
+    Level merged;
+    std::vector<Level_Merge_Conflict> conflicts;
+    std::string error;
+    if (!merge_levels(base, tab.level, theirs, merged, conflicts, error))
     {
+        LOG_ERROR(ERR_MED, "%s", error.c_str());
         return;
     }
-    tab.unsaved_changes = false;
 
-    // Finally, we can load the prev level as the current tab.
-    tab.name = prev;
-    set_main_window_subtitle_for_tab(tab.name);
+    LOG_DEBUG("Merged Level: %zu conflicts", conflicts.size());
+
+    // The conflicts become the selection so they're easy to find and fix up.
+    tab.old_select_state = tab.tool_info.select.bounds;
+    tab.tool_info.select.bounds = internal__get_merge_conflict_bounds(conflicts);
+
+    new_level_history_state(Level_History_Action::MERGE);
+    internal__get_current_history_state().extra->old_data = tab.level.data;
+    internal__get_current_history_state().extra->new_data = merged.data;
 
-    if (!load_level(tab.level, tab.name))
+    tab.level.data = merged.data;
+
+    if (!conflicts.empty())
     {
-        close_current_tab();
+        std::string msg(format_string("%zu tiles changed in both versions and were kept as they are in this tab.\nThe conflicting tiles have been selected.", conflicts.size()));
+        show_alert("Merge", msg, ALERT_TYPE_WARNING, ALERT_BUTTON_OK, "Main");
     }
 }
 
-FILDEF void le_load_next_level ()
+FILDEF void le_load_prev_level ()
 {
     if (!current_tab_is_level()) return;
 
     Tab& tab = get_current_tab();
 
-    std::string path(strip_file_name(tab.name));
+    // The folder's level index knows the order of the levels so we don't
+    // have to go and list/sort all the files in the folder every time.
+    std::string prev(get_adjacent_indexed_level(tab.name, -1));
+    if (prev.empty()) return;
 
-    std::vector<std::string> files;
-    list_path_files(path, files);
-    if (files.size() <= 1) return;
-
-    files.erase(std::remove_if(files.begin(), files.end(),
-    [](const std::string& s)
-    {
-        return s.substr(s.find_last_of(".")) != ".lvl";
-    }),
-    files.end());
-
-    // We strip the extensions then sort the files as they can interfere with
-    // getting a good alphabetical sort on the strings. We add them back later.
-    for (auto& f: files)
+    if (save_changes_prompt(tab) == ALERT_RESULT_CANCEL)
     {
-        std::string ext(f.substr(f.find_last_of(".")));
-        f = strip_file_ext(f);
+        return;
     }
-    std::sort(files.begin(), files.end());
+    tab.unsaved_changes = false;
+
+    // Finally, we can load the prev level as the current tab.
+    tab.name = prev;
+    set_main_window_subtitle_for_tab(tab.name);
+
+    internal__begin_level_tab_load(tab);
+}
 
-    // Find our current location and move on to the next file.
-    std::string current(strip_file_ext(tab.name));
-    auto iter = std::find(files.begin(), files.end(), current);
-    if (iter == files.end()) return; // Shouldn't happen...
+FILDEF void le_load_next_level ()
+{
+    if (!current_tab_is_level()) return;
 
-    std::string next;
-    if (iter+1 != files.end()) next = *(iter+1);
-    else next = *files.begin();
+    Tab& tab = get_current_tab();
 
-    next += ".lvl";
+    // The folder's level index knows the order of the levels so we don't
+    // have to go and list/sort all the files in the folder every time.
+    std::string next(get_adjacent_indexed_level(tab.name, 1));
+    if (next.empty()) return;
 
     if (save_changes_prompt(tab) == ALERT_RESULT_CANCEL)
     {
@@ -2137,10 +2760,7 @@ FILDEF void le_load_next_level ()
     tab.name = next;
     set_main_window_subtitle_for_tab(tab.name);
 
-    if (!load_level(tab.level, tab.name))
-    {
-        close_current_tab();
-    }
+    internal__begin_level_tab_load(tab);
 }
 
 FILDEF void level_drop_file (Tab* tab, std::string file_name)
@@ -2169,82 +2789,163 @@ FILDEF void level_drop_file (Tab* tab, std::string file_name)
         tab->name = file_name;
         set_main_window_subtitle_for_tab(tab->name);
 
-        if (!load_level(tab->level, tab->name))
-        {
-            close_current_tab();
-        }
+        internal__begin_level_tab_load(*tab);
     }
 
     need_to_scroll_next_update();
 }
 
-FILDEF void backup_level_tab (const Level& level, const std::string& file_name)
+FILDEF bool get_level_backup_plan (const std::string& file_name, Level_Backup_Plan& plan)
+{
+    plan = Level_Backup_Plan();
+
+    Backup_Slot slot;
+    if (!get_next_backup_slot(Backup_Type::LEVEL, file_name, slot)) return false;
+
+    plan.slot_name   = slot.name;
+    plan.base_name   = slot.newest;
+    plan.rebase_name = slot.next;
+    plan.delta       = editor_settings.delta_backups;
+
+    return true;
+}
+
+FILDEF void backup_level_tab (Tab& tab, const std::string& file_name)
 {
-    // Determine how many backups the user wants saved for a given level.
-    int backup_count = editor_settings.backup_count;
-    if (backup_count <= 0) return; // No backups are wanted!
+    if (is_level_tab_loading(tab)) return;
 
-    std::string level_name((file_name.empty()) ? "untitled" : strip_file_path_and_ext(file_name));
+    // Don't fill the backup slots with copies of a level that hasn't changed.
+    u64 hash = get_level_hash(tab.level);
+    if (hash == tab.backup_hash) return;
 
-    // Create a folder for this particular level's backups if it does not exist.
-    // We make separate sub-folders in the backup directory for each level as
-    // there was an issue in older versions with the editor freezing when backing
-    // up levels to a backups folder with loads of saves. This was because the
-    // editor was searching the folder for old backups (leading to a freeze).
-    std::string backup_path(get_appdata_path() + BACKUPS_PATH + level_name + "/");
-    if (!does_path_exist(backup_path))
+    // The backup is written by the save worker from a snapshot, like saves,
+    // as rebuilding the delta chain of a large level can take a long while.
+    Level_Backup_Plan plan;
+    if (get_level_backup_plan(file_name, plan))
     {
-        if (!create_path(backup_path))
-        {
-            LOG_ERROR(ERR_MIN, "Failed to create backup for level \"%s\"!", level_name.c_str());
-            return;
-        }
+        tab.backup_hash = hash; // Put back if the backup ends up failing.
+        backup_level_async(tab.level, plan, tab.id, hash);
     }
+}
 
-    // Determine how many backups are already saved of this level.
-    std::vector<std::string> backups;
-    list_path_content(backup_path, backups);
-
-    int level_count = 0;
-    for (auto& file: backups)
+FILDEF void load_level_backup_tab (std::string file_name)
+{
+    // If there is just one tab and it is completely empty with no changes
+    // then we close this tab before opening the new level(s) in editor.
+    if (editor.tabs.size() == 1)
     {
-        if (is_file(file))
+        if (is_current_tab_empty() && !get_current_tab().unsaved_changes && get_current_tab().name.empty())
         {
-            // We strip extension twice because there are two extension parts to backups the .bak and the .lvl.
-            std::string compare_name(strip_file_ext(strip_file_path_and_ext(file)));
-            if (insensitive_compare(level_name, compare_name)) ++level_count;
+            close_current_tab();
         }
     }
 
-    // If there is still room to create a new backup then that is what
-    // we do. Otherwise, we overwrite the oldest backup of the level.
-    std::string backup_name = backup_path + level_name + ".bak";
-    if (editor_settings.unlimited_backups || (level_count < backup_count))
+    // Backups are restored into a new untitled tab so that saving the tab does
+    // not overwrite the backup file (or any of the backups that depend on it).
+    create_new_level_tab_and_focus();
+    Tab& tab = get_current_tab();
+    set_main_window_subtitle_for_tab(tab.name);
+
+    if (!load_level_backup(tab.level, fix_path_slashes(file_name)))
     {
-        backup_name += std::to_string(level_count) + ".lvl";
-        save_level(level, backup_name);
+        close_current_tab();
+        return;
     }
-    else
+
+    level_has_unsaved_changes();
+    need_to_scroll_next_update();
+}
+
+FILDEF void handle_completed_level_saves ()
+{
+    for (auto& result: get_completed_level_saves())
     {
-        u64 oldest = UINT64_MAX;
-        int oldest_index = 0;
+        // The backup ring only moves on to the next slot once the backup was
+        // written, a failed backup leaves the slot to be used again next time.
+        Tab* tab = NULL;
+        for (auto& t: editor.tabs)
+        {
+            if (t.id == result.tab_id && t.type == Tab_Type::LEVEL)
+            {
+                tab = &t;
+                break;
+            }
+        }
 
-        for (int i=0; i<level_count; ++i)
+        // The backup ring only moves on to the next slot once the backup was
+        // written, a failed backup leaves the slot to be used again next time.
+        if (!result.backup_name.empty())
         {
-            std::string name(backup_name + std::to_string(i) + ".lvl");
-            u64 current = last_file_write_time(name);
-            if (compare_file_write_times(current, oldest) == -1)
+            if (result.backed_up) commit_backup_slot(Backup_Type::LEVEL, result.backup_name);
+            else abandon_backup_slot(Backup_Type::LEVEL, result.backup_name);
+
+            if (!result.backed_up)
             {
-                oldest = current;
-                oldest_index = i;
+                if (result.success) LOG_ERROR(ERR_MIN, "Failed to write backup '%s'!", result.backup_name.c_str());
+                // So that the level gets backed up again the next time around.
+                if (tab && tab->backup_hash == result.hash) tab->backup_hash = 0;
             }
         }
 
-        backup_name += std::to_string(oldest_index) + ".lvl";
-        save_level(level, backup_name);
+        // Timed backups have no level file, so there's nothing more to do.
+        if (result.file_name.empty()) continue;
+
+        if (!result.success)
+        {
+            LOG_ERROR(ERR_MED, "Failed to save level file '%s'!", result.file_name.c_str());
+            continue;
+        }
+
+        // The file now holds the snapshot so the tab only has unsaved changes
+        // if the level differs from it, as long as the tab is still that file.
+        if (tab && tab->name == result.file_name)
+        {
+            tab->saved_hash = result.hash;
+            internal__update_level_unsaved_changes(*tab);
+        }
+    }
+}
+
+FILDEF void handle_completed_level_loads ()
+{
+    // Backwards as tabs whose level failed to load get closed along the way.
+    for (size_t i=editor.tabs.size(); i-- > 0;)
+    {
+        Tab& tab = editor.tabs.at(i);
+        if (!is_level_tab_loading(tab) || !tab.level_load->complete.load()) continue;
+
+        std::shared_ptr<Level_Load> load(std::move(tab.level_load));
+
+        if (!load->success)
+        {
+            if (!load->error.empty()) LOG_ERROR(ERR_MED, "%s", load->error.c_str());
+            close_tab(i);
+            continue;
+        }
+
+        // The whole level gets swapped in at once now that it is complete.
+        tab.level = std::move(load->level);
+        internal__set_level_tab_saved(tab);
+
+        const Level_Header& header = tab.level.header;
+        LOG_DEBUG("Level Header: v%d %dx%dx%d", header.version, header.width, header.height, header.layers);
     }
 }
 
+FILDEF bool is_level_tab_loading (const Tab& tab)
+{
+    return (tab.type == Tab_Type::LEVEL && tab.level_load);
+}
+
+FILDEF void cancel_level_tab_load ()
+{
+    if (!current_tab_is_level() || !is_level_tab_loading(get_current_tab())) return;
+    // Closing the tab cancels the load (see close_tab) and nothing has changed
+    // in the tab yet so there is no need to prompt the user to save anything.
+    get_current_tab().unsaved_changes = false;
+    close_current_tab();
+}
+
 FILDEF bool is_current_level_empty ()
 {
     if (are_there_any_level_tabs())
@@ -2254,7 +2955,7 @@ FILDEF bool is_current_level_empty ()
         {
             for (const auto& layer: tab.level.data)
             {
-                for (auto id: layer) if (id != 0) return false;
+                if (!is_tile_layer_empty(layer)) return false;
             }
             return true;
         }
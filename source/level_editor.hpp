@@ -7,9 +7,6 @@ struct Tab; // Defined in <editor.hpp>
 
 struct Tool_Fill
 {
-    std::vector<vec2> frontier;
-    std::vector<bool> searched;
-
     Level_Layer layer;
 
     Tile_ID find_id;
@@ -30,10 +27,39 @@ struct Select_Bounds
     bool visible;
 };
 
+// The union of all the visible select boxes, rasterized so that tools do not
+// have to test every box for every tile. It holds both a bitset (covering the
+// total select boundary) for checking single tiles and the selected spans of
+// each row, sorted and without overlaps, for tools that walk the selection.
+// The mask is rebuilt the first time it's requested after the select bounds
+// or the level size change (see get_select_mask), rather than on every change.
+
+struct Select_Mask
+{
+    // What the mask was last built from, so we can tell when it is stale.
+    std::vector<Select_Bounds> bounds;
+    int level_width;
+    int level_height;
+    bool built;
+
+    // The total select boundary, zero width and height if nothing is selected.
+    int x;
+    int y;
+    int w;
+    int h;
+
+    std::vector<u64> bits; // One bit per tile in the boundary, row-major.
+
+    std::vector<Tile_Span> spans; // Row-major order.
+    std::vector<size_t> rows; // The first span of each row in the boundary, plus one past the end.
+};
+
 struct Tool_Select
 {
     std::vector<Select_Bounds> bounds;
 
+    Select_Mask mask;
+
     bool start;
     bool add;
 
@@ -46,33 +72,25 @@ struct Tool_Info
     Tool_Select select;
 };
 
-enum class Level_History_Action
-{
-    NORMAL,
-    FLIP_LEVEL_H,
-    FLIP_LEVEL_V,
-    SELECT_STATE,
-    CLEAR,
-    RESIZE
-};
+// A part of the level that was cropped away by a resize, the rest of the level
+// can be rebuilt from the resized level so only these parts need to be kept.
 
-struct Level_History_Info
+struct Level_History_Crop
 {
+    // Where it was in the level before the resize.
     int x;
     int y;
+    int w;
+    int h;
 
-    Tile_ID old_id;
-    Tile_ID new_id;
-
-    Level_Layer tile_layer;
+    Level_Data data;
 };
 
-struct Level_History_State
-{
-    Level_History_Action action;
-
-    std::vector<Level_History_Info> info;
+// Everything that is only needed by some of the actions, so the states for
+// plain tile changes (by far the most common) don't have to carry it all.
 
+struct Level_History_Extra
+{
     // What layers were active at the time. Used by flips so only those
     // layers end up getting flipped during the undo and redo actions.
     bool tile_layer_active[LEVEL_LAYER_TOTAL];
@@ -90,17 +108,13 @@ struct Level_History_State
     int new_width;
     int new_height;
 
-    // The data of the level before and after a resize.
+    std::vector<Level_History_Crop> cropped; // Only the non-empty parts.
+
+    // The data of the level before and after a merge.
     Level_Data old_data;
     Level_Data new_data;
 };
 
-struct Level_History
-{
-    int current_position;
-    std::vector<Level_History_State> state;
-};
-
 GLOBAL constexpr float DEFAULT_TILE_SIZE      = 16;
 GLOBAL constexpr float DEFAULT_TILE_SIZE_HALF = DEFAULT_TILE_SIZE / 2;
 
@@ -135,6 +149,8 @@ struct Level_Editor
 
     quad bounds;
     quad viewport;
+
+    u64 history_group; // The last group given to linked history states.
 };
 
 GLOBAL Level_Editor level_editor;
@@ -149,7 +165,14 @@ FILDEF bool mouse_inside_level_editor_viewport ();
 FILDEF void new_level_history_state (Level_History_Action action);
 
 FILDEF void add_to_history_normal_state (Level_History_Info info);
-FILDEF void add_to_history_clear_state  (Level_History_Info info);
+// Adds all of the changes at once, used by tools that change many tiles in a
+// single go so that they only need to check and set up the state the once.
+FILDEF void add_to_history_normal_state (const std::vector<Level_History_Info>& info);
+FILDEF void add_to_history_normal_state (const std::vector<Level_History_Run >& runs);
+
+// Roughly how many bytes of memory a tab's undo history is using. When this
+// goes over the history memory limit setting the oldest states are dropped.
+FILDEF size_t get_level_history_memory (const Tab& tab);
 
 FILDEF bool are_all_layers_inactive ();
 
@@ -157,6 +180,9 @@ FILDEF bool are_any_select_boxes_visible ();
 FILDEF void get_ordered_select_bounds    (const Select_Bounds& bounds, int* l, int* t, int* r, int* b);
 FILDEF void get_total_select_boundary    (int* l, int* t, int* r, int* b);
 
+FILDEF const Select_Mask& get_select_mask  ();
+FILDEF bool               is_tile_selected (const Select_Mask& mask, int x, int y);
+
 FILDEF void load_level_tab (std::string file_name);
 
 FILDEF bool le_save            (Tab& level);
@@ -183,11 +209,25 @@ FILDEF void le_history_end   ();
 FILDEF void le_resize      ();
 FILDEF void le_resize_okay ();
 
+// Three-way merges another version of the level into the current tab (see
+// <level_merge.hpp>) and selects all of the tiles that ended up conflicting.
+FILDEF void le_merge ();
+
 FILDEF void le_load_prev_level ();
 FILDEF void le_load_next_level ();
 
 FILDEF void level_drop_file (Tab* tab, std::string file_name);
 
-FILDEF void backup_level_tab (const Level& level, const std::string& file_name);
+FILDEF bool get_level_backup_plan (const std::string& file_name, Level_Backup_Plan& plan);
+FILDEF void backup_level_tab      (Tab& tab, const std::string& file_name);
+FILDEF void load_level_backup_tab (std::string file_name);
+
+FILDEF void handle_completed_level_saves ();
+FILDEF void handle_completed_level_loads ();
+
+// Levels are loaded in the background (see load_level_async) and the tab
+// cannot be edited or saved until the loaded level has been swapped in.
+FILDEF bool is_level_tab_loading  (const Tab& tab);
+FILDEF void cancel_level_tab_load ();
 
 FILDEF bool is_current_level_empty ();
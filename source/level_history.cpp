@@ -0,0 +1,116 @@
+// Packs the tile changes of a finished state into runs and frees everything
+// that was only needed while recording. The changes are kept in the order they
+// were made, which is mostly row order anyway, so the runs can be built in a
+// single pass and undoing them in reverse is right even if tiles repeat.
+
+FILDEF void pack_level_history_state (Level_History_State& state)
+{
+    if (!state.info.empty())
+    {
+        for (auto& info: state.info)
+        {
+            if (info.old_id == info.new_id) continue; // Placed then put back.
+
+            if (!state.runs.empty())
+            {
+                Level_History_Run& run = state.runs.back();
+                if (run.tile_layer == info.tile_layer && run.y == info.y && (run.x+run.length) == info.x &&
+                    run.old_id == info.old_id && run.new_id == info.new_id && run.length < UINT16_MAX)
+                {
+                    ++run.length;
+                    continue;
+                }
+            }
+
+            Level_History_Run run;
+            run.x          = CAST(u16, info.x);
+            run.y          = CAST(u16, info.y);
+            run.length     = 1;
+            run.tile_layer = CAST(u16, info.tile_layer);
+            run.old_id     = info.old_id;
+            run.new_id     = info.new_id;
+            state.runs.push_back(run);
+        }
+
+        state.runs.shrink_to_fit();
+        std::vector<Level_History_Info>().swap(state.info);
+    }
+
+    std::unordered_map<u64, size_t>().swap(state.info_index);
+    state.indexed = false;
+}
+
+// Turns a packed state back into a list of tile changes so more can be added.
+FILDEF void unpack_level_history_state (Level_History_State& state)
+{
+    for (auto& run: state.runs)
+    {
+        for (int i=0; i<run.length; ++i)
+        {
+            Level_History_Info info = {};
+            info.x                  = run.x+i;
+            info.y                  = run.y;
+            info.old_id             = run.old_id;
+            info.new_id             = run.new_id;
+            info.tile_layer         = run.tile_layer;
+            state.info.push_back(info);
+        }
+    }
+    std::vector<Level_History_Run>().swap(state.runs);
+    state.memory = 0;
+}
+
+FILDEF void apply_level_history_runs (Level_Data& data, const Level_History_State& state, bool undo)
+{
+    std::vector<Tile_ID> tiles;
+    auto apply = [&](const Level_History_Run& run)
+    {
+        tiles.assign(run.length, (undo) ? run.old_id : run.new_id);
+        write_tile_row(data[run.tile_layer], run.x, run.y, run.length, &tiles[0]);
+    };
+    if (undo) for (auto i=state.runs.rbegin(); i!=state.runs.rend(); ++i) apply(*i);
+    else      for (auto i=state.runs.begin (); i!=state.runs.end (); ++i) apply(*i);
+}
+
+FILDEF u64 internal__get_history_info_key (const Level_History_Info& info)
+{
+    return ((CAST(u64, info.tile_layer) << 48) | (CAST(u64, CAST(u32, info.y)) << 24) | CAST(u64, CAST(u32, info.x)));
+}
+
+FILDEF void add_level_history_info (Level_History_State& state, const Level_History_Info& info)
+{
+    // The index is freed once a state is finished, so rebuild it if needed.
+    if (!state.indexed)
+    {
+        unpack_level_history_state(state);
+
+        state.info_index.clear();
+        state.info_index.reserve(state.info.size());
+        for (size_t i=0; i<state.info.size(); ++i)
+        {
+            state.info_index[internal__get_history_info_key(state.info[i])] = i;
+        }
+        state.indexed = true;
+    }
+
+    // Don't add the same spawns/tiles repeatedly, otherwise add the spawn/tile.
+    // Placing over a tile again keeps its original old_id and takes the new_id.
+    u64 key = internal__get_history_info_key(info);
+    auto it = state.info_index.find(key);
+    if (it != state.info_index.end())
+    {
+        state.info[it->second].new_id = info.new_id;
+        return;
+    }
+
+    state.info_index.emplace(key, state.info.size());
+    state.info.push_back(info);
+}
+
+FILDEF void add_level_history_runs (Level_History_State& state, const std::vector<Level_History_Run>& runs)
+{
+    // Anything recorded so far comes first, so the changes stay in order.
+    pack_level_history_state(state);
+    state.runs.insert(state.runs.end(), runs.begin(), runs.end());
+    state.memory = 0; // Still being added to.
+}
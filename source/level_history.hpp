@@ -0,0 +1,94 @@
+#pragma once
+
+// The tile changes recorded by the level editor's undo/redo history. This part
+// doesn't depend on the editor (only on the level data) so that the level tool
+// can benchmark the recording, packing and undoing of changes as well.
+
+enum class Level_History_Action
+{
+    NORMAL,
+    FLIP_LEVEL_H,
+    FLIP_LEVEL_V,
+    SELECT_STATE,
+    CLEAR,
+    RESIZE,
+    MERGE
+};
+
+struct Level_History_Info
+{
+    int x;
+    int y;
+
+    Tile_ID old_id;
+    Tile_ID new_id;
+
+    Level_Layer tile_layer;
+};
+
+// Tile changes are recorded one tile at a time while a state is still being
+// added to, then once the state is done they get packed down into runs of
+// neighbouring tiles on a row that share the same old and new IDs. So fills
+// only end up costing a single run for each row they touch. Pastes and clears
+// write whole blocks of tiles and so they add their runs to the state directly.
+
+struct Level_History_Run
+{
+    u16 x;
+    u16 y;
+    u16 length;
+    u16 tile_layer;
+
+    Tile_ID old_id;
+    Tile_ID new_id;
+};
+
+STATIC_ASSERT(MAXIMUM_LEVEL_WIDTH <= UINT16_MAX && MAXIMUM_LEVEL_HEIGHT <= UINT16_MAX, "History runs store positions as u16!");
+
+struct Level_History_Extra; // Defined in <level_editor.hpp>
+
+struct Level_History_State
+{
+    Level_History_Action action;
+
+    std::vector<Level_History_Info> info; // Only while being added to.
+    std::vector<Level_History_Run>  runs; // Once it has been packed.
+
+    // Where each tile (keyed by its position and layer) is in the info list,
+    // so placing over the same tile again updates it in constant time. Only
+    // needed while the state is still being added to so it is freed after.
+    std::unordered_map<u64, size_t> info_index;
+    bool indexed = false;
+
+    std::shared_ptr<Level_History_Extra> extra; // NULL for normal states.
+
+    // States made in several tabs by one action (e.g. replacing in all tabs)
+    // share a non-zero group, so that undoing or redoing the action in any of
+    // the tabs also undoes or redoes it in the others (if still the latest).
+    u64 group = 0;
+
+    // How many bytes the state takes up once it has been packed.
+    size_t memory = 0;
+};
+
+struct Level_History
+{
+    int current_position;
+    std::vector<Level_History_State> state;
+};
+
+// Adds a tile change to a state that is still being added to. Placing over the
+// same tile again keeps the change's old_id and takes the new_id, through an
+// index of the changes by position so that long strokes stay linear.
+FILDEF void add_level_history_info (Level_History_State& state, const Level_History_Info& info);
+
+// Adds runs of changes straight to the state without them going through the
+// index, so tools that write whole blocks at once don't pay for every tile.
+FILDEF void add_level_history_runs (Level_History_State& state, const std::vector<Level_History_Run>& runs);
+
+FILDEF void   pack_level_history_state (Level_History_State& state);
+FILDEF void unpack_level_history_state (Level_History_State& state);
+
+// Writes the packed runs of the state into the level data, either as they were
+// before the changes (in reverse order) or after them (in the order made).
+FILDEF void apply_level_history_runs (Level_Data& data, const Level_History_State& state, bool undo);
@@ -0,0 +1,557 @@
+// The index files are laid out as follows (all little-endian):
+//
+//   u32 magic, u32 version, string path, u64 folder write time, u32 entry count
+//   (for each entry) string name, u64 write time, u64 file size, u8 valid,
+//                    u8 analysed, s32 width, s32 height, u64 hash, u32 histogram count,
+//                    (for each histogram bin) s32 tile ID, u32 count
+//
+// Strings are stored as a u32 length that is followed by the characters.
+
+GLOBAL constexpr u32 LEVEL_INDEX_MAGIC   = 0x58494C54; // "TLIX"
+GLOBAL constexpr u32 LEVEL_INDEX_VERSION = 2;
+
+// Indices are kept in memory after first use so they're only read once.
+GLOBAL std::map<std::string, Level_Index> level_indices;
+
+// A single worker that decodes levels to fill in their hash and histogram.
+// Jobs and results are copies of the entries (plus the path of the folder)
+// so the worker never touches the indices, which belong to the main thread.
+
+struct Level_Index_Job
+{
+    std::string path;
+    Level_Index_Entry entry;
+};
+
+struct Level_Indexer
+{
+    SDL_Thread* thread;
+    SDL_mutex*  mutex;
+    SDL_cond*   work;
+
+    std::deque<Level_Index_Job> queue;
+    std::vector<Level_Index_Job> results;
+
+    bool busy;
+    bool quit;
+};
+
+GLOBAL Level_Indexer level_indexer;
+
+FILDEF void internal__index_put (std::vector<u8>& buffer, u64 value, int bytes)
+{
+    for (int i=0; i<bytes; ++i) buffer.push_back(CAST(u8, value >> (i*8)));
+}
+
+FILDEF void internal__index_put (std::vector<u8>& buffer, const std::string& str)
+{
+    internal__index_put(buffer, str.length(), sizeof(u32));
+    buffer.insert(buffer.end(), str.begin(), str.end());
+}
+
+FILDEF bool internal__index_get (const std::vector<u8>& buffer, size_t& cursor, u64& value, int bytes)
+{
+    if (buffer.size() - cursor < CAST(size_t, bytes)) return false;
+    value = 0;
+    for (int i=0; i<bytes; ++i) value |= CAST(u64, buffer[cursor++]) << (i*8);
+    return true;
+}
+
+FILDEF bool internal__index_get (const std::vector<u8>& buffer, size_t& cursor, std::string& str)
+{
+    u64 length;
+    if (!internal__index_get(buffer, cursor, length, sizeof(u32))) return false;
+    if (buffer.size() - cursor < length) return false;
+    str.assign(CAST(const char*, &buffer[cursor]), length);
+    cursor += length;
+    return true;
+}
+
+FILDEF std::string internal__get_level_index_file_name (const std::string& path)
+{
+    // The folder path is hashed (FNV-1a) to get a unique name for the index.
+    u64 hash = 0xCBF29CE484222325ULL;
+    for (char c: path) hash = (hash ^ CAST(u8, c)) * 0x100000001B3ULL;
+    return get_appdata_path() + LEVEL_INDEX_PATH + format_string("%016llx", CAST(unsigned long long, hash)) + ".index";
+}
+
+FILDEF u64 internal__get_index_write_time (std::filesystem::file_time_type time)
+{
+    return CAST(u64, std::chrono::time_point_cast<std::chrono::milliseconds>(time).time_since_epoch().count());
+}
+
+FILDEF bool internal__sort_level_index_entries (const Level_Index_Entry& a, const Level_Index_Entry& b)
+{
+    // Levels are browsed in the order of their names without the extension.
+    return (strip_file_ext(a.name) < strip_file_ext(b.name));
+}
+
+FILDEF bool internal__load_level_index (Level_Index& index)
+{
+    FILE* file = fopen(internal__get_level_index_file_name(index.path).c_str(), "rb");
+    if (!file) return false;
+    defer { fclose(file); };
+
+    std::vector<u8> buffer(get_size_of_file(file));
+    if (buffer.empty() || fread(&buffer[0], sizeof(u8), buffer.size(), file) != buffer.size()) return false;
+
+    size_t cursor = 0;
+    u64 magic, version, count;
+    std::string path;
+
+    if (!internal__index_get(buffer, cursor, magic,   sizeof(u32)) || magic   != LEVEL_INDEX_MAGIC  ) return false;
+    if (!internal__index_get(buffer, cursor, version, sizeof(u32)) || version != LEVEL_INDEX_VERSION) return false;
+
+    // Different folders could hash to the same index file name.
+    if (!internal__index_get(buffer, cursor, path) || path != index.path) return false;
+
+    u64 write_time;
+    if (!internal__index_get(buffer, cursor, write_time, sizeof(u64))) return false;
+    if (!internal__index_get(buffer, cursor, count,      sizeof(u32))) return false;
+
+    std::vector<Level_Index_Entry> entries;
+    for (u64 i=0; i<count; ++i)
+    {
+        Level_Index_Entry entry;
+        u64 valid, analysed, width, height, bins;
+        if (!internal__index_get(buffer, cursor, entry.name                   )) return false;
+        if (!internal__index_get(buffer, cursor, entry.write_time, sizeof(u64))) return false;
+        if (!internal__index_get(buffer, cursor, entry.file_size,  sizeof(u64))) return false;
+        if (!internal__index_get(buffer, cursor, valid,            sizeof(u8 ))) return false;
+        if (!internal__index_get(buffer, cursor, analysed,         sizeof(u8 ))) return false;
+        if (!internal__index_get(buffer, cursor, width,            sizeof(s32))) return false;
+        if (!internal__index_get(buffer, cursor, height,           sizeof(s32))) return false;
+        if (!internal__index_get(buffer, cursor, entry.hash,       sizeof(u64))) return false;
+        if (!internal__index_get(buffer, cursor, bins,             sizeof(u32))) return false;
+
+        entry.valid    = (valid    != 0);
+        entry.analysed = (analysed != 0);
+        entry.queued   = false;
+        entry.width  = CAST(s32, width);
+        entry.height = CAST(s32, height);
+
+        // Each bin is 8 bytes so this also stops us trusting a corrupt count.
+        if ((buffer.size() - cursor) / 8 < bins) return false;
+        entry.histogram.resize(bins);
+        for (auto& bin: entry.histogram)
+        {
+            u64 id, amount;
+            internal__index_get(buffer, cursor, id,     sizeof(s32));
+            internal__index_get(buffer, cursor, amount, sizeof(u32));
+            bin = { CAST(Tile_ID, id), CAST(u32, amount) };
+        }
+
+        entries.push_back(std::move(entry));
+    }
+
+    index.write_time = write_time;
+    index.entries = std::move(entries);
+    return true;
+}
+
+FILDEF void internal__save_level_index (const Level_Index& index)
+{
+    std::vector<u8> buffer;
+    internal__index_put(buffer, LEVEL_INDEX_MAGIC,   sizeof(u32));
+    internal__index_put(buffer, LEVEL_INDEX_VERSION, sizeof(u32));
+    internal__index_put(buffer, index.path);
+    internal__index_put(buffer, index.write_time,    sizeof(u64));
+    internal__index_put(buffer, index.entries.size(), sizeof(u32));
+    for (auto& entry: index.entries)
+    {
+        internal__index_put(buffer, entry.name);
+        internal__index_put(buffer, entry.write_time,       sizeof(u64));
+        internal__index_put(buffer, entry.file_size,        sizeof(u64));
+        internal__index_put(buffer, entry.valid,            sizeof(u8 ));
+        internal__index_put(buffer, entry.analysed,         sizeof(u8 ));
+        internal__index_put(buffer, CAST(u32, entry.width ), sizeof(s32));
+        internal__index_put(buffer, CAST(u32, entry.height), sizeof(s32));
+        internal__index_put(buffer, entry.hash,             sizeof(u64));
+        internal__index_put(buffer, entry.histogram.size(), sizeof(u32));
+        for (auto& bin: entry.histogram)
+        {
+            internal__index_put(buffer, CAST(u32, bin.first), sizeof(s32));
+            internal__index_put(buffer, bin.second,           sizeof(u32));
+        }
+    }
+
+    std::string index_path(get_appdata_path() + LEVEL_INDEX_PATH);
+    if (!does_path_exist(index_path))
+    {
+        if (!create_path(index_path))
+        {
+            LOG_ERROR(ERR_MIN, "Failed to create level index path!");
+            return;
+        }
+    }
+
+    std::string file_name(internal__get_level_index_file_name(index.path));
+    FILE* file = fopen(file_name.c_str(), "wb");
+    if (!file)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to save level index '%s'!", file_name.c_str());
+        return;
+    }
+    defer { fclose(file); };
+
+    fwrite(&buffer[0], sizeof(u8), buffer.size(), file);
+}
+
+FILDEF void internal__parse_level_index_entry (const std::string& file_name, Level_Index_Entry& entry)
+{
+    LOG_DEBUG("Indexing Level: %s", file_name.c_str());
+
+    // Only the header gets read here, the rest is left for the worker.
+    entry.valid    = false;
+    entry.analysed = false;
+    entry.queued   = false;
+    entry.width    = 0;
+    entry.height   = 0;
+    entry.hash     = 0;
+    entry.histogram.clear();
+
+    Level_Header header;
+    if (!load_level_header(header, file_name)) return;
+
+    entry.valid  = true;
+    entry.width  = header.width;
+    entry.height = header.height;
+}
+
+FILDEF void internal__analyse_level_index_entry (const std::string& file_name, Level_Index_Entry& entry)
+{
+    // Broken levels have nothing more to find out, but are still marked as
+    // analysed so that they don't keep getting handed to the worker.
+    entry.analysed = true;
+    if (!entry.valid) return;
+
+    Mapped_Level mapped;
+    if (!open_mapped_level(mapped, file_name)) { entry.valid = false; return; }
+    defer { close_mapped_level(mapped); };
+
+    Level level;
+    if (!load_mapped_level(mapped, level)) { entry.valid = false; return; }
+
+    entry.width  = level.header.width;
+    entry.height = level.header.height;
+    entry.hash   = get_level_hash(level);
+
+    std::map<Tile_ID, u32> histogram;
+    for (auto& layer: level.data)
+    {
+        for_each_tile_run(layer, [&](int x, int y, const Tile_ID* tiles, int count)
+        {
+            for (int i=0; i<count; ++i) if (tiles[i]) ++histogram[tiles[i]];
+        });
+    }
+    entry.histogram.assign(histogram.begin(), histogram.end());
+}
+
+STDDEF int internal__level_indexer_thread_main (void* user_data)
+{
+    while (true)
+    {
+        SDL_LockMutex(level_indexer.mutex);
+        while (level_indexer.queue.empty() && !level_indexer.quit)
+        {
+            SDL_CondWait(level_indexer.work, level_indexer.mutex);
+        }
+        if (level_indexer.quit)
+        {
+            SDL_UnlockMutex(level_indexer.mutex);
+            break;
+        }
+        Level_Index_Job job = std::move(level_indexer.queue.front());
+        level_indexer.queue.pop_front();
+        level_indexer.busy = true;
+        SDL_UnlockMutex(level_indexer.mutex);
+
+        internal__analyse_level_index_entry(job.path + job.entry.name, job.entry);
+
+        SDL_LockMutex(level_indexer.mutex);
+        level_indexer.results.push_back(std::move(job));
+        level_indexer.busy = false;
+        SDL_UnlockMutex(level_indexer.mutex);
+
+        push_editor_event(EDITOR_EVENT_LEVEL_INDEXED, NULL, NULL);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+FILDEF void internal__queue_level_index_entry (const Level_Index& index, Level_Index_Entry& entry)
+{
+    // If there's no worker the entries just stay without a hash/histogram.
+    if (!level_indexer.thread || entry.analysed || entry.queued) return;
+
+    entry.queued = true;
+
+    Level_Index_Job job;
+    job.path  = index.path;
+    job.entry = entry;
+
+    SDL_LockMutex(level_indexer.mutex);
+    level_indexer.queue.push_back(std::move(job));
+    SDL_CondSignal(level_indexer.work);
+    SDL_UnlockMutex(level_indexer.mutex);
+}
+
+FILDEF bool internal__refresh_level_index (Level_Index& index)
+{
+    std::error_code error;
+
+    // If the folder hasn't changed then no levels have been added, removed or
+    // saved by the editor (saves replace the file which updates the folder).
+    // We still check every file once per session in case they were modified
+    // in-place by something else, as that does not update the folder's time.
+    auto path_time = std::filesystem::last_write_time(index.path, error);
+    if (error) return false;
+    u64 write_time = internal__get_index_write_time(path_time);
+    if (index.validated && index.write_time == write_time) return false;
+
+    std::vector<Level_Index_Entry> entries;
+    try
+    {
+        for (auto& it: std::filesystem::directory_iterator(index.path, error))
+        {
+            if (!it.is_regular_file(error) || it.path().extension() != ".lvl") continue;
+
+            Level_Index_Entry entry;
+            entry.name = it.path().filename().string();
+
+            auto file_time = it.last_write_time(error);
+            if (error) continue;
+            entry.write_time = internal__get_index_write_time(file_time);
+            entry.file_size = CAST(u64, it.file_size(error));
+            if (error) continue;
+
+            // Only levels that are new or have changed since last time get parsed.
+            auto old = std::find_if(index.entries.begin(), index.entries.end(),
+            [&](const Level_Index_Entry& e)
+            {
+                return (e.name == entry.name);
+            });
+            if (old != index.entries.end() && old->write_time == entry.write_time && old->file_size == entry.file_size)
+            {
+                internal__queue_level_index_entry(index, *old);
+                entries.push_back(std::move(*old));
+                continue;
+            }
+
+            internal__parse_level_index_entry(index.path + entry.name, entry);
+            internal__queue_level_index_entry(index, entry);
+            entries.push_back(std::move(entry));
+        }
+    }
+    catch (std::filesystem::filesystem_error& e)
+    {
+        LOG_ERROR(ERR_MIN, "File System Error: %s", e.what());
+        return false;
+    }
+
+    std::sort(entries.begin(), entries.end(), internal__sort_level_index_entries);
+
+    index.entries = std::move(entries);
+    index.write_time = write_time;
+    index.validated = true;
+    index.dirty = true;
+
+    return true;
+}
+
+FILDEF Level_Index& internal__get_cached_level_index (std::string path)
+{
+    path = fix_path_slashes(path);
+    if (!path.empty() && path.back() != '/') path.push_back('/');
+
+    auto it = level_indices.find(path);
+    if (it != level_indices.end()) return it->second;
+
+    Level_Index& index = level_indices[path];
+    index.path = path;
+    index.write_time = 0;
+    index.validated = false;
+    index.dirty = false;
+
+    // A missing or corrupt index is fine as the refresh will just rebuild it.
+    if (!internal__load_level_index(index))
+    {
+        index.write_time = 0;
+        index.entries.clear();
+    }
+
+    return index;
+}
+
+FILDEF const Level_Index& get_level_index (std::string path)
+{
+    Level_Index& index = internal__get_cached_level_index(path);
+    internal__refresh_level_index(index);
+    return index;
+}
+
+FILDEF void update_level_index (std::string file_name)
+{
+    file_name = fix_path_slashes(file_name);
+    size_t dot = file_name.find_last_of(".");
+    if (dot == std::string::npos || file_name.substr(dot) != ".lvl") return;
+
+    std::error_code error;
+    auto file_time = std::filesystem::last_write_time(file_name, error);
+    if (error) return;
+    u64 file_size = CAST(u64, std::filesystem::file_size(file_name, error));
+    if (error) return;
+
+    Level_Index& index = internal__get_cached_level_index(strip_file_name(file_name));
+
+    Level_Index_Entry entry;
+    entry.name       = strip_file_path(file_name);
+    entry.write_time = internal__get_index_write_time(file_time);
+    entry.file_size  = file_size;
+
+    auto old = std::find_if(index.entries.begin(), index.entries.end(),
+    [&](const Level_Index_Entry& e)
+    {
+        return (e.name == entry.name);
+    });
+
+    // Nothing to do if the index already knows about this version of the file.
+    if (old != index.entries.end() && old->write_time == entry.write_time && old->file_size == entry.file_size)
+    {
+        return;
+    }
+
+    internal__parse_level_index_entry(file_name, entry);
+
+    if (old != index.entries.end()) old = index.entries.erase(old);
+    old = index.entries.insert(std::upper_bound(index.entries.begin(), index.entries.end(), entry, internal__sort_level_index_entries), std::move(entry));
+
+    internal__queue_level_index_entry(index, *old);
+
+    index.dirty = true;
+}
+
+FILDEF bool init_level_indexer ()
+{
+    level_indexer.busy = false;
+    level_indexer.quit = false;
+
+    level_indexer.mutex = SDL_CreateMutex();
+    level_indexer.work  = SDL_CreateCond();
+
+    if (!level_indexer.mutex || !level_indexer.work)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to create level indexer sync objects! (%s)", SDL_GetError());
+        return false;
+    }
+
+    level_indexer.thread = SDL_CreateThread(internal__level_indexer_thread_main, "IndexLevels", NULL);
+    if (!level_indexer.thread)
+    {
+        LOG_ERROR(ERR_MIN, "Failed to create level indexer thread! (%s)", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+FILDEF void quit_level_indexer ()
+{
+    if (level_indexer.thread)
+    {
+        // Unlike saves there's no need to finish the queued jobs, any entries
+        // that were left unanalysed just get queued again when next browsed.
+        SDL_LockMutex(level_indexer.mutex);
+        level_indexer.quit = true;
+        level_indexer.queue.clear();
+        SDL_CondSignal(level_indexer.work);
+        SDL_UnlockMutex(level_indexer.mutex);
+
+        SDL_WaitThread(level_indexer.thread, NULL);
+        level_indexer.thread = NULL;
+    }
+
+    handle_completed_level_indexing();
+
+    for (auto& it: level_indices)
+    {
+        if (it.second.dirty) internal__save_level_index(it.second);
+    }
+
+    if (level_indexer.work ) SDL_DestroyCond (level_indexer.work );
+    if (level_indexer.mutex) SDL_DestroyMutex(level_indexer.mutex);
+
+    level_indexer.work  = NULL;
+    level_indexer.mutex = NULL;
+}
+
+FILDEF void handle_completed_level_indexing ()
+{
+    if (!level_indexer.mutex) return;
+
+    std::vector<Level_Index_Job> results;
+
+    SDL_LockMutex(level_indexer.mutex);
+    results.swap(level_indexer.results);
+    bool idle = (level_indexer.queue.empty() && !level_indexer.busy);
+    SDL_UnlockMutex(level_indexer.mutex);
+
+    for (auto& result: results)
+    {
+        auto index = level_indices.find(result.path);
+        if (index == level_indices.end()) continue;
+
+        auto& entries = index->second.entries;
+        auto entry = std::find_if(entries.begin(), entries.end(),
+        [&](const Level_Index_Entry& e)
+        {
+            return (e.name == result.entry.name);
+        });
+
+        // The file may have been changed again since the job was queued, in
+        // which case the result is stale and a newer job will be along later.
+        if (entry == entries.end() || entry->write_time != result.entry.write_time || entry->file_size != result.entry.file_size)
+        {
+            continue;
+        }
+
+        *entry = std::move(result.entry);
+        entry->queued = false;
+
+        index->second.dirty = true;
+    }
+
+    // Each index only gets written once the worker has nothing left to do,
+    // rather than after every single level is loaded, saved or analysed.
+    if (idle)
+    {
+        for (auto& it: level_indices)
+        {
+            if (!it.second.dirty) continue;
+            internal__save_level_index(it.second);
+            it.second.dirty = false;
+        }
+    }
+}
+
+FILDEF std::string get_adjacent_indexed_level (std::string file_name, int offset)
+{
+    const Level_Index& index = get_level_index(strip_file_name(file_name));
+
+    const auto& entries = index.entries;
+    if (entries.size() <= 1) return std::string();
+
+    std::string name(strip_file_path(file_name));
+    auto it = std::find_if(entries.begin(), entries.end(),
+    [&](const Level_Index_Entry& e)
+    {
+        return (e.name == name);
+    });
+    if (it == entries.end()) return std::string(); // Shouldn't happen...
+
+    int count = CAST(int, entries.size());
+    int position = CAST(int, it - entries.begin());
+    position = ((position + offset) % count + count) % count;
+
+    return index.path + entries[position].name;
+}
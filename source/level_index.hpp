@@ -0,0 +1,64 @@
+#pragma once
+
+// Each folder of levels that gets browsed has an index stored in the appdata
+// that caches the metadata of every level in the folder (dimensions, content
+// hash, tile histogram). This means stepping through the levels of a mod does
+// not need to re-list, stat and sort the folder, or parse any of the levels,
+// every single time. The index is kept up to date incrementally: the folder
+// is only re-listed when it changes and only new/modified levels get parsed.
+//
+// Browsing only needs the listing so that, plus the header of any new levels,
+// is all that's done on the calling thread. The hash and histogram of a level
+// are worked out on a background worker and filled in once they're ready, and
+// changed indices are only written back once that worker has gone idle.
+
+struct Level_Index_Entry
+{
+    std::string name; // The file name without the path.
+
+    u64 write_time;
+    u64 file_size;
+
+    bool valid; // False if the level could not be parsed (we still list it).
+    bool analysed; // If the hash and histogram below have been worked out yet.
+    bool queued;   // If the entry is waiting on the worker (not saved).
+
+    s32 width;
+    s32 height;
+    u64 hash; // See get_level_hash.
+
+    // How many of each tile are placed in the level (across all of the
+    // layers), sorted by the tile ID. Empty tiles are not included.
+    std::vector<std::pair<Tile_ID, u32>> histogram;
+};
+
+struct Level_Index
+{
+    std::string path;
+    u64 write_time; // Of the folder when it was last listed.
+
+    // Sorted in the same order the level files are browsed in.
+    std::vector<Level_Index_Entry> entries;
+
+    bool validated; // If the entries have been checked against the files this session.
+    bool dirty;     // If the entries have changed since the index was last saved.
+};
+
+// The worker is shut down before the editor quits, which also saves any of
+// the indices that have changed. Unfinished entries are picked up next time.
+FILDEF bool init_level_indexer ();
+FILDEF void quit_level_indexer ();
+
+// Fills in any entries that the worker has finished with since last called.
+FILDEF void handle_completed_level_indexing ();
+
+// Returns the index for a folder, bringing it up to date first if needed.
+FILDEF const Level_Index& get_level_index (std::string path);
+
+// Records a level that has just been loaded or saved so the index picks up
+// the new version of it without having to re-list the folder it is in.
+FILDEF void update_level_index (std::string file_name);
+
+// Gets the level offset from the given level within the same folder, wrapping
+// around at either end. Returns an empty string if there is no other level.
+FILDEF std::string get_adjacent_indexed_level (std::string file_name, int offset);
@@ -0,0 +1,202 @@
+FILDEF void internal__add_merge_indices (std::vector<int>& indices, int offset, int mask)
+{
+    for (int i=0; mask; ++i, mask>>=1)
+    {
+        if (mask & 1) indices.push_back(offset+i);
+    }
+}
+
+// Compares a packed block of tiles from each of the levels. The indices of the
+// tiles we left the same as the base but they changed are added to changes and
+// the indices of tiles that all three disagree on are added to the conflicts.
+// Both are usually rare so only the masks of each vector of tiles are checked.
+
+STDDEF void internal__merge_tiles (const Tile_ID* base, const Tile_ID* ours, const Tile_ID* theirs, int count,
+                                   std::vector<int>& changes, std::vector<int>& conflicts)
+{
+    int i = 0;
+
+    #if defined(SIMD_AVX2)
+    for (; (i+8)<=count; i+=8)
+    {
+        __m256i b = _mm256_loadu_si256(CAST(const __m256i*, base  +i));
+        __m256i o = _mm256_loadu_si256(CAST(const __m256i*, ours  +i));
+        __m256i t = _mm256_loadu_si256(CAST(const __m256i*, theirs+i));
+        __m256i ob = _mm256_cmpeq_epi32(o, b);
+        __m256i tb = _mm256_cmpeq_epi32(t, b);
+        __m256i ot = _mm256_cmpeq_epi32(o, t);
+        int same = _mm256_movemask_ps(_mm256_castsi256_ps(ot));
+        if (same == 0xFF) continue; // Nothing to do if ours and theirs agree.
+        int change   = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(ot, ob)));
+        int conflict = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_or_si256(ob, tb), ot)));
+        if (change) internal__add_merge_indices(changes, i, change);
+        if (conflict != 0xFF) internal__add_merge_indices(conflicts, i, ~conflict & 0xFF);
+    }
+    #elif defined(SIMD_SSE2)
+    for (; (i+4)<=count; i+=4)
+    {
+        __m128i b = _mm_loadu_si128(CAST(const __m128i*, base  +i));
+        __m128i o = _mm_loadu_si128(CAST(const __m128i*, ours  +i));
+        __m128i t = _mm_loadu_si128(CAST(const __m128i*, theirs+i));
+        __m128i ob = _mm_cmpeq_epi32(o, b);
+        __m128i tb = _mm_cmpeq_epi32(t, b);
+        __m128i ot = _mm_cmpeq_epi32(o, t);
+        int same = _mm_movemask_ps(_mm_castsi128_ps(ot));
+        if (same == 0xF) continue; // Nothing to do if ours and theirs agree.
+        int change   = _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(ot, ob)));
+        int conflict = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_or_si128(ob, tb), ot)));
+        if (change) internal__add_merge_indices(changes, i, change);
+        if (conflict != 0xF) internal__add_merge_indices(conflicts, i, ~conflict & 0xF);
+    }
+    #elif defined(SIMD_NEON)
+    for (; (i+4)<=count; i+=4)
+    {
+        int32x4_t b = vld1q_s32(base  +i);
+        int32x4_t o = vld1q_s32(ours  +i);
+        int32x4_t t = vld1q_s32(theirs+i);
+        uint32x4_t ob = vceqq_s32(o, b);
+        uint32x4_t tb = vceqq_s32(t, b);
+        uint32x4_t ot = vceqq_s32(o, t);
+        // Nothing to do if ours and theirs agree.
+        uint32x2_t same = vand_u32(vget_low_u32(ot), vget_high_u32(ot));
+        if ((vget_lane_u32(same,0) & vget_lane_u32(same,1)) == 0xFFFFFFFF) continue;
+        uint32x4_t ch = vbicq_u32(ob, ot);
+        uint32x4_t cf = vmvnq_u32(vorrq_u32(vorrq_u32(ob, tb), ot));
+        int change   = ((vgetq_lane_u32(ch,0) & 1)     ) | ((vgetq_lane_u32(ch,1) & 1) << 1) |
+                       ((vgetq_lane_u32(ch,2) & 1) << 2) | ((vgetq_lane_u32(ch,3) & 1) << 3);
+        int conflict = ((vgetq_lane_u32(cf,0) & 1)     ) | ((vgetq_lane_u32(cf,1) & 1) << 1) |
+                       ((vgetq_lane_u32(cf,2) & 1) << 2) | ((vgetq_lane_u32(cf,3) & 1) << 3);
+        if (change  ) internal__add_merge_indices(changes,   i, change  );
+        if (conflict) internal__add_merge_indices(conflicts, i, conflict);
+    }
+    #endif
+
+    // Handle whatever is left over that could not fill a full vector.
+    for (; i<count; ++i)
+    {
+        if (ours[i] == theirs[i]) continue;
+        if (ours[i] == base[i]) changes.push_back(i);
+        else if (theirs[i] != base[i]) conflicts.push_back(i);
+    }
+}
+
+STDDEF bool merge_levels (const Level& base, const Level& ours, const Level& theirs,
+                          Level& merged, std::vector<Level_Merge_Conflict>& conflicts,
+                          std::string& error)
+{
+    conflicts.clear();
+
+    if (ours.header.width  != base.header.width  || theirs.header.width  != base.header.width ||
+        ours.header.height != base.header.height || theirs.header.height != base.header.height)
+    {
+        error = "Levels must all be the same size to be merged!";
+        return false;
+    }
+
+    // Copying is cheap as the chunks are shared until the merge writes to them.
+    merged = ours;
+
+    std::vector<Tile_ID> base_tiles  (TILE_CHUNK_AREA);
+    std::vector<Tile_ID> our_tiles   (TILE_CHUNK_AREA);
+    std::vector<Tile_ID> their_tiles (TILE_CHUNK_AREA);
+
+    std::vector<int> change_indices;
+    std::vector<int> conflict_indices;
+
+    for (Level_Layer l=0; l<LEVEL_LAYER_TOTAL; ++l)
+    {
+        const Tile_Layer& b = base  .data[l];
+        const Tile_Layer& o = ours  .data[l];
+        const Tile_Layer& t = theirs.data[l];
+
+        // The layer hashes let us skip layers that one side never touched, the
+        // editor already trusts them to tell if a level has unsaved changes.
+        if (get_tile_layer_hash(t) == get_tile_layer_hash(b)) continue;
+        if (get_tile_layer_hash(o) == get_tile_layer_hash(b))
+        {
+            // Their layer is taken as it is, but only the chunks that actually
+            // differ are written so the rest stay shared with our layer (which
+            // keeps the history of the merge down to just the changed chunks).
+            for (int cy=0; cy<t.chunks_h; ++cy)
+            {
+                for (int cx=0; cx<t.chunks_w; ++cx)
+                {
+                    if (is_tile_chunk_shared(o, t, cx, cy)) continue; // Empty in both.
+
+                    int x = cx << TILE_CHUNK_SHIFT;
+                    int y = cy << TILE_CHUNK_SHIFT;
+                    int w = std::min(TILE_CHUNK_SIZE, t.width  - x);
+                    int h = std::min(TILE_CHUNK_SIZE, t.height - y);
+
+                    read_tile_rect(o, x, y, w, h, &our_tiles  [0]);
+                    read_tile_rect(t, x, y, w, h, &their_tiles[0]);
+
+                    if (memcmp(&our_tiles[0], &their_tiles[0], w*h*sizeof(Tile_ID)) != 0)
+                    {
+                        write_tile_rect(merged.data[l], x, y, w, h, &their_tiles[0]);
+                    }
+                }
+            }
+            continue;
+        }
+
+        size_t layer_conflicts = conflicts.size();
+
+        for (int cy=0; cy<b.chunks_h; ++cy)
+        {
+            for (int cx=0; cx<b.chunks_w; ++cx)
+            {
+                // Chunks that are still shared with the base (or are empty in
+                // both) were not changed so do not need comparing tile-by-tile.
+                if (is_tile_chunk_shared(b, t, cx, cy)) continue;
+
+                int x = cx << TILE_CHUNK_SHIFT;
+                int y = cy << TILE_CHUNK_SHIFT;
+                int w = std::min(TILE_CHUNK_SIZE, b.width  - x);
+                int h = std::min(TILE_CHUNK_SIZE, b.height - y);
+
+                if (is_tile_chunk_shared(b, o, cx, cy))
+                {
+                    read_tile_rect(t, x, y, w, h, &their_tiles[0]);
+                    write_tile_rect(merged.data[l], x, y, w, h, &their_tiles[0]);
+                    continue;
+                }
+
+                read_tile_rect(b, x, y, w, h, &base_tiles [0]);
+                read_tile_rect(o, x, y, w, h, &our_tiles  [0]);
+                read_tile_rect(t, x, y, w, h, &their_tiles[0]);
+
+                change_indices.clear();
+                conflict_indices.clear();
+
+                internal__merge_tiles(&base_tiles[0], &our_tiles[0], &their_tiles[0], w*h, change_indices, conflict_indices);
+
+                for (int index: change_indices)
+                {
+                    set_tile(merged.data[l], x + (index % w), y + (index / w), their_tiles[index]);
+                }
+
+                for (int index: conflict_indices)
+                {
+                    Level_Merge_Conflict conflict;
+                    conflict.layer  = l;
+                    conflict.x      = x + (index % w);
+                    conflict.y      = y + (index / w);
+                    conflict.base   = base_tiles [index];
+                    conflict.ours   = our_tiles  [index]; // Conflicting tiles are left as ours.
+                    conflict.theirs = their_tiles[index];
+                    conflicts.push_back(conflict);
+                }
+            }
+        }
+
+        // The layer was walked chunk-by-chunk so put its conflicts in row order.
+        std::sort(conflicts.begin()+layer_conflicts, conflicts.end(),
+        [](const Level_Merge_Conflict& a, const Level_Merge_Conflict& b)
+        {
+            return ((a.y < b.y) || (a.y == b.y && a.x < b.x));
+        });
+    }
+
+    return true;
+}
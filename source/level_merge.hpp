@@ -0,0 +1,29 @@
+#pragma once
+
+// Three-way merging of levels for when multiple people have edited the same
+// level file. The two edited versions ("ours" and "theirs") are compared with
+// the version they both started from ("base"). Any tile that only one side
+// changed takes that change and tiles that both sides changed to the same ID
+// are kept as they are. If both sides changed a tile to different IDs then it
+// is a conflict: the merged level keeps our tile and the conflict is listed so
+// that it can be resolved by hand.
+
+struct Level_Merge_Conflict
+{
+    Level_Layer layer;
+
+    int x;
+    int y;
+
+    Tile_ID base;
+    Tile_ID ours;
+    Tile_ID theirs;
+};
+
+// The three levels must all be the same size, otherwise the merge fails and
+// the reason is passed back through the error string. Does not report any
+// errors itself so it is safe to call from threads other than the main one.
+// The conflicts are sorted by layer and then in row-major order.
+STDDEF bool merge_levels (const Level& base, const Level& ours, const Level& theirs,
+                          Level& merged, std::vector<Level_Merge_Conflict>& conflicts,
+                          std::string& error);
@@ -0,0 +1,1186 @@
+// A headless command-line tool for checking and processing levels in bulk so
+// that build pipelines do not have to open every level in the editor. This is
+// a separate unity build from the editor (see build/linux/build_level_tool.sh)
+// that reuses the level code but does not need SDL or any windowing to run.
+//
+// Each file is handled on a pool of worker threads and the results are then
+// printed in the order the files were passed in, so the output is stable.
+
+#define BUILD_HEADLESS
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <ctime>
+#include <cstring>
+#include <cstdarg>
+
+#include <filesystem>
+#include <type_traits>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <random>
+
+#include <vector>
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <set>
+#include <deque>
+#include <string>
+#include <stack>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+#include <glm/glm.hpp>
+
+// Only the headers are needed for the inline byte swapping and declarations,
+// none of the SDL functions get called so the library is never linked in.
+#include <SDL2/SDL.h>
+
+#include <gon/gon.h>
+#include <gon/gon.cpp>
+
+#include "utility.hpp"
+#include "debug.hpp"
+#include "error.hpp"
+#include "platform.hpp"
+#include "tile_layer.hpp"
+#include "level.hpp"
+#include "level_merge.hpp"
+#include "level_history.hpp"
+
+// The editor's debug/error systems show alerts and write logs into the appdata
+// so the tool has its own versions that just go to stderr. These get called
+// from the worker threads which is why the output is guarded by a lock.
+
+GLOBAL std::mutex log_lock;
+GLOBAL bool verbose_log;
+
+STDDEF void internal__log_debug (const char* format, ...)
+{
+    if (!verbose_log) return;
+
+    std::lock_guard<std::mutex> lock(log_lock);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+STDDEF void internal__log_error (const char* file, int line, Error_Level level, const char* format, ...)
+{
+    std::lock_guard<std::mutex> lock(log_lock);
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "error: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+#include "utility.cpp"
+#include "platform.cpp"
+#include "tile_layer.cpp"
+#include "level.cpp"
+#include "level_merge.cpp"
+#include "level_history.cpp"
+
+GLOBAL constexpr const char* LEVEL_TOOL_USAGE =
+"usage: level_tool <command> [options] <files/folders...>\n"
+"       level_tool merge [options] <base> <ours> <theirs>\n"
+"       level_tool bench <benchmark> [options] [files/folders...]\n"
+"\n"
+"commands:\n"
+"  validate   check the level headers, unknown tile IDs and camera tiles\n"
+"  stats      print the tile histogram of each level and the total\n"
+"  convert    re-encode each level into the output folder\n"
+"  merge      three-way merge two edited levels with their common base\n"
+"  remap      rewrite tile IDs using a remap table, in place unless -o is given\n"
+"  bench      time one of the level code's hot paths (see below)\n"
+"\n"
+"options:\n"
+"  -j <n>     number of worker threads (default: all hardware threads)\n"
+"  -t <file>  tile data used to check IDs (default: data/editor_tiles.txt)\n"
+"  -o <path>  output folder for convert/remap/bench, output level for merge\n"
+"  -m <file>  remap table of [old new] ID pairs (see below)\n"
+"  -f <file>  flip data used by the flip benchmark (default: data/editor_flips.txt)\n"
+"  -n         dry run, just report how many tiles each remap would change\n"
+"  -g <n>     generate n sample levels into the output folder before a scan\n"
+"  -v         print debug output\n"
+"\n"
+"Folders are searched recursively for .lvl files. The exit code is non-zero\n"
+"if any of the levels failed to load, validate or convert. Levels that were\n"
+"found in a folder keep their path within it when written to an output folder\n"
+"and nothing is written if two of the levels would end up at the same output.\n"
+"\n"
+"Merge prints each conflicting tile as: layer x y base ours theirs. Our tile\n"
+"is kept for conflicts. The merged level is written to the output (if given)\n"
+"and the exit code is non-zero if there were conflicts or the merge failed.\n"
+"\n"
+"Remap tables are GON in the same style as data/editor_flips.txt:\n"
+"  remap [ [2 4] [11 13] ]\n"
+"IDs in the table can't be negative or above 1048576 and the empty tile (0)\n"
+"can only be a target. Any bad entries are reported with their line number.\n"
+"Levels are only rewritten if they contain a remapped tile and are written\n"
+"to a temporary file first, so an interrupted remap never truncates a level.\n"
+"\n"
+"Benchmarks run on a single thread and print the best of three runs:\n"
+"  scan       list the given levels by header, mapped open, mapped load and\n"
+"             full read (e.g. level_tool bench scan -g 2000 -o bench_levels)\n"
+"  history    record a 1000x1000 paste into the undo history a tile at a time\n"
+"             then again over the same tiles, pack it and undo/redo it\n"
+"  flip       flip all five layers of a max-size level both ways\n"
+"  fill       check the fill spans against a flood fill, then time a fill of\n"
+"             one tile and of a whole empty max-size layer\n";
+
+enum class Level_Tool_Command { VALIDATE, STATS, CONVERT, MERGE, REMAP, BENCH };
+
+struct Level_Tool_Result
+{
+    bool success;
+
+    std::vector<std::string> messages;
+    std::map<Tile_ID, u32> histogram;
+
+    size_t remapped;
+};
+
+struct Level_Tool
+{
+    Level_Tool_Command command;
+
+    std::string tile_file;
+    std::string remap_file;
+    std::string flip_file;
+    std::string output_path;
+
+    Tile_Remap remap;
+    bool dry_run;
+
+    std::string bench_name;
+    int generate_count;
+
+    std::vector<bool> known_tiles; // Indexed by the tile ID.
+
+    std::vector<std::string> files;
+    std::vector<std::string> relative_names; // Of each file to the folder it was found in.
+    std::vector<std::string> output_names;   // Only set when there's an output folder.
+    std::vector<Level_Tool_Result> results;
+};
+
+GLOBAL Level_Tool level_tool;
+
+FILDEF const char* internal__get_layer_name (Level_Layer layer)
+{
+    switch (layer)
+    {
+        case (LEVEL_LAYER_TAG    ): return "Tag";
+        case (LEVEL_LAYER_OVERLAY): return "Overlay";
+        case (LEVEL_LAYER_ACTIVE ): return "Active";
+        case (LEVEL_LAYER_BACK1  ): return "Back 1";
+        case (LEVEL_LAYER_BACK2  ): return "Back 2";
+    }
+    return "Unknown";
+}
+
+FILDEF bool internal__load_known_tiles ()
+{
+    // The same data the editor's tile panel is built from (see <tile_panel.cpp>).
+    try
+    {
+        GonObject tile_gon_data = GonObject::Load(level_tool.tile_file)["tiles"];
+        for (auto& category_data: tile_gon_data.children_array)
+        {
+            for (auto& tile_group_gon_data: category_data.children_array)
+            {
+                for (int i=0; i<CAST(int, tile_group_gon_data["id"].size()); ++i)
+                {
+                    int id = tile_group_gon_data["id"][i].Int();
+                    if (id < 0) continue;
+                    if (CAST(size_t, id) >= level_tool.known_tiles.size())
+                    {
+                        level_tool.known_tiles.resize(id+1, false);
+                    }
+                    level_tool.known_tiles[id] = true;
+                }
+            }
+        }
+    }
+    catch (const char* msg)
+    {
+        fprintf(stderr, "error: failed to load tile data '%s': %s\n", level_tool.tile_file.c_str(), msg);
+        return false;
+    }
+    return true;
+}
+
+FILDEF bool internal__is_known_tile (Tile_ID id)
+{
+    return (id >= 0 && CAST(size_t, id) < level_tool.known_tiles.size() && level_tool.known_tiles[id]);
+}
+
+FILDEF void internal__validate_level (const Level& level, Level_Tool_Result& result)
+{
+    for (Level_Layer i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        std::map<Tile_ID, u32> unknown;
+        for_each_tile_run(level.data[i], [&](int x, int y, const Tile_ID* tiles, int count)
+        {
+            for (int j=0; j<count; ++j)
+            {
+                if (tiles[j] && !internal__is_known_tile(tiles[j])) ++unknown[tiles[j]];
+            }
+        });
+        for (auto& it: unknown)
+        {
+            result.messages.push_back(format_string("unknown tile ID %d (x%u) in the %s layer", it.first, it.second, internal__get_layer_name(i)));
+            result.success = false;
+        }
+    }
+
+    int camera_tiles = 0;
+    for_each_tile_with_id(level.data[LEVEL_LAYER_TAG], CAMERA_ID, [&](int x, int y)
+    {
+        ++camera_tiles;
+    });
+    if (!camera_tiles)
+    {
+        result.messages.push_back("no camera tiles in the Tag layer");
+        result.success = false;
+    }
+}
+
+FILDEF void internal__count_level_tiles (const Level& level, Level_Tool_Result& result)
+{
+    for (auto& layer: level.data)
+    {
+        for_each_tile_run(layer, [&](int x, int y, const Tile_ID* tiles, int count)
+        {
+            for (int i=0; i<count; ++i) if (tiles[i]) ++result.histogram[tiles[i]];
+        });
+    }
+}
+
+FILDEF void internal__convert_level (const Level& level, const std::string& file_name, const std::string& output_name, Level_Tool_Result& result)
+{
+    std::error_code error;
+    if (std::filesystem::equivalent(file_name, output_name, error))
+    {
+        result.messages.push_back("refusing to overwrite the input level");
+        result.success = false;
+        return;
+    }
+
+    if (!save_level(level, output_name))
+    {
+        result.messages.push_back(format_string("failed to write '%s'", output_name.c_str()));
+        result.success = false;
+    }
+}
+
+// The remap table is dense so an ID this high would already need 4 MB for it,
+// no real tile gets anywhere near this so anything above is treated as a typo.
+GLOBAL constexpr Tile_ID REMAP_MAX_TILE_ID = 1 << 20;
+
+FILDEF std::vector<int> internal__get_remap_entry_lines (const std::string& text)
+{
+    // GON doesn't keep track of where anything came from, so to be able to
+    // point at a bad entry we find the line each of the [old new] pairs in
+    // the remap array starts on by going through the brackets in the text.
+    std::vector<int> lines;
+
+    int  line       = 1;
+    int  depth      = 0;
+    bool in_comment = false;
+    bool in_string  = false;
+    bool in_remap   = false;
+
+    for (size_t i=0; i<text.size(); ++i)
+    {
+        char c = text[i];
+        if (c == '\n') { ++line; in_comment = false; continue; }
+
+        if (in_comment) continue;
+        if (in_string) { if (c == '\\') ++i; else if (c == '"') in_string = false; continue; }
+
+        if      (c == '#') in_comment = true;
+        else if (c == '"') in_string  = true;
+        else if (c == '[' || c == '{')
+        {
+            ++depth;
+            if (in_remap && depth == 2 && c == '[') lines.push_back(line);
+        }
+        else if (c == ']' || c == '}')
+        {
+            if (--depth == 0 && in_remap) break;
+        }
+        else if (depth == 0 && text.compare(i, 5, "remap") == 0)
+        {
+            in_remap = true;
+            i += 4;
+        }
+    }
+
+    return lines;
+}
+
+FILDEF bool internal__load_remap_table ()
+{
+    // The table is built densely so that remapping is a single lookup per tile.
+    level_tool.remap.assign(1, 0);
+    try
+    {
+        std::vector<int> lines = internal__get_remap_entry_lines(read_entire_file(level_tool.remap_file));
+
+        GonObject remap_gon_data = GonObject::Load(level_tool.remap_file)["remap"];
+        for (int i=0; i<CAST(int, remap_gon_data.children_array.size()); ++i)
+        {
+            Tile_ID from = CAST(Tile_ID, remap_gon_data[i][0].Int());
+            Tile_ID to   = CAST(Tile_ID, remap_gon_data[i][1].Int());
+
+            const char* problem = NULL;
+            if      (from == 0)                                          problem = "the empty tile cannot be remapped";
+            else if (from < 0 || to < 0)                                 problem = "tile IDs cannot be negative";
+            else if (from > REMAP_MAX_TILE_ID || to > REMAP_MAX_TILE_ID) problem = "tile ID is too large";
+
+            if (problem)
+            {
+                if (CAST(size_t, i) < lines.size())
+                {
+                    fprintf(stderr, "error: %s:%d: invalid remap %d -> %d (%s)\n", level_tool.remap_file.c_str(), lines[i], from, to, problem);
+                }
+                else
+                {
+                    fprintf(stderr, "error: %s: invalid remap %d -> %d in entry %d (%s)\n", level_tool.remap_file.c_str(), from, to, i+1, problem);
+                }
+                return false;
+            }
+
+            if (CAST(size_t, from) >= level_tool.remap.size())
+            {
+                size_t old_size = level_tool.remap.size();
+                level_tool.remap.resize(from+1);
+                for (size_t j=old_size; j<level_tool.remap.size(); ++j) level_tool.remap[j] = CAST(Tile_ID, j);
+            }
+            level_tool.remap[from] = to;
+        }
+    }
+    catch (const char* msg)
+    {
+        fprintf(stderr, "error: failed to load remap table '%s': %s\n", level_tool.remap_file.c_str(), msg);
+        return false;
+    }
+    return true;
+}
+
+FILDEF void internal__remap_level (Level& level, const std::string& file_name, const std::string& output_name, Level_Tool_Result& result)
+{
+    for (auto& layer: level.data)
+    {
+        if (level_tool.dry_run) result.remapped += count_remapped_tiles(layer, level_tool.remap);
+        else                    result.remapped += remap_tile_layer    (layer, level_tool.remap);
+    }
+
+    result.messages.push_back(format_string("%zu tiles %s", result.remapped, (level_tool.dry_run) ? "would be remapped" : "remapped"));
+
+    // Levels without any of the remapped tiles don't need to be written again.
+    if (level_tool.dry_run || (!result.remapped && level_tool.output_path.empty())) return;
+
+    if (!save_level(level, output_name))
+    {
+        result.messages.push_back(format_string("failed to write '%s'", output_name.c_str()));
+        result.success = false;
+    }
+}
+
+FILDEF void internal__process_level (size_t index, Level_Tool_Result& result)
+{
+    const std::string& file_name = level_tool.files[index];
+
+    // Remapping without an output folder rewrites each of the levels in place.
+    std::string output_name(file_name);
+    if (!level_tool.output_names.empty()) output_name = level_tool.output_names[index];
+
+    result.success = true;
+    result.remapped = 0;
+
+    Level level;
+    std::string error;
+    if (!read_level(level, file_name, error))
+    {
+        result.messages.push_back(error);
+        result.success = false;
+        return;
+    }
+
+    switch (level_tool.command)
+    {
+        case (Level_Tool_Command::VALIDATE): internal__validate_level   (level, result);            break;
+        case (Level_Tool_Command::STATS   ): internal__count_level_tiles(level, result);            break;
+        case (Level_Tool_Command::CONVERT ): internal__convert_level    (level, file_name, output_name, result); break;
+        case (Level_Tool_Command::REMAP   ): internal__remap_level      (level, file_name, output_name, result); break;
+        case (Level_Tool_Command::MERGE   ): break; // Merges and benchmarks are done in main,
+        case (Level_Tool_Command::BENCH   ): break; // they don't use the worker pool.
+    }
+}
+
+FILDEF void internal__gather_level_files (const std::string& path_name)
+{
+    std::error_code error;
+    if (!std::filesystem::is_directory(path_name, error))
+    {
+        level_tool.files.push_back(path_name);
+        level_tool.relative_names.push_back(strip_file_path(path_name));
+        return;
+    }
+
+    std::vector<std::string> files;
+    for (auto it=std::filesystem::recursive_directory_iterator(path_name, error); it!=std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        if (error) break;
+        if (it->is_regular_file(error) && it->path().extension() == ".lvl")
+        {
+            files.push_back(fix_path_slashes(it->path().string()));
+        }
+    }
+    std::sort(files.begin(), files.end());
+    for (auto& file_name: files)
+    {
+        // Levels keep their place within the folder so that any in subfolders
+        // that share a name with another level don't end up at the same output.
+        std::filesystem::path relative = std::filesystem::path(file_name).lexically_relative(path_name);
+        level_tool.files.push_back(file_name);
+        level_tool.relative_names.push_back(relative.generic_string());
+    }
+}
+
+FILDEF bool internal__prepare_output_names ()
+{
+    // Two inputs that would be written to the same output would have one of
+    // them silently replaced by the other (and race on the temporary file) so
+    // that is caught before any of the workers get started.
+    std::map<std::string, size_t> outputs;
+    bool success = true;
+    for (size_t i=0; i<level_tool.files.size(); ++i)
+    {
+        std::string output_name(level_tool.output_path + level_tool.relative_names[i]);
+        auto it = outputs.find(output_name);
+        if (it != outputs.end())
+        {
+            fprintf(stderr, "error: '%s' and '%s' would both be written to '%s'\n", level_tool.files[it->second].c_str(), level_tool.files[i].c_str(), output_name.c_str());
+            success = false;
+            continue;
+        }
+        outputs.insert({ output_name, i });
+        level_tool.output_names.push_back(output_name);
+    }
+    if (!success) return false;
+
+    // The folders are all created up front rather than by each of the workers.
+    std::set<std::string> paths;
+    for (auto& output_name: level_tool.output_names) paths.insert(strip_file_name(output_name));
+    for (auto& path_name: paths)
+    {
+        if (!create_path(path_name)) return false;
+    }
+    return true;
+}
+
+FILDEF void internal__run_level_tool (int thread_count)
+{
+    level_tool.results.resize(level_tool.files.size());
+
+    // Workers just grab the next file from a shared counter, levels vary a
+    // lot in size so this keeps all of the threads busy until the very end.
+    std::atomic<size_t> next_file(0);
+    auto worker = [&]()
+    {
+        while (true)
+        {
+            size_t index = next_file++;
+            if (index >= level_tool.files.size()) break;
+            internal__process_level(index, level_tool.results[index]);
+        }
+    };
+
+    thread_count = std::max(1, std::min(thread_count, CAST(int, level_tool.files.size())));
+
+    std::vector<std::thread> threads;
+    for (int i=1; i<thread_count; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto& thread: threads) thread.join();
+}
+
+FILDEF int internal__run_level_merge ()
+{
+    if (level_tool.files.size() != 3)
+    {
+        fprintf(stderr, "error: merge needs exactly three levels (base, ours, theirs)\n");
+        return EXIT_FAILURE;
+    }
+
+    // There are only ever three levels so they just get loaded one at a time.
+    Level levels[3];
+    for (int i=0; i<3; ++i)
+    {
+        std::string error;
+        if (!read_level(levels[i], level_tool.files[i], error))
+        {
+            fprintf(stderr, "%s: %s\n", level_tool.files[i].c_str(), error.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Level merged;
+    std::vector<Level_Merge_Conflict> conflicts;
+    std::string error;
+    if (!merge_levels(levels[0], levels[1], levels[2], merged, conflicts, error))
+    {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (auto& conflict: conflicts)
+    {
+        printf("%s %d %d %d %d %d\n", internal__get_layer_name(conflict.layer), conflict.x, conflict.y, conflict.base, conflict.ours, conflict.theirs);
+    }
+
+    if (!level_tool.output_path.empty() && !save_level(merged, level_tool.output_path))
+    {
+        fprintf(stderr, "error: failed to write '%s'\n", level_tool.output_path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    fprintf(stderr, "%zu conflicts (%.3fs)\n", conflicts.size(), seconds);
+
+    return (conflicts.empty()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// The benchmarks are here rather than in a separate harness so that they run
+// the exact same level code as the tool and editor, and can be re-run by anyone
+// with just the level tool. Each one times a few passes over the same data.
+
+GLOBAL constexpr int LEVEL_BENCH_RUNS = 3;
+
+template<typename T>
+FILDEF double internal__time_bench_pass (T pass)
+{
+    double best = 0.0;
+    for (int i=0; i<LEVEL_BENCH_RUNS; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        pass();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+FILDEF void internal__print_bench_pass (const char* name, double seconds, size_t count, const char* unit)
+{
+    printf("  %-24s %10.3f ms %10.3f us/%s\n", name, seconds * 1000.0, (count) ? (seconds * 1000000.0 / count) : 0.0, unit);
+}
+
+// Fills a level with a rough stand-in for real tiles: each row of each layer
+// is a series of runs of the same tile (like walls and backgrounds), with the
+// front layers mostly empty. Seeded so the same level is made every time.
+
+FILDEF void internal__fill_bench_level (Level& level, u32 seed)
+{
+    std::mt19937 rng(seed);
+
+    static const int EMPTY_CHANCE[LEVEL_LAYER_TOTAL] = { 95, 90, 60, 30, 20 }; // Out of 100.
+
+    int w = level.header.width;
+    int h = level.header.height;
+
+    std::vector<Tile_ID> row(w);
+    for (Level_Layer i=0; i<LEVEL_LAYER_TOTAL; ++i)
+    {
+        for (int y=0; y<h; ++y)
+        {
+            int x = 0;
+            while (x < w)
+            {
+                int length = std::min(w-x, CAST(int, rng() % 16) + 1);
+                Tile_ID id = (CAST(int, rng() % 100) < EMPTY_CHANCE[i]) ? 0 : CAST(Tile_ID, rng() % 256) + 1;
+                std::fill(row.begin()+x, row.begin()+x+length, id);
+                x += length;
+            }
+            write_tile_row(level.data[i], 0, y, w, &row[0]);
+        }
+    }
+}
+
+FILDEF bool internal__generate_bench_level (const std::string& file_name, int index)
+{
+    // Most levels are the default size but there are some bigger ones.
+    int w = CAST(int, DEFAULT_LEVEL_WIDTH ) * (1 + ((index % 8 == 0) ? 3 : 0));
+    int h = CAST(int, DEFAULT_LEVEL_HEIGHT) * (1 + ((index % 8 == 0) ? 1 : 0));
+
+    Level level;
+    if (!create_blank_level(level, w, h)) return false;
+    internal__fill_bench_level(level, CAST(u32, index));
+
+    return save_level(level, file_name);
+}
+
+FILDEF bool internal__generate_bench_levels ()
+{
+    if (level_tool.output_path.empty())
+    {
+        fprintf(stderr, "error: generating levels needs an output folder (-o)\n");
+        return false;
+    }
+
+    std::string path_name(fix_path_slashes(level_tool.output_path));
+    if (path_name.back() != '/') path_name.push_back('/');
+    if (!create_path(path_name)) return false;
+
+    for (int i=0; i<level_tool.generate_count; ++i)
+    {
+        std::string file_name(format_string("%sbench_%04d.lvl", path_name.c_str(), i));
+        if (!internal__generate_bench_level(file_name, i))
+        {
+            fprintf(stderr, "error: failed to write '%s'\n", file_name.c_str());
+            return false;
+        }
+    }
+
+    internal__gather_level_files(path_name);
+    return true;
+}
+
+// Lists the levels the way a folder browser would (header only) against the
+// memory mapped reader and a full read, so the cost of touching tile data is
+// clear. The files are read before the passes so the OS file cache is warm.
+
+FILDEF int internal__bench_level_scan ()
+{
+    if (level_tool.generate_count > 0 && !internal__generate_bench_levels()) return EXIT_FAILURE;
+
+    if (level_tool.files.empty())
+    {
+        fprintf(stderr, "error: no levels were found\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t count = level_tool.files.size();
+    size_t bytes = 0;
+    for (auto& file_name: level_tool.files) bytes += read_entire_file(file_name).size();
+
+    // The tiles seen are totalled so none of the passes can be optimized out.
+    size_t header_tiles = 0;
+    size_t mapped_tiles = 0;
+    size_t loaded_tiles = 0;
+    size_t read_tiles   = 0;
+    int    failed       = 0;
+
+    double header_time = internal__time_bench_pass([&]()
+    {
+        for (auto& file_name: level_tool.files)
+        {
+            Level_Header header;
+            if (load_level_header(header, file_name)) header_tiles += CAST(size_t, header.width) * header.height;
+        }
+    });
+    double mapped_time = internal__time_bench_pass([&]()
+    {
+        for (auto& file_name: level_tool.files)
+        {
+            Mapped_Level mapped;
+            if (!open_mapped_level(mapped, file_name)) continue;
+            mapped_tiles += CAST(size_t, mapped.header.width) * mapped.header.height;
+            close_mapped_level(mapped);
+        }
+    });
+    double loaded_time = internal__time_bench_pass([&]()
+    {
+        for (auto& file_name: level_tool.files)
+        {
+            Mapped_Level mapped;
+            if (!open_mapped_level(mapped, file_name)) continue;
+            Level level;
+            if (load_mapped_level(mapped, level)) loaded_tiles += get_tile_layer_size(level.data[LEVEL_LAYER_ACTIVE]);
+            close_mapped_level(mapped);
+        }
+    });
+    double read_time = internal__time_bench_pass([&]()
+    {
+        for (auto& file_name: level_tool.files)
+        {
+            Level level;
+            std::string error;
+            if (read_level(level, file_name, error)) read_tiles += get_tile_layer_size(level.data[LEVEL_LAYER_ACTIVE]);
+            else ++failed;
+        }
+    });
+
+    printf("scan: %zu levels, %.1f MB\n", count, CAST(double, bytes) / (1024.0 * 1024.0));
+    internal__print_bench_pass("load_level_header",         header_time, count, "level");
+    internal__print_bench_pass("open_mapped_level",         mapped_time, count, "level");
+    internal__print_bench_pass("open + load_mapped_level",  loaded_time, count, "level");
+    internal__print_bench_pass("read_level",                read_time,   count, "level");
+
+    LOG_DEBUG("Tiles: %zu %zu %zu %zu", header_tiles, mapped_tiles, loaded_tiles, read_tiles);
+
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Records a 1000x1000 paste one tile at a time, the way the brush and fill
+// add their changes, then goes over the same tiles again so that the second
+// million changes all hit the de-duplication. The state is then packed and
+// undone and redone, checking that the level ends up as it was each time.
+
+FILDEF int internal__bench_level_history ()
+{
+    constexpr int PASTE_SIZE = 1000;
+
+    Level base;
+    if (!create_blank_level(base, PASTE_SIZE+24, PASTE_SIZE+24)) return EXIT_FAILURE;
+    internal__fill_bench_level(base, 1);
+
+    // The tiles to paste come from another level so they have the same runs.
+    Level clipboard;
+    if (!create_blank_level(clipboard, PASTE_SIZE, PASTE_SIZE)) return EXIT_FAILURE;
+    internal__fill_bench_level(clipboard, 2);
+
+    const Tile_Layer& paste = clipboard.data[LEVEL_LAYER_BACK1];
+    Level_Layer layer = LEVEL_LAYER_ACTIVE;
+
+    double record_time = 0.0;
+    double repeat_time = 0.0;
+    double pack_time   = 0.0;
+    double undo_time   = 0.0;
+    double redo_time   = 0.0;
+
+    size_t info_count = 0;
+    size_t run_count  = 0;
+    bool   matched    = true;
+
+    auto place = [&](Level& level, Level_History_State& state, Tile_ID offset)
+    {
+        for (int y=0; y<PASTE_SIZE; ++y)
+        {
+            for (int x=0; x<PASTE_SIZE; ++x)
+            {
+                Level_History_Info info = {};
+                info.x          = x+12;
+                info.y          = y+12;
+                info.old_id     = get_tile(level.data[layer], info.x, info.y);
+                info.new_id     = get_tile(paste, x, y) + offset;
+                info.tile_layer = layer;
+                set_tile(level.data[layer], info.x, info.y, info.new_id);
+                add_level_history_info(state, info);
+            }
+        }
+    };
+
+    for (int i=0; i<LEVEL_BENCH_RUNS; ++i)
+    {
+        Level level = base;
+        Level_History_State state;
+        state.action = Level_History_Action::NORMAL;
+
+        auto t0 = std::chrono::steady_clock::now();
+        place(level, state, 0);
+        auto t1 = std::chrono::steady_clock::now();
+        place(level, state, 1);
+        auto t2 = std::chrono::steady_clock::now();
+        info_count = state.info.size();
+        pack_level_history_state(state);
+        auto t3 = std::chrono::steady_clock::now();
+        u64 pasted_hash = get_tile_layer_hash(level.data[layer]);
+        apply_level_history_runs(level.data, state, true);
+        auto t4 = std::chrono::steady_clock::now();
+        matched &= (get_tile_layer_hash(level.data[layer]) == get_tile_layer_hash(base.data[layer]));
+        apply_level_history_runs(level.data, state, false);
+        auto t5 = std::chrono::steady_clock::now();
+        matched &= (get_tile_layer_hash(level.data[layer]) == pasted_hash);
+        run_count = state.runs.size();
+
+        auto best = [i](double& best_time, std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+        {
+            double seconds = std::chrono::duration<double>(b - a).count();
+            if (i == 0 || seconds < best_time) best_time = seconds;
+        };
+        best(record_time, t0, t1);
+        best(repeat_time, t1, t2);
+        best(pack_time,   t2, t3);
+        best(undo_time,   t3, t4);
+        best(redo_time,   t4, t5);
+    }
+
+    size_t count = CAST(size_t, PASTE_SIZE) * PASTE_SIZE;
+
+    printf("history: %zu tiles, %zu changes, %zu runs\n", count, info_count, run_count);
+    internal__print_bench_pass("record (new tiles)",       record_time, count, "tile");
+    internal__print_bench_pass("record (repeated tiles)",  repeat_time, count, "tile");
+    internal__print_bench_pass("pack",                     pack_time,   count, "tile");
+    internal__print_bench_pass("undo",                     undo_time,   count, "tile");
+    internal__print_bench_pass("redo",                     redo_time,   count, "tile");
+
+    if (!matched)
+    {
+        fprintf(stderr, "error: undo/redo did not restore the level\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Flips every layer of a max-size level through the same code as the editor's
+// level flips, using the real flip tables so the remap pass does real work.
+
+FILDEF int internal__bench_level_flip ()
+{
+    if (!does_file_exist(level_tool.flip_file))
+    {
+        fprintf(stderr, "error: flip data '%s' does not exist\n", level_tool.flip_file.c_str());
+        return EXIT_FAILURE;
+    }
+
+    Tile_Remap flip_horz;
+    Tile_Remap flip_vert;
+    try
+    {
+        GonObject flip_gon_data = GonObject::Load(level_tool.flip_file)["flip"];
+        load_tile_flip_table(flip_gon_data["horz"], flip_horz);
+        load_tile_flip_table(flip_gon_data["vert"], flip_vert);
+    }
+    catch (const char* msg)
+    {
+        fprintf(stderr, "error: failed to load flip data '%s': %s\n", level_tool.flip_file.c_str(), msg);
+        return EXIT_FAILURE;
+    }
+
+    Level level;
+    if (!create_blank_level(level, MAXIMUM_LEVEL_WIDTH, MAXIMUM_LEVEL_HEIGHT)) return EXIT_FAILURE;
+    internal__fill_bench_level(level, 3);
+
+    int w = level.header.width;
+    int h = level.header.height;
+
+    // The row kernels on their own, over the packed tiles of one layer at a
+    // time, to show how much of a flip is spent reading and writing chunks.
+    std::vector<Tile_ID> tiles(CAST(size_t, w)*h);
+    double kernel_time = 0.0;
+    for (int i=0; i<LEVEL_BENCH_RUNS; ++i)
+    {
+        double seconds = 0.0;
+        for (auto& layer: level.data)
+        {
+            read_tile_rect(layer, 0, 0, w, h, &tiles[0]);
+            auto start = std::chrono::steady_clock::now();
+            for (int y=0; y<h; ++y)
+            {
+                reverse_tiles(&tiles[CAST(size_t, y)*w], w);
+                remap_tiles(&tiles[CAST(size_t, y)*w], w, flip_horz);
+            }
+            auto end = std::chrono::steady_clock::now();
+            seconds += std::chrono::duration<double>(end - start).count();
+        }
+        if (i == 0 || seconds < kernel_time) kernel_time = seconds;
+    }
+
+    double horz_time = internal__time_bench_pass([&]()
+    {
+        for (auto& layer: level.data) flip_tile_layer_h(layer, flip_horz);
+    });
+    double vert_time = internal__time_bench_pass([&]()
+    {
+        for (auto& layer: level.data) flip_tile_layer_v(layer, flip_vert);
+    });
+
+    size_t count = CAST(size_t, w) * h * LEVEL_LAYER_TOTAL;
+
+    printf("flip: %dx%d, %d layers\n", w, h, LEVEL_LAYER_TOTAL);
+    internal__print_bench_pass("reverse + remap rows", kernel_time, count, "tile");
+    internal__print_bench_pass("flip_tile_layer_h",    horz_time,   count, "tile");
+    internal__print_bench_pass("flip_tile_layer_v",    vert_time,   count, "tile");
+
+    return EXIT_SUCCESS;
+}
+
+// Keeps a scattering of tiles out of the checked fills, so the callback gets
+// tested as well as the tile IDs.
+FILDEF bool internal__include_checked_fill_tile (int x, int y)
+{
+    return ((x*7 + y*3) % 11 != 0);
+}
+
+FILDEF bool internal__check_tile_fill_spans (const Tile_Layer& layer, int x, int y, const std::vector<Tile_Span>& spans)
+{
+    int w = layer.width;
+    int h = layer.height;
+
+    // Every tile in the spans, which should each only be in one of them.
+    std::vector<bool> filled(CAST(size_t, w)*h, false);
+    for (auto& span: spans)
+    {
+        for (int i=span.x; i<(span.x+span.w); ++i)
+        {
+            if (filled[span.y*w+i]) return false;
+            filled[span.y*w+i] = true;
+        }
+    }
+
+    std::vector<bool> visited(CAST(size_t, w)*h, false);
+    std::vector<std::pair<int,int>> frontier;
+    Tile_ID id = get_tile(layer, x, y);
+    if (internal__include_checked_fill_tile(x, y))
+    {
+        visited[y*w+x] = true;
+        frontier.push_back({ x, y });
+    }
+    while (!frontier.empty())
+    {
+        auto [fx, fy] = frontier.back();
+        frontier.pop_back();
+
+        static const int OFFSETS[4][2] = { { 1,0 }, { -1,0 }, { 0,1 }, { 0,-1 } };
+        for (auto& offset: OFFSETS)
+        {
+            int nx = fx+offset[0];
+            int ny = fy+offset[1];
+            if (nx < 0 || nx >= w || ny < 0 || ny >= h || visited[ny*w+nx]) continue;
+            if (get_tile(layer, nx, ny) != id || !internal__include_checked_fill_tile(nx, ny)) continue;
+            visited[ny*w+nx] = true;
+            frontier.push_back({ nx, ny });
+        }
+    }
+
+    return (visited == filled);
+}
+
+// Checks get_tile_fill_spans against a plain tile by tile flood fill on small
+// random layers, then times it on a max-size layer for both a region of one
+// tile (which should cost next to nothing) and the whole layer at once.
+
+FILDEF int internal__bench_tile_fill ()
+{
+    std::mt19937 rng(4);
+    for (int i=0; i<200; ++i)
+    {
+        int w = CAST(int, rng() % 70) + 1;
+        int h = CAST(int, rng() % 70) + 1;
+
+        Tile_Layer layer;
+        resize_tile_layer(layer, w, h);
+        for (int y=0; y<h; ++y)
+        {
+            for (int x=0; x<w; ++x)
+            {
+                if (rng() % 3 == 0) set_tile(layer, x, y, CAST(Tile_ID, rng() % 2) + 1);
+            }
+        }
+
+        int x = CAST(int, rng() % w);
+        int y = CAST(int, rng() % h);
+
+        std::vector<Tile_Span> spans;
+        get_tile_fill_spans(layer, x, y, internal__include_checked_fill_tile, spans);
+        if (!internal__check_tile_fill_spans(layer, x, y, spans))
+        {
+            fprintf(stderr, "error: fill spans of layer %d (%dx%d from %d,%d) don't match a flood fill\n", i, w, h, x, y);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Tile_Layer layer;
+    resize_tile_layer(layer, MAXIMUM_LEVEL_WIDTH, MAXIMUM_LEVEL_HEIGHT);
+
+    // Walls in a single tile in the middle of the layer.
+    int cx = MAXIMUM_LEVEL_WIDTH  / 2;
+    int cy = MAXIMUM_LEVEL_HEIGHT / 2;
+    set_tile(layer, cx-1, cy, 1);
+    set_tile(layer, cx+1, cy, 1);
+    set_tile(layer, cx, cy-1, 1);
+    set_tile(layer, cx, cy+1, 1);
+
+    auto include = [](int x, int y) { return true; };
+    std::vector<Tile_Span> spans;
+
+    constexpr int SMALL_FILLS = 1000;
+    double small_time = internal__time_bench_pass([&]()
+    {
+        for (int i=0; i<SMALL_FILLS; ++i) get_tile_fill_spans(layer, cx, cy, include, spans);
+    });
+    double large_time = internal__time_bench_pass([&]()
+    {
+        get_tile_fill_spans(layer, 0, 0, include, spans);
+    });
+
+    size_t area = 0;
+    for (auto& span: spans) area += span.w;
+
+    printf("fill: %dx%d layer, checked against a flood fill on 200 random layers\n", MAXIMUM_LEVEL_WIDTH, MAXIMUM_LEVEL_HEIGHT);
+    internal__print_bench_pass("one tile",    small_time / SMALL_FILLS, 1,    "fill");
+    internal__print_bench_pass("whole layer", large_time,               area, "tile");
+
+    return EXIT_SUCCESS;
+}
+
+FILDEF int internal__run_level_bench ()
+{
+    if (level_tool.bench_name == "scan"   ) return internal__bench_level_scan();
+    if (level_tool.bench_name == "history") return internal__bench_level_history();
+    if (level_tool.bench_name == "flip"   ) return internal__bench_level_flip();
+    if (level_tool.bench_name == "fill"   ) return internal__bench_tile_fill();
+
+    fprintf(stderr, "%s", LEVEL_TOOL_USAGE);
+    return EXIT_FAILURE;
+}
+
+FILDEF void internal__print_histogram (const std::map<Tile_ID, u32>& histogram)
+{
+    for (auto& it: histogram) printf("  %6d %u\n", it.first, it.second);
+}
+
+int main (int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "%s", LEVEL_TOOL_USAGE);
+        return EXIT_FAILURE;
+    }
+
+    std::string command(argv[1]);
+    if      (command == "validate") level_tool.command = Level_Tool_Command::VALIDATE;
+    else if (command == "stats"   ) level_tool.command = Level_Tool_Command::STATS;
+    else if (command == "convert" ) level_tool.command = Level_Tool_Command::CONVERT;
+    else if (command == "merge"   ) level_tool.command = Level_Tool_Command::MERGE;
+    else if (command == "remap"   ) level_tool.command = Level_Tool_Command::REMAP;
+    else if (command == "bench"   ) level_tool.command = Level_Tool_Command::BENCH;
+    else
+    {
+        fprintf(stderr, "%s", LEVEL_TOOL_USAGE);
+        return EXIT_FAILURE;
+    }
+
+    int thread_count = CAST(int, std::thread::hardware_concurrency());
+    level_tool.tile_file = "data/editor_tiles.txt";
+    level_tool.flip_file = "data/editor_flips.txt";
+
+    for (int i=2; i<argc; ++i)
+    {
+        std::string arg(argv[i]);
+        bool has_value = (i+1 < argc);
+        if      (arg == "-j" && has_value) thread_count = atoi(argv[++i]);
+        else if (arg == "-t" && has_value) level_tool.tile_file = argv[++i];
+        else if (arg == "-o" && has_value) level_tool.output_path = argv[++i];
+        else if (arg == "-m" && has_value) level_tool.remap_file = argv[++i];
+        else if (arg == "-f" && has_value) level_tool.flip_file = argv[++i];
+        else if (arg == "-g" && has_value) level_tool.generate_count = atoi(argv[++i]);
+        else if (arg == "-n") level_tool.dry_run = true;
+        else if (arg == "-v") verbose_log = true;
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr, "%s", LEVEL_TOOL_USAGE);
+            return EXIT_FAILURE;
+        }
+        else if (level_tool.command == Level_Tool_Command::MERGE) level_tool.files.push_back(fix_path_slashes(arg));
+        else if (level_tool.command == Level_Tool_Command::BENCH && level_tool.bench_name.empty()) level_tool.bench_name = arg;
+        else internal__gather_level_files(fix_path_slashes(arg));
+    }
+
+    if (level_tool.command == Level_Tool_Command::MERGE)
+    {
+        return internal__run_level_merge();
+    }
+    if (level_tool.command == Level_Tool_Command::BENCH)
+    {
+        return internal__run_level_bench();
+    }
+
+    if (level_tool.files.empty())
+    {
+        fprintf(stderr, "error: no levels were found\n");
+        return EXIT_FAILURE;
+    }
+
+    if (level_tool.command == Level_Tool_Command::VALIDATE)
+    {
+        if (!internal__load_known_tiles()) return EXIT_FAILURE;
+    }
+    if (level_tool.command == Level_Tool_Command::REMAP)
+    {
+        if (level_tool.remap_file.empty())
+        {
+            fprintf(stderr, "error: remap needs a remap table (-m)\n");
+            return EXIT_FAILURE;
+        }
+        if (!internal__load_remap_table()) return EXIT_FAILURE;
+    }
+    if (level_tool.command == Level_Tool_Command::CONVERT && level_tool.output_path.empty())
+    {
+        fprintf(stderr, "error: convert needs an output folder (-o)\n");
+        return EXIT_FAILURE;
+    }
+    if (!level_tool.output_path.empty() && !level_tool.dry_run)
+    {
+        level_tool.output_path = fix_path_slashes(level_tool.output_path);
+        if (level_tool.output_path.back() != '/') level_tool.output_path.push_back('/');
+        if (!create_path(level_tool.output_path)) return EXIT_FAILURE;
+        if (!internal__prepare_output_names()) return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    internal__run_level_tool(thread_count);
+    auto end = std::chrono::steady_clock::now();
+
+    int failed = 0;
+    std::map<Tile_ID, u32> total;
+    size_t total_remapped = 0;
+    for (size_t i=0; i<level_tool.files.size(); ++i)
+    {
+        const Level_Tool_Result& result = level_tool.results[i];
+        if (!result.success) ++failed;
+
+        if (level_tool.command == Level_Tool_Command::STATS && result.success)
+        {
+            printf("%s:\n", level_tool.files[i].c_str());
+            internal__print_histogram(result.histogram);
+            for (auto& it: result.histogram) total[it.first] += it.second;
+        }
+        total_remapped += result.remapped;
+        for (auto& message: result.messages)
+        {
+            printf("%s: %s\n", level_tool.files[i].c_str(), message.c_str());
+        }
+    }
+    if (level_tool.command == Level_Tool_Command::STATS)
+    {
+        printf("total:\n");
+        internal__print_histogram(total);
+    }
+    if (level_tool.command == Level_Tool_Command::REMAP)
+    {
+        printf("total: %zu tiles %s\n", total_remapped, (level_tool.dry_run) ? "would be remapped" : "remapped");
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    fprintf(stderr, "%zu levels, %d failed (%.2fs)\n", level_tool.files.size(), failed, seconds);
+
+    return (failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
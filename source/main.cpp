@@ -3,7 +3,8 @@
 int main (int argc, char** argv)
 {
     error_terminate_callback = quit_application;
-    error_maximum_callback = save_restore_files;
+    error_maximum_callback = write_emergency_dump;
+    error_crash_callback = write_emergency_dump;
 
     // We defer so that this always gets scalled on scope exit no matter what.
     defer { quit_application(); };
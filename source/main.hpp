@@ -12,6 +12,7 @@
 #include <type_traits>
 #include <algorithm>
 #include <exception>
+#include <memory>
 #include <atomic>
 #include <fstream>
 #include <sstream>
@@ -21,10 +22,19 @@
 #include <vector>
 #include <array>
 #include <map>
+#include <unordered_map>
 #include <deque>
 #include <string>
 #include <stack>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -55,6 +65,7 @@
 #include "debug.hpp"
 #include "error.hpp"
 #include "platform.hpp"
+#include "emergency.hpp"
 #include "custom_events.hpp"
 #include "application.hpp"
 #include "window.hpp"
@@ -68,8 +79,13 @@
 #include "shader.hpp"
 #include "resource_manager.hpp"
 #include "user_interface.hpp"
+#include "tile_layer.hpp"
 #include "level.hpp"
+#include "level_index.hpp"
+#include "level_merge.hpp"
+#include "level_history.hpp"
 #include "map.hpp"
+#include "backup.hpp"
 #include "gpak.hpp"
 #include "hotbar.hpp"
 #include "toolbar.hpp"
@@ -108,8 +124,13 @@
 #include "shader.cpp"
 #include "resource_manager.cpp"
 #include "user_interface.cpp"
+#include "tile_layer.cpp"
 #include "level.cpp"
+#include "level_index.cpp"
+#include "level_merge.cpp"
+#include "level_history.cpp"
 #include "map.cpp"
+#include "backup.cpp"
 #include "gpak.cpp"
 #include "hotbar.cpp"
 #include "toolbar.cpp"
@@ -125,6 +146,7 @@
 #include "level_editor.cpp"
 #include "map_editor.cpp"
 #include "editor.cpp"
+#include "emergency.cpp"
 #include "status_bar.cpp"
 #include "color_picker.cpp"
 #include "preferences_menu.cpp"
@@ -89,10 +89,14 @@ FILDEF bool internal__load_map (Tab& tab, std::istream&& stream)
     return true;
 }
 
-FILDEF bool internal__save_map (const Tab& tab, FILE* file)
+// The CSV text is passed to the callback piece-by-piece without allocating
+// anything so that the same encoding can also be used by the crash handler.
+
+template<typename T>
+FILDEF void internal__encode_map (const Tab& tab, T write)
 {
     // If the map is empty just save an empty file.
-    if (tab.map.empty()) return true;
+    if (tab.map.empty()) return;
 
     int x = get_map_x_pos (tab.map);
     int y = get_map_y_pos (tab.map);
@@ -108,32 +112,32 @@ FILDEF bool internal__save_map (const Tab& tab, FILE* file)
             {
                 if (node.x == ix && node.y == iy)
                 {
-                    std::string txt(node.lvl);
+                    const std::string* txt = &node.lvl;
                     if (tab.map_node_info.active && (node.x == tab.map_node_info.active->x && node.y == tab.map_node_info.active->y))
                     {
-                        txt = tab.map_node_info.cached_lvl_text;
+                        txt = &tab.map_node_info.cached_lvl_text;
                     }
                     // Need to wrap in quotes if it contains a comma.
-                    if (txt.find(',') == std::string::npos)
+                    if (txt->find(',') == std::string::npos)
                     {
-                        fprintf(file, "%s", txt.c_str());
+                        write(txt->c_str(), txt->length());
                     }
                     else
                     {
-                        fprintf(file, "\"%s\"", txt.c_str());
+                        write("\"", 1);
+                        write(txt->c_str(), txt->length());
+                        write("\"", 1);
                     }
                     break;
                 }
             }
             if (ix != (x+w-1))
             {
-                fprintf(file, ",");
+                write(",", 1);
             }
         }
-        fprintf(file, "\n");
+        write("\n", 1);
     }
-
-    return true;
 }
 
 STDDEF bool load_map (Tab& tab, std::string file_name)
@@ -166,7 +170,12 @@ STDDEF bool save_map (const Tab& tab, std::string file_name)
     }
     defer { fclose(file); };
 
-    return internal__save_map(tab, file);
+    internal__encode_map(tab, [file](const char* data, size_t size)
+    {
+        fwrite(data, sizeof(char), size, file);
+    });
+
+    return true;
 }
 
 STDDEF bool load_restore_map (Tab& tab, std::string file_name)
@@ -189,31 +198,18 @@ STDDEF bool load_restore_map (Tab& tab, std::string file_name)
     return internal__load_map(tab, std::istringstream(data.substr(map_name.length()+1)));
 }
 
-STDDEF bool save_restore_map (const Tab& tab, std::string file_name)
+STDDEF bool dump_restore_map (const Tab& tab, Emergency_Writer& writer)
 {
-    LOG_DEBUG("Saving Restore World Map: %s", file_name.c_str());
-
-    FILE* file = fopen(file_name.c_str(), "wb");
-    if (!file)
-    {
-        LOG_ERROR(ERR_MED, "Failed to save restore file '%s'!", file_name.c_str());
-        return false;
-    }
-    defer { fclose(file); };
-
     // Write the name of the map + null-terminator for later restoration.
-    if (tab.name.empty())
-    {
-        char null_terminator = '\0';
-        fwrite(&null_terminator, sizeof(char), 1, file);
-    }
-    else
+    const char* name = tab.name.c_str();
+    emergency_write(writer, name, strlen(name)+1);
+
+    internal__encode_map(tab, [&writer](const char* data, size_t size)
     {
-        const char* name = tab.name.c_str();
-        fwrite(name, sizeof(char), strlen(name)+1, file);
-    }
+        emergency_write(writer, data, size);
+    });
 
-    return internal__save_map(tab, file);
+    return emergency_flush(writer);
 }
 
 FILDEF int get_map_x_pos (const Map& map)
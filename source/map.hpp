@@ -17,11 +17,12 @@ STDDEF bool save_map         (const Tab& tab, std::string file_name);
 // the first part of the file until zero is the name of the level. This is
 // done so that the name of the file can also be restored when the editor
 // is loaded again after a fatal failure occurs and restore files are saved.
+// Like levels they are dumped from the crash path (see <emergency.hpp>).
 
 struct Tab; // Defined in <editor.hpp>
 
 STDDEF bool load_restore_map (      Tab& tab, std::string file_name);
-STDDEF bool save_restore_map (const Tab& tab, std::string file_name);
+STDDEF bool dump_restore_map (const Tab& tab, Emergency_Writer& writer);
 
 FILDEF int  get_map_x_pos    (const Map& map);
 FILDEF int  get_map_y_pos    (const Map& map);
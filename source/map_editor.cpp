@@ -1083,68 +1083,29 @@ FILDEF void map_drop_file (Tab* tab, std::string file_name)
 
 FILDEF void backup_map_tab (const Tab& tab, const std::string& file_name)
 {
-    // Determine how many backups the user wants saved for a given map.
-    int backup_count = editor_settings.backup_count;
-    if (backup_count <= 0) return; // No backups are wanted!
-
-    std::string map_name((file_name.empty()) ? "untitled" : strip_file_path_and_ext(file_name));
-
-    // Create a folder for this particular map's backups if it does not exist.
-    // We make separate sub-folders in the backup directory for each map as
-    // there was an issue in older versions with the editor freezing when backing
-    // up levels to a backups folder with loads of saves. This was because the
-    // editor was searching the folder for old backups (leading to a freeze).
-    std::string backup_path(get_appdata_path() + BACKUPS_PATH + map_name + "/");
-    if (!does_path_exist(backup_path))
+    Backup_Slot slot;
+    if (get_next_backup_slot(Backup_Type::MAP, file_name, slot))
     {
-        if (!create_path(backup_path))
+        // The slot is only replaced, and the ring advanced, once it's complete.
+        std::string slot_name(slot.name + ".csv");
+        std::string temp_name(slot_name + ".tmp");
+        if (!save_map(tab, temp_name))
         {
-            LOG_ERROR(ERR_MIN, "Failed to create backup for map \"%s\"!", map_name.c_str());
+            abandon_backup_slot(Backup_Type::MAP, slot.name);
             return;
         }
-    }
-
-    // Determine how many backups are already saved of this map.
-    std::vector<std::string> backups;
-    list_path_content(backup_path, backups);
 
-    int map_count = 0;
-    for (auto& file: backups)
-    {
-        if (is_file(file))
+        std::error_code error;
+        std::filesystem::rename(temp_name, slot_name, error);
+        if (error)
         {
-            // We strip extension twice because there are two extension parts to backups the .bak and the .csv.
-            std::string compare_name(strip_file_ext(strip_file_path_and_ext(file)));
-            if (insensitive_compare(map_name, compare_name)) ++map_count;
-        }
-    }
-
-    // If there is still room to create a new backup then that is what
-    // we do. Otherwise, we overwrite the oldest backup of the map.
-    std::string backup_name = backup_path + map_name + ".bak";
-    if (editor_settings.unlimited_backups || (map_count < backup_count))
-    {
-        backup_name += std::to_string(map_count) + ".csv";
-        save_map(tab, backup_name);
-    }
-    else
-    {
-        u64 oldest = UINT64_MAX;
-        int oldest_index = 0;
-
-        for (int i=0; i<map_count; ++i)
-        {
-            std::string name(backup_name + std::to_string(i) + ".csv");
-            u64 current = last_file_write_time(name);
-            if (current < oldest)
-            {
-                oldest = current;
-                oldest_index = i;
-            }
+            LOG_ERROR(ERR_MIN, "Failed to write backup '%s'!", slot_name.c_str());
+            remove(temp_name.c_str());
+            abandon_backup_slot(Backup_Type::MAP, slot.name);
+            return;
         }
 
-        backup_name += std::to_string(oldest_index) + ".csv";
-        save_map(tab, backup_name);
+        commit_backup_slot(Backup_Type::MAP, slot.name);
     }
 }
 
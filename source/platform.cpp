@@ -1,5 +1,5 @@
 #if defined(PLATFORM_WIN32)
 #include "platform/win32/platform.cpp"
-#elif defined(PLATFORM_OSX)
+#elif defined(PLATFORM_OSX) || defined(PLATFORM_LINUX)
 #include "platform/osx/platform.cpp"
 #endif
@@ -46,6 +46,42 @@ STDDEF std::vector<std::string> path_dialog (                  bool multiselect
 
 STDDEF void setup_crash_handler ();
 
+//
+// Memory Mapped Files
+//
+
+// A read-only view of an entire file's contents. The handle members are
+// platform-specific and should only ever be touched by the platform layer.
+
+struct File_Mapping
+{
+    const u8* data;
+    size_t    size;
+
+    void* handle;
+    void* mapping;
+};
+
+FILDEF bool map_file   (File_Mapping& mapping, std::string file_name);
+FILDEF void unmap_file (File_Mapping& mapping);
+
+//
+// Raw Files
+//
+
+// Unbuffered files that are written straight through to the OS. Apart from
+// opening, none of these allocate memory or take locks (unlike stdio) which
+// means that they are safe to be used from inside of the crash handler.
+
+typedef intptr_t Raw_File;
+
+GLOBAL constexpr Raw_File INVALID_RAW_FILE = -1;
+
+FILDEF Raw_File open_raw_file   (std::string file_name);
+FILDEF bool     write_raw_file  (Raw_File file, const void* data, size_t size);
+FILDEF void     close_raw_file  (Raw_File file);
+FILDEF bool     rename_raw_file (const char* old_name, const char* new_name);
+
 //
 // Miscellaneous
 //
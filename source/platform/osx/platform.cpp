@@ -1,3 +1,10 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+
 //
 // Alert Prompt
 //
@@ -33,9 +40,121 @@ STDDEF std::vector<std::string> path_dialog (bool multiselect)
 // Crash Handler
 //
 
+// The handler gets its own stack so that stack overflows can be caught too.
+GLOBAL u8 crash_handler_stack[64*1024];
+
+STDDEF void internal__crash_signal_handler (int sig)
+{
+    if (error_crash_callback)
+    {
+        error_crash_callback();
+    }
+
+    // The handler was reset when it got called, so raising the signal again
+    // terminates the process the same way it would have done without us.
+    raise(sig);
+}
+
 STDDEF void setup_crash_handler ()
 {
-    // @Incomplete: ...
+    stack_t stack = {};
+    stack.ss_sp   = crash_handler_stack;
+    stack.ss_size = sizeof(crash_handler_stack);
+    sigaltstack(&stack, NULL);
+
+    struct sigaction action = {};
+    action.sa_handler = internal__crash_signal_handler;
+    action.sa_flags   = SA_ONSTACK|SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+
+    for (int sig: { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT })
+    {
+        sigaction(sig, &action, NULL);
+    }
+}
+
+//
+// Memory Mapped Files
+//
+
+// This is plain POSIX so it is also what should be used for Linux builds.
+
+FILDEF bool map_file (File_Mapping& mapping, std::string file_name)
+{
+    mapping = {};
+
+    int file = open(file_name.c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info = {};
+    if (fstat(file, &info) != 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // We don't need to hold on to the descriptor once the file is mapped.
+    mapping.size = CAST(size_t, info.st_size);
+    if (mapping.size == 0)
+    {
+        close(file);
+        return true;
+    }
+
+    void* data = mmap(NULL, mapping.size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        mapping = {};
+        return false;
+    }
+
+    madvise(data, mapping.size, MADV_SEQUENTIAL);
+
+    mapping.data = CAST(const u8*, data);
+    return true;
+}
+
+FILDEF void unmap_file (File_Mapping& mapping)
+{
+    if (mapping.data) munmap(CAST(void*, mapping.data), mapping.size);
+    mapping = {};
+}
+
+//
+// Raw Files
+//
+
+FILDEF Raw_File open_raw_file (std::string file_name)
+{
+    return open(file_name.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644); // -1 is INVALID_RAW_FILE.
+}
+
+FILDEF bool write_raw_file (Raw_File file, const void* data, size_t size)
+{
+    const u8* bytes = CAST(const u8*, data);
+    while (size)
+    {
+        ssize_t bytes_written = write(CAST(int, file), bytes, size);
+        if (bytes_written < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += bytes_written;
+        size -= bytes_written;
+    }
+    return true;
+}
+
+FILDEF void close_raw_file (Raw_File file)
+{
+    if (file != INVALID_RAW_FILE) close(CAST(int, file));
+}
+
+FILDEF bool rename_raw_file (const char* old_name, const char* new_name)
+{
+    return (rename(old_name, new_name) == 0);
 }
 
 //
@@ -288,6 +288,12 @@ STDDEF std::vector<std::string> path_dialog (bool multiselect)
 // Unhandled exception dump taken from here <https://stackoverflow.com/a/700108>
 FILDEF LONG WINAPI internal__unhandled_exception_filter (struct _EXCEPTION_POINTERS* info)
 {
+    // The restore files get written first as anything after could also fail.
+    if (error_crash_callback)
+    {
+        error_crash_callback();
+    }
+
     show_alert("Error", "Fatal exception occurred!\nCreating crash dump!",
         ALERT_TYPE_ERROR, ALERT_BUTTON_OK);
 
@@ -324,6 +330,94 @@ STDDEF void setup_crash_handler ()
     SetUnhandledExceptionFilter(&internal__unhandled_exception_filter);
 }
 
+//
+// Memory Mapped Files
+//
+
+FILDEF bool map_file (File_Mapping& mapping, std::string file_name)
+{
+    mapping = {};
+
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    mapping.handle = file;
+    mapping.size   = CAST(size_t, file_size.QuadPart);
+
+    // Windows does not allow mapping empty files so we just leave the data
+    // as NULL and let the caller handle a zero-sized mapping how it wants.
+    if (mapping.size == 0) return true;
+
+    HANDLE view = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!view)
+    {
+        unmap_file(mapping);
+        return false;
+    }
+    mapping.mapping = view;
+
+    mapping.data = CAST(const u8*, MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0));
+    if (!mapping.data)
+    {
+        unmap_file(mapping);
+        return false;
+    }
+
+    return true;
+}
+
+FILDEF void unmap_file (File_Mapping& mapping)
+{
+    if (mapping.data   ) UnmapViewOfFile(mapping.data);
+    if (mapping.mapping) CloseHandle(CAST(HANDLE, mapping.mapping));
+    if (mapping.handle ) CloseHandle(CAST(HANDLE, mapping.handle));
+
+    mapping = {};
+}
+
+//
+// Raw Files
+//
+
+FILDEF Raw_File open_raw_file (std::string file_name)
+{
+    HANDLE file = CreateFileA(file_name.c_str(), GENERIC_WRITE, 0, NULL,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    return CAST(Raw_File, file); // INVALID_HANDLE_VALUE is INVALID_RAW_FILE.
+}
+
+FILDEF bool write_raw_file (Raw_File file, const void* data, size_t size)
+{
+    const u8* bytes = CAST(const u8*, data);
+    while (size)
+    {
+        DWORD bytes_to_write = CAST(DWORD, std::min(size, CAST(size_t, MAXDWORD)));
+        DWORD bytes_written = 0;
+        if (!WriteFile(CAST(HANDLE, file), bytes, bytes_to_write, &bytes_written, NULL)) return false;
+        bytes += bytes_written;
+        size -= bytes_written;
+    }
+    return true;
+}
+
+FILDEF void close_raw_file (Raw_File file)
+{
+    if (file != INVALID_RAW_FILE) CloseHandle(CAST(HANDLE, file));
+}
+
+FILDEF bool rename_raw_file (const char* old_name, const char* new_name)
+{
+    return (MoveFileExA(old_name, new_name, MOVEFILE_REPLACE_EXISTING) != 0);
+}
+
 //
 // Miscellaneous
 //
@@ -9,6 +9,8 @@ GLOBAL const std::map<std::string, const char*> PREFERENCES_SETTINGS_NAMES
 { SETTING_BACKUP_COUNT,        "Backups Per Level"             },
 { SETTING_AUTO_BACKUP,         "Automatic Backups"             },
 { SETTING_BACKUP_INTERVAL,     "Auto-Backup Time"              },
+{ SETTING_DELTA_BACKUPS,       "Delta Backups"                 },
+{ SETTING_HISTORY_MEMORY,      "History Memory (MB)"           },
 { SETTING_BACKGROUND_COLOR,    "Background"                    },
 { SETTING_SELECT_COLOR,        "Select"                        },
 { SETTING_OUT_OF_BOUNDS_COLOR, "Out of Bounds"                 },
@@ -26,6 +28,7 @@ GLOBAL const std::map<std::string, const char*> PREFERENCES_HOTKEYS_NAMES
 { KB_LEVEL_CLOSE,              "Close"                         },
 { KB_LEVEL_CLOSE_ALL,          "Close All"                     },
 { KB_LEVEL_RESIZE,             "Resize"                        },
+{ KB_LEVEL_MERGE,              "Merge Level"                   },
 { KB_UNDO,                     "Undo"                          },
 { KB_REDO,                     "Redo"                          },
 { KB_HISTORY_BEGIN,            "History Begin"                 },
@@ -318,6 +321,8 @@ FILDEF void internal__save_settings ()
     fprintf(file, "%s %d\n", SETTING_BACKUP_COUNT,       editor_settings.backup_count);
     fprintf(file, "%s %s\n", SETTING_AUTO_BACKUP,       (editor_settings.auto_backup)       ? "true" : "false");
     fprintf(file, "%s %d\n", SETTING_BACKUP_INTERVAL,    editor_settings.backup_interval);
+    fprintf(file, "%s %s\n", SETTING_DELTA_BACKUPS,     (editor_settings.delta_backups)     ? "true" : "false");
+    fprintf(file, "%s %d\n", SETTING_HISTORY_MEMORY,     editor_settings.history_memory);
     if (!editor_settings.background_color_defaulted)
     {
         c = editor_settings.background_color;
@@ -501,7 +506,7 @@ FILDEF void internal__do_preferences_settings ()
 
     internal__end_settings_area();
 
-    internal__begin_settings_area("Level Backups", cursor);
+    internal__begin_settings_area("Level Backups & History", cursor);
 
     internal__do_settings_label(sw, SETTING_AUTO_BACKUP);
     UI_Flag backup_enabled_flags  = (editor_settings.auto_backup) ? UI_NONE : UI_INACTIVE;
@@ -531,6 +536,19 @@ FILDEF void internal__do_preferences_settings ()
     }
     internal__next_section(cursor);
 
+    internal__do_settings_label(sw, SETTING_DELTA_BACKUPS);
+    UI_Flag delta_enabled_flags  = (editor_settings.delta_backups) ? UI_NONE : UI_INACTIVE;
+    UI_Flag delta_disabled_flags = (editor_settings.delta_backups) ? UI_INACTIVE : UI_NONE;
+    if (do_button_txt(NULL, bw,sh, delta_enabled_flags,  "Enabled"))
+    {
+        editor_settings.delta_backups = true;
+    }
+    if (do_button_txt(NULL, bw,sh, delta_disabled_flags, "Disabled"))
+    {
+        editor_settings.delta_backups = false;
+    }
+    internal__next_section(cursor);
+
     internal__do_settings_label(sw, SETTING_BACKUP_INTERVAL);
     if (!editor_settings.auto_backup) set_panel_flags(UI_LOCKED);
     cursor.y += PREFERENCES_TEXT_BOX_INSET;
@@ -568,6 +586,22 @@ FILDEF void internal__do_preferences_settings ()
     }
     internal__next_section(cursor);
 
+    internal__do_settings_label(sw, SETTING_HISTORY_MEMORY);
+    cursor.y += PREFERENCES_TEXT_BOX_INSET;
+    std::string history_memory_str(std::to_string(editor_settings.history_memory));
+    do_text_box(vw-cursor.x,th, UI_NUMERIC, history_memory_str, "0");
+    cursor.y -= PREFERENCES_TEXT_BOX_INSET;
+    if (atoll(history_memory_str.c_str()) > INT_MAX)
+    {
+        history_memory_str = std::to_string(INT_MAX);
+    }
+    int history_memory = atoi(history_memory_str.c_str());
+    if (history_memory != editor_settings.history_memory)
+    {
+        editor_settings.history_memory = history_memory;
+    }
+    internal__next_section(cursor);
+
     internal__end_settings_area();
 
     internal__begin_settings_area("Custom Colors", cursor);
@@ -608,6 +642,7 @@ FILDEF void internal__do_preferences_hotkeys ()
     internal__do_hotkey_rebind(cursor, KB_LEVEL_CLOSE          );
     internal__do_hotkey_rebind(cursor, KB_LEVEL_CLOSE_ALL      );
     internal__do_hotkey_rebind(cursor, KB_LEVEL_RESIZE         );
+    internal__do_hotkey_rebind(cursor, KB_LEVEL_MERGE          );
     internal__do_hotkey_rebind(cursor, KB_UNDO                 );
     internal__do_hotkey_rebind(cursor, KB_REDO                 );
     internal__do_hotkey_rebind(cursor, KB_HISTORY_BEGIN        );
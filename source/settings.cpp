@@ -10,6 +10,8 @@ GLOBAL constexpr bool        SETTINGS_DEFAULT_UNLIMITED_BACKUPS   = false;
 GLOBAL constexpr int         SETTINGS_DEFAULT_BACKUP_COUNT        = 5;
 GLOBAL constexpr bool        SETTINGS_DEFAULT_AUTO_BACKUP         = true;
 GLOBAL constexpr int         SETTINGS_DEFAULT_BACKUP_INTERVAL     = 180;
+GLOBAL constexpr bool        SETTINGS_DEFAULT_DELTA_BACKUPS       = false;
+GLOBAL constexpr int         SETTINGS_DEFAULT_HISTORY_MEMORY      = 256;
 GLOBAL           const vec4  SETTINGS_DEFAULT_SELECT_COLOR        = { .94f, .0f, 1.0f, .25f };
 GLOBAL           const vec4  SETTINGS_DEFAULT_OUT_OF_BOUNDS_COLOR = { .25f, .1f,  .1f, .40f };
 GLOBAL           const vec4  SETTINGS_DEFAULT_CURSOR_COLOR        = { .20f, .9f,  .2f, .40f };
@@ -28,6 +30,8 @@ GLOBAL constexpr const char* SETTINGS_FALLBACK =
 "backup_count 5\n"
 "auto_backup true\n"
 "auto_backup_interval 120\n"
+"delta_backups false\n"
+"history_memory_limit 256\n"
 "background_color none\n"
 "select_color [0.900000 0.000000 1.000000 0.250000]\n"
 "out_of_bounds_color [0.250000 0.100000 0.100000 0.400000]\n"
@@ -73,6 +77,8 @@ FILDEF bool operator== (const Settings& a, const Settings& b)
             a.backup_count               == b.backup_count               &&
             a.auto_backup                == b.auto_backup                &&
             a.backup_interval            == b.backup_interval            &&
+            a.delta_backups              == b.delta_backups              &&
+            a.history_memory             == b.history_memory             &&
             a.background_color           == b.background_color           &&
             a.select_color               == b.select_color               &&
             a.out_of_bounds_color        == b.out_of_bounds_color        &&
@@ -153,6 +159,8 @@ FILDEF bool load_editor_settings ()
     editor_settings.backup_count      = gon[SETTING_BACKUP_COUNT     ].Int   (SETTINGS_DEFAULT_BACKUP_COUNT     );
     editor_settings.auto_backup       = gon[SETTING_AUTO_BACKUP      ].Bool  (SETTINGS_DEFAULT_AUTO_BACKUP      );
     editor_settings.backup_interval   = gon[SETTING_BACKUP_INTERVAL  ].Int   (SETTINGS_DEFAULT_BACKUP_INTERVAL  );
+    editor_settings.delta_backups     = gon[SETTING_DELTA_BACKUPS    ].Bool  (SETTINGS_DEFAULT_DELTA_BACKUPS    );
+    editor_settings.history_memory    = gon[SETTING_HISTORY_MEMORY   ].Int   (SETTINGS_DEFAULT_HISTORY_MEMORY   );
 
     update_systems_that_rely_on_settings(true);
 
@@ -185,6 +193,8 @@ FILDEF void restore_editor_settings ()
     editor_settings.backup_count      = SETTINGS_DEFAULT_BACKUP_COUNT;
     editor_settings.auto_backup       = SETTINGS_DEFAULT_AUTO_BACKUP;
     editor_settings.backup_interval   = SETTINGS_DEFAULT_BACKUP_INTERVAL;
+    editor_settings.delta_backups     = SETTINGS_DEFAULT_DELTA_BACKUPS;
+    editor_settings.history_memory    = SETTINGS_DEFAULT_HISTORY_MEMORY;
 
     update_systems_that_rely_on_settings(tile_graphics_changed);
 
@@ -215,6 +225,8 @@ FILDEF void dump_editor_settings ()
     LOG_DEBUG("%s %d", SETTING_BACKUP_COUNT, editor_settings.backup_count);
     LOG_DEBUG("%s %s", SETTING_AUTO_BACKUP, (editor_settings.auto_backup) ? "true" : "false");
     LOG_DEBUG("%s %d", SETTING_BACKUP_INTERVAL, editor_settings.backup_interval);
+    LOG_DEBUG("%s %s", SETTING_DELTA_BACKUPS, (editor_settings.delta_backups) ? "true" : "false");
+    LOG_DEBUG("%s %d", SETTING_HISTORY_MEMORY, editor_settings.history_memory);
     LOG_DEBUG("%s (%f %f %f %f)", SETTING_BACKGROUND_COLOR, EXPAND_VEC4(editor_settings.background_color));
     LOG_DEBUG("%s (%f %f %f %f)", SETTING_SELECT_COLOR, EXPAND_VEC4(editor_settings.select_color));
     LOG_DEBUG("%s (%f %f %f %f)", SETTING_OUT_OF_BOUNDS_COLOR, EXPAND_VEC4(editor_settings.out_of_bounds_color));
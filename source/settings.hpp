@@ -17,6 +17,8 @@ GLOBAL constexpr const char* SETTING_UNLIMITED_BACKUPS   = "unlimited_backups";
 GLOBAL constexpr const char* SETTING_BACKUP_COUNT        = "backup_count";
 GLOBAL constexpr const char* SETTING_AUTO_BACKUP         = "auto_backup";
 GLOBAL constexpr const char* SETTING_BACKUP_INTERVAL     = "auto_backup_interval";
+GLOBAL constexpr const char* SETTING_DELTA_BACKUPS       = "delta_backups";
+GLOBAL constexpr const char* SETTING_HISTORY_MEMORY      = "history_memory_limit";
 GLOBAL constexpr const char* SETTING_BACKGROUND_COLOR    = "background_color";
 GLOBAL constexpr const char* SETTING_SELECT_COLOR        = "select_color";
 GLOBAL constexpr const char* SETTING_OUT_OF_BOUNDS_COLOR = "out_of_bounds_color";
@@ -45,6 +47,9 @@ struct Settings
     int          backup_count;
     bool          auto_backup;
     int       backup_interval;
+    bool        delta_backups;
+    // LEVEL HISTORY
+    int        history_memory; // Megabytes per tab, zero for no limit.
     // EDITOR COLORS
     vec4     background_color;
     vec4         select_color;
@@ -38,6 +38,7 @@ FILDEF void do_status_bar ()
 
     float l2_w = roundf(status_bar_width * STATUS_BAR_LABEL_WIDTH); // Mouse.
     float l3_w = roundf(status_bar_width * STATUS_BAR_LABEL_WIDTH); // Select.
+    float l4_w = 0;                                                 // History.
 
     // Get the mouse position.
     int mx = 0, my = 0;
@@ -79,15 +80,25 @@ FILDEF void do_status_bar ()
     std::string mouse_str = format_string("Position (%d,%d)", mx,my);
     std::string select_str = format_string("Selection (%d,%d,%d,%d)", sx,sy,sw,sh);
 
+    // How much memory the level's undo history is using, so it's clear when
+    // it is getting near the limit and the oldest states are about to go.
+    std::string history_str;
+    if (current_tab_is_level())
+    {
+        float history_mb = CAST(float, get_level_history_memory(get_current_tab())) / (1024.0f * 1024.0f);
+        history_str = format_string("History (%.1f MB)", history_mb);
+    }
+
     // We ensure that the mouse and select labels are always big enough to
     // show their entire content and they take priority over the tool-tip.
     float l2_tw = get_text_width_scaled(get_editor_regular_font(), mouse_str);
     if (l2_w < l2_tw) l2_w = l2_tw;
     float l3_tw = get_text_width_scaled(get_editor_regular_font(), select_str);
     if (l3_w < l3_tw) l3_w = l3_tw;
+    if (!history_str.empty()) l4_w = get_text_width_scaled(get_editor_regular_font(), history_str);
 
     // Now we can calculate how much space is left for the tool-tip label.
-    float l1_w = (status_bar_width - (l2_w + l3_w)) - (advance * 2);
+    float l1_w = (status_bar_width - (l2_w + l3_w + l4_w)) - (advance * ((l4_w > 0) ? 3 : 2));
 
     set_ui_font(&get_editor_regular_font());
 
@@ -102,6 +113,11 @@ FILDEF void do_status_bar ()
     do_label(UI_ALIGN_RIGHT, UI_ALIGN_CENTER, l2_w, h, mouse_str);
     advance_panel_cursor(STATUS_BAR_INNER_PAD);
     do_label(UI_ALIGN_RIGHT, UI_ALIGN_CENTER, l3_w, h, select_str);
+    if (!history_str.empty())
+    {
+        advance_panel_cursor(STATUS_BAR_INNER_PAD);
+        do_label(UI_ALIGN_RIGHT, UI_ALIGN_CENTER, l4_w, h, history_str);
+    }
 
     end_panel();
 
@@ -0,0 +1,983 @@
+STDDEF u64 new_tile_chunk_owner ()
+{
+    // Layers are created and copied from multiple threads (e.g. the loader).
+    static std::atomic<u64> next_owner(1);
+    return next_owner++;
+}
+
+template<typename T>
+FILDEF T* internal__get_writable_chunk (std::vector<std::shared_ptr<T>>& chunks, int index, u64 owner)
+{
+    // Chunks that this layer didn't create may be shared with other copies of
+    // the layer so they get duplicated before being written to, empty chunks
+    // get allocated when needed. Either way the new chunk belongs to us.
+    auto& chunk = chunks[index];
+    if (!chunk)
+    {
+        chunk = std::make_shared<T>(); // Value-initialized so all empty.
+        chunk->owner = owner;
+    }
+    else if (chunk->owner != owner)
+    {
+        chunk = std::make_shared<T>(*chunk);
+        chunk->owner = owner;
+    }
+    return chunk.get();
+}
+
+template<typename T>
+FILDEF void internal__release_chunk_if_empty (std::vector<std::shared_ptr<T>>& chunks, int index)
+{
+    auto& chunk = chunks[index];
+    if (chunk && chunk->used == 0) chunk.reset();
+}
+
+template<typename T>
+FILDEF int internal__count_used_tiles (const T* tiles, int count)
+{
+    int used = 0;
+    for (int i=0; i<count; ++i) used += (tiles[i] != 0);
+    return used;
+}
+
+FILDEF u64 internal__hash_tile (const Tile_Layer& layer, int x, int y, Tile_ID id)
+{
+    // Empty tiles do not contribute so empty chunks never need to be visited.
+    if (id == 0) return 0;
+
+    // The splitmix64 finalizer, so nearby positions/IDs don't cancel out.
+    u64 h = (CAST(u64, y) * CAST(u64, layer.width) + CAST(u64, x)) << 32 | CAST(u32, id);
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+FILDEF void internal__reset_tile_marker (Tile_Layer& layer)
+{
+    auto& marker = layer.marker;
+    if (!marker.id) return;
+
+    marker.count = 0;
+    marker.rows.assign(layer.height, 0);
+    marker.cols.assign(layer.width,  0);
+
+    marker.l = layer.width;
+    marker.t = layer.height;
+    marker.r = -1;
+    marker.b = -1;
+}
+
+FILDEF void internal__add_tile_marker (Tile_Layer& layer, int x, int y)
+{
+    auto& marker = layer.marker;
+
+    ++marker.count;
+    ++marker.rows[y];
+    ++marker.cols[x];
+
+    marker.l = std::min(marker.l, x);
+    marker.t = std::min(marker.t, y);
+    marker.r = std::max(marker.r, x);
+    marker.b = std::max(marker.b, y);
+}
+
+FILDEF void internal__update_tile_marker (Tile_Layer& layer, int x, int y, Tile_ID old_id, Tile_ID new_id)
+{
+    auto& marker = layer.marker;
+    if (!marker.id) return;
+
+    if (new_id == marker.id)
+    {
+        internal__add_tile_marker(layer, x, y);
+    }
+    else if (old_id == marker.id)
+    {
+        --marker.rows[y];
+        --marker.cols[x];
+
+        // The bounds don't get shrunk here as that could mean searching through
+        // many empty rows on each write, but if that was the last one we reset.
+        if (--marker.count == 0) internal__reset_tile_marker(layer);
+    }
+}
+
+FILDEF void internal__reset_tile_threshold (Tile_Layer& layer)
+{
+    auto& threshold = layer.threshold;
+    if (!threshold.min_id) return;
+
+    threshold.chunks.clear();
+    threshold.chunks.resize(CAST(size_t, layer.chunks_w) * CAST(size_t, layer.chunks_h));
+}
+
+FILDEF void internal__add_tile_threshold (Tile_Layer& layer, int x, int y)
+{
+    auto& offsets = layer.threshold.chunks[(y >> TILE_CHUNK_SHIFT)*layer.chunks_w+(x >> TILE_CHUNK_SHIFT)];
+    u16 offset = CAST(u16, ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x & TILE_CHUNK_MASK));
+    offsets.insert(std::lower_bound(offsets.begin(), offsets.end(), offset), offset);
+}
+
+FILDEF void internal__update_tile_threshold (Tile_Layer& layer, int x, int y, Tile_ID old_id, Tile_ID new_id)
+{
+    Tile_ID min_id = layer.threshold.min_id;
+    if (!min_id) return;
+
+    bool was_indexed = (old_id >= min_id);
+    bool now_indexed = (new_id >= min_id);
+
+    if (was_indexed == now_indexed) return;
+
+    if (now_indexed)
+    {
+        internal__add_tile_threshold(layer, x, y);
+    }
+    else
+    {
+        auto& offsets = layer.threshold.chunks[(y >> TILE_CHUNK_SHIFT)*layer.chunks_w+(x >> TILE_CHUNK_SHIFT)];
+        u16 offset = CAST(u16, ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x & TILE_CHUNK_MASK));
+        auto it = std::lower_bound(offsets.begin(), offsets.end(), offset);
+        ASSERT(it != offsets.end() && *it == offset);
+        offsets.erase(it);
+    }
+}
+
+// Called for every tile whose ID gets changed by a write to the layer.
+FILDEF void internal__update_tile_indices (Tile_Layer& layer, int x, int y, Tile_ID old_id, Tile_ID new_id)
+{
+    internal__update_tile_marker   (layer, x, y, old_id, new_id);
+    internal__update_tile_threshold(layer, x, y, old_id, new_id);
+}
+
+FILDEF void internal__reset_tile_palette (Tile_Layer& layer)
+{
+    layer.palette.assign(1, 0);
+    layer.palette_lookup.clear();
+}
+
+FILDEF bool internal__add_tile_palette_index (Tile_Layer& layer, Tile_ID id, u16& index)
+{
+    if (id == 0) { index = 0; return true; }
+
+    auto it = std::lower_bound(layer.palette_lookup.begin(), layer.palette_lookup.end(), id,
+    [](const std::pair<Tile_ID, u16>& a, Tile_ID b)
+    {
+        return (a.first < b);
+    });
+    if (it != layer.palette_lookup.end() && it->first == id)
+    {
+        index = it->second;
+        return true;
+    }
+
+    // Out of indices so the caller has to widen the layer to store the ID.
+    if (layer.palette.size() >= TILE_PALETTE_MAX) return false;
+
+    index = CAST(u16, layer.palette.size());
+    layer.palette.push_back(id);
+    layer.palette_lookup.insert(it, { id, index });
+
+    return true;
+}
+
+FILDEF void internal__widen_tile_layer (Tile_Layer& layer)
+{
+    LOG_DEBUG("Widening tile layer with %zu palette entries", layer.palette.size());
+
+    layer.chunks.clear();
+    layer.chunks.resize(layer.compact_chunks.size());
+
+    for (size_t i=0; i<layer.compact_chunks.size(); ++i)
+    {
+        const Tile_Chunk_Compact* compact = layer.compact_chunks[i].get();
+        if (!compact) continue;
+
+        auto chunk = std::make_shared<Tile_Chunk>();
+        for (int j=0; j<TILE_CHUNK_AREA; ++j) chunk->tiles[j] = layer.palette[compact->indices[j]];
+        chunk->used = compact->used;
+        chunk->owner = layer.owner.id;
+
+        layer.chunks[i] = chunk;
+    }
+
+    layer.compact_chunks.clear();
+    layer.compact_chunks.shrink_to_fit();
+
+    layer.palette.clear();
+    layer.palette_lookup.clear();
+
+    layer.compact = false;
+}
+
+FILDEF void resize_tile_layer (Tile_Layer& layer, int w, int h)
+{
+    layer.width  = std::max(w, 0);
+    layer.height = std::max(h, 0);
+
+    layer.chunks_w = (layer.width  + TILE_CHUNK_MASK) >> TILE_CHUNK_SHIFT;
+    layer.chunks_h = (layer.height + TILE_CHUNK_MASK) >> TILE_CHUNK_SHIFT;
+
+    clear_tile_layer(layer);
+}
+
+FILDEF void clear_tile_layer (Tile_Layer& layer)
+{
+    // With no chunks left nothing refers to the palette so we can start over
+    // with an empty one, this also lets a widened layer go back to compact.
+    layer.compact = true;
+    layer.hash = 0;
+    internal__reset_tile_palette(layer);
+    internal__reset_tile_marker(layer);
+    internal__reset_tile_threshold(layer);
+
+    layer.chunks.clear();
+    layer.chunks.shrink_to_fit();
+
+    layer.compact_chunks.clear();
+    layer.compact_chunks.resize(CAST(size_t, layer.chunks_w) * CAST(size_t, layer.chunks_h));
+}
+
+// Gives the storage of either kind of chunk so both can share the same code.
+FILDEF       u16*     internal__get_chunk_tiles (      Tile_Chunk_Compact& chunk) { return chunk.indices; }
+FILDEF       Tile_ID* internal__get_chunk_tiles (      Tile_Chunk&         chunk) { return chunk.tiles;   }
+FILDEF const u16*     internal__get_chunk_tiles (const Tile_Chunk_Compact& chunk) { return chunk.indices; }
+FILDEF const Tile_ID* internal__get_chunk_tiles (const Tile_Chunk&         chunk) { return chunk.tiles;   }
+
+// The chunks are copied as they are stored, so compact layers keep their palette.
+template<typename T>
+FILDEF void internal__resize_tile_chunks (std::vector<std::shared_ptr<T>>& chunks, u64 owner, int old_chunks_w, int new_chunks_w, int new_chunks_h,
+                                          int sx, int sy, int w, int h, int dx, int dy)
+{
+    std::vector<std::shared_ptr<T>> old_chunks;
+    old_chunks.swap(chunks);
+    chunks.resize(CAST(size_t, new_chunks_w) * CAST(size_t, new_chunks_h));
+
+    if (w <= 0 || h <= 0) return;
+
+    int move_x = dx-sx;
+    int move_y = dy-sy;
+
+    if (((move_x | move_y) & TILE_CHUNK_MASK) == 0)
+    {
+        int move_cx = move_x / TILE_CHUNK_SIZE;
+        int move_cy = move_y / TILE_CHUNK_SIZE;
+
+        for (int cy=(dy >> TILE_CHUNK_SHIFT); cy<=((dy+h-1) >> TILE_CHUNK_SHIFT); ++cy)
+        {
+            for (int cx=(dx >> TILE_CHUNK_SHIFT); cx<=((dx+w-1) >> TILE_CHUNK_SHIFT); ++cx)
+            {
+                auto& old_chunk = old_chunks[(cy-move_cy)*old_chunks_w+(cx-move_cx)];
+                if (!old_chunk) continue;
+
+                int index = cy*new_chunks_w+cx;
+                chunks[index] = std::move(old_chunk);
+
+                // The part of the chunk that is inside the kept rect.
+                int x0 = std::max(dx,   cx    << TILE_CHUNK_SHIFT) - (cx << TILE_CHUNK_SHIFT);
+                int y0 = std::max(dy,   cy    << TILE_CHUNK_SHIFT) - (cy << TILE_CHUNK_SHIFT);
+                int x1 = std::min(dx+w, (cx+1) << TILE_CHUNK_SHIFT) - (cx << TILE_CHUNK_SHIFT);
+                int y1 = std::min(dy+h, (cy+1) << TILE_CHUNK_SHIFT) - (cy << TILE_CHUNK_SHIFT);
+
+                if (x0 == 0 && y0 == 0 && x1 == TILE_CHUNK_SIZE && y1 == TILE_CHUNK_SIZE) continue;
+
+                // Chunks on the edge of the rect have the tiles outside of it cleared.
+                T* chunk = internal__get_writable_chunk(chunks, index, owner);
+                auto* tiles = internal__get_chunk_tiles(*chunk);
+                for (int iy=0; iy<TILE_CHUNK_SIZE; ++iy)
+                {
+                    auto* row = &tiles[iy << TILE_CHUNK_SHIFT];
+                    if (iy < y0 || iy >= y1)
+                    {
+                        memset(row, 0, TILE_CHUNK_SIZE*sizeof(*row));
+                        continue;
+                    }
+                    memset(row,    0,                  x0 *sizeof(*row));
+                    memset(row+x1, 0, (TILE_CHUNK_SIZE-x1)*sizeof(*row));
+                }
+                chunk->used = internal__count_used_tiles(tiles, TILE_CHUNK_AREA);
+                internal__release_chunk_if_empty(chunks, index);
+            }
+        }
+    }
+    else
+    {
+        // Each row is copied in spans that don't cross a chunk in either layer.
+        for (int iy=0; iy<h; ++iy)
+        {
+            int src_y = sy+iy;
+            int dst_y = dy+iy;
+
+            for (int ix=0; ix<w;)
+            {
+                int src_x = sx+ix;
+                int dst_x = dx+ix;
+
+                int count = std::min(w-ix, TILE_CHUNK_SIZE - std::max(src_x & TILE_CHUNK_MASK, dst_x & TILE_CHUNK_MASK));
+
+                const T* src = old_chunks[(src_y >> TILE_CHUNK_SHIFT)*old_chunks_w+(src_x >> TILE_CHUNK_SHIFT)].get();
+                if (src)
+                {
+                    const auto* from = &internal__get_chunk_tiles(*src)[((src_y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (src_x & TILE_CHUNK_MASK)];
+                    int used = internal__count_used_tiles(from, count);
+                    if (used)
+                    {
+                        T* dst = internal__get_writable_chunk(chunks, (dst_y >> TILE_CHUNK_SHIFT)*new_chunks_w+(dst_x >> TILE_CHUNK_SHIFT), owner);
+                        auto* to = &internal__get_chunk_tiles(*dst)[((dst_y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (dst_x & TILE_CHUNK_MASK)];
+                        memcpy(to, from, count*sizeof(*from));
+                        dst->used += used;
+                    }
+                }
+
+                ix += count;
+            }
+        }
+    }
+}
+
+FILDEF void resize_tile_layer_keep (Tile_Layer& layer, int nw, int nh, int sx, int sy, int w, int h, int dx, int dy)
+{
+    ASSERT(sx >= 0 && sy >= 0 && sx+w <= layer.width && sy+h <= layer.height);
+    ASSERT(dx >= 0 && dy >= 0 && dx+w <= nw && dy+h <= nh);
+
+    int old_chunks_w = layer.chunks_w;
+
+    layer.width  = std::max(nw, 0);
+    layer.height = std::max(nh, 0);
+
+    layer.chunks_w = (layer.width  + TILE_CHUNK_MASK) >> TILE_CHUNK_SHIFT;
+    layer.chunks_h = (layer.height + TILE_CHUNK_MASK) >> TILE_CHUNK_SHIFT;
+
+    if (layer.compact) internal__resize_tile_chunks(layer.compact_chunks, layer.owner.id, old_chunks_w, layer.chunks_w, layer.chunks_h, sx,sy, w,h, dx,dy);
+    else               internal__resize_tile_chunks(layer.chunks,         layer.owner.id, old_chunks_w, layer.chunks_w, layer.chunks_h, sx,sy, w,h, dx,dy);
+
+    // Every tile's hash depends on its position and the layer width, so the
+    // hash (and the indices) get worked out again from the tiles in it now.
+    layer.hash = 0;
+    internal__reset_tile_marker(layer);
+    internal__reset_tile_threshold(layer);
+    for_each_tile_run(layer, [&](int x, int y, const Tile_ID* tiles, int count)
+    {
+        for (int i=0; i<count; ++i)
+        {
+            layer.hash ^= internal__hash_tile(layer, x+i, y, tiles[i]);
+            if (layer.marker.id && tiles[i] == layer.marker.id) internal__add_tile_marker(layer, x+i, y);
+            if (layer.threshold.min_id && tiles[i] >= layer.threshold.min_id) internal__add_tile_threshold(layer, x+i, y);
+        }
+    });
+}
+
+FILDEF size_t get_tile_layer_size (const Tile_Layer& layer)
+{
+    return CAST(size_t, layer.width) * CAST(size_t, layer.height);
+}
+
+FILDEF size_t get_tile_layer_memory (const Tile_Layer& layer, const Tile_Layer* shared)
+{
+    if (shared && (shared->chunks_w != layer.chunks_w || shared->chunks_h != layer.chunks_h)) shared = NULL;
+
+    size_t memory = 0;
+    if (layer.compact)
+    {
+        memory += layer.compact_chunks.size() * sizeof(layer.compact_chunks[0]);
+        memory += layer.palette.size() * sizeof(layer.palette[0]);
+        memory += layer.palette_lookup.size() * sizeof(layer.palette_lookup[0]);
+    }
+    else
+    {
+        memory += layer.chunks.size() * sizeof(layer.chunks[0]);
+    }
+    for (int cy=0; cy<layer.chunks_h; ++cy)
+    {
+        for (int cx=0; cx<layer.chunks_w; ++cx)
+        {
+            size_t index = cy*layer.chunks_w+cx;
+            bool allocated = (layer.compact) ? (layer.compact_chunks[index] != NULL) : (layer.chunks[index] != NULL);
+            if (!allocated || (shared && is_tile_chunk_shared(layer, *shared, cx, cy))) continue;
+            memory += (layer.compact) ? sizeof(Tile_Chunk_Compact) : sizeof(Tile_Chunk);
+        }
+    }
+    memory += layer.marker.rows.capacity() * sizeof(int);
+    memory += layer.marker.cols.capacity() * sizeof(int);
+    memory += layer.threshold.chunks.capacity() * sizeof(layer.threshold.chunks[0]);
+    for (auto& offsets: layer.threshold.chunks) memory += offsets.capacity() * sizeof(u16);
+    return memory;
+}
+
+FILDEF bool is_tile_layer_empty (const Tile_Layer& layer)
+{
+    if (layer.compact)
+    {
+        for (auto& chunk: layer.compact_chunks) if (chunk) return false;
+    }
+    else
+    {
+        for (auto& chunk: layer.chunks) if (chunk) return false;
+    }
+    return true;
+}
+
+FILDEF u64 get_tile_layer_hash (const Tile_Layer& layer)
+{
+    return layer.hash;
+}
+
+FILDEF bool get_tile_bounds (Tile_Layer& layer, Tile_ID id, int& l, int& t, int& r, int& b, size_t* count)
+{
+    ASSERT(id != 0);
+
+    auto& marker = layer.marker;
+
+    // Start tracking the ID, a layer only tracks one at a time.
+    if (marker.id != id)
+    {
+        marker.id = id;
+        internal__reset_tile_marker(layer);
+        for_each_tile_with_id(layer, id, [&](int x, int y)
+        {
+            internal__add_tile_marker(layer, x, y);
+        });
+    }
+
+    if (count) *count = marker.count;
+    if (!marker.count) return false;
+
+    // Each edge only ever moves inwards here and outwards on writes, so the
+    // cost of this is paid for by the writes that left the empty rows behind.
+    while (!marker.cols[marker.l]) ++marker.l;
+    while (!marker.cols[marker.r]) --marker.r;
+    while (!marker.rows[marker.t]) ++marker.t;
+    while (!marker.rows[marker.b]) --marker.b;
+
+    l = marker.l;
+    t = marker.t;
+    r = marker.r;
+    b = marker.b;
+
+    return true;
+}
+
+FILDEF void index_tiles_from_id (Tile_Layer& layer, Tile_ID min_id)
+{
+    ASSERT(min_id > 0);
+
+    auto& threshold = layer.threshold;
+    if (threshold.min_id == min_id) return;
+
+    threshold.min_id = min_id;
+    internal__reset_tile_threshold(layer);
+
+    // Runs are visited in row-major order so the offsets get added in order.
+    for_each_tile_run(layer, [&](int x, int y, const Tile_ID* tiles, int count)
+    {
+        auto& offsets = threshold.chunks[(y >> TILE_CHUNK_SHIFT)*layer.chunks_w+(x >> TILE_CHUNK_SHIFT)];
+        for (int i=0; i<count; ++i)
+        {
+            if (tiles[i] >= min_id) offsets.push_back(CAST(u16, ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + ((x+i) & TILE_CHUNK_MASK)));
+        }
+    });
+}
+
+FILDEF Tile_ID get_tile (const Tile_Layer& layer, int x, int y)
+{
+    ASSERT(x >= 0 && x < layer.width && y >= 0 && y < layer.height);
+
+    size_t chunk_index = (y >> TILE_CHUNK_SHIFT)*layer.chunks_w+(x >> TILE_CHUNK_SHIFT);
+    size_t offset = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x & TILE_CHUNK_MASK);
+
+    if (layer.compact)
+    {
+        const Tile_Chunk_Compact* chunk = layer.compact_chunks[chunk_index].get();
+        if (!chunk) return 0;
+        return layer.palette[chunk->indices[offset]];
+    }
+    else
+    {
+        const Tile_Chunk* chunk = layer.chunks[chunk_index].get();
+        if (!chunk) return 0;
+        return chunk->tiles[offset];
+    }
+}
+
+FILDEF void set_tile (Tile_Layer& layer, int x, int y, Tile_ID id)
+{
+    ASSERT(x >= 0 && x < layer.width && y >= 0 && y < layer.height);
+
+    // Don't allocate or duplicate a chunk if the tile won't actually change.
+    Tile_ID old_id = get_tile(layer, x, y);
+    if (old_id == id) return;
+
+    layer.hash ^= internal__hash_tile(layer, x, y, old_id) ^ internal__hash_tile(layer, x, y, id);
+    internal__update_tile_indices(layer, x, y, old_id, id);
+
+    int chunk_index = (y >> TILE_CHUNK_SHIFT)*layer.chunks_w+(x >> TILE_CHUNK_SHIFT);
+    size_t offset = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x & TILE_CHUNK_MASK);
+
+    u16 index = 0;
+    if (layer.compact && !internal__add_tile_palette_index(layer, id, index))
+    {
+        internal__widen_tile_layer(layer);
+    }
+
+    if (layer.compact)
+    {
+        Tile_Chunk_Compact* chunk = internal__get_writable_chunk(layer.compact_chunks, chunk_index, layer.owner.id);
+        u16& tile = chunk->indices[offset];
+        chunk->used += (index != 0) - (tile != 0);
+        tile = index;
+        internal__release_chunk_if_empty(layer.compact_chunks, chunk_index);
+    }
+    else
+    {
+        Tile_Chunk* chunk = internal__get_writable_chunk(layer.chunks, chunk_index, layer.owner.id);
+        Tile_ID& tile = chunk->tiles[offset];
+        chunk->used += (id != 0) - (tile != 0);
+        tile = id;
+        internal__release_chunk_if_empty(layer.chunks, chunk_index);
+    }
+}
+
+FILDEF void read_tile_row (const Tile_Layer& layer, int x, int y, int w, Tile_ID* tiles)
+{
+    int cy = y >> TILE_CHUNK_SHIFT;
+    int end = x+w;
+    while (x < end)
+    {
+        int cx = x >> TILE_CHUNK_SHIFT;
+        int count = std::min(end, (cx+1) << TILE_CHUNK_SHIFT) - x;
+
+        size_t chunk_index = cy*layer.chunks_w+cx;
+        size_t offset = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x & TILE_CHUNK_MASK);
+
+        if (layer.compact)
+        {
+            const Tile_Chunk_Compact* chunk = layer.compact_chunks[chunk_index].get();
+            if (chunk)
+            {
+                const u16* indices = &chunk->indices[offset];
+                for (int i=0; i<count; ++i) tiles[i] = layer.palette[indices[i]];
+            }
+            else memset(tiles, 0, count*sizeof(Tile_ID));
+        }
+        else
+        {
+            const Tile_Chunk* chunk = layer.chunks[chunk_index].get();
+            if (chunk) memcpy(tiles, &chunk->tiles[offset], count*sizeof(Tile_ID));
+            else memset(tiles, 0, count*sizeof(Tile_ID));
+        }
+
+        tiles += count;
+        x     += count;
+    }
+}
+
+FILDEF void write_tile_row (Tile_Layer& layer, int x, int y, int w, const Tile_ID* tiles)
+{
+    u16 indices[TILE_CHUNK_SIZE];
+
+    // Rows are usually long runs of the same few IDs so we remember the last
+    // lookup to avoid searching the palette for the majority of the tiles.
+    Tile_ID last_id    = 0;
+    u16     last_index = 0;
+
+    int cy = y >> TILE_CHUNK_SHIFT;
+    int end = x+w;
+    while (x < end)
+    {
+        int cx = x >> TILE_CHUNK_SHIFT;
+        int count = std::min(end, (cx+1) << TILE_CHUNK_SHIFT) - x;
+
+        int chunk_index = cy*layer.chunks_w+cx;
+        size_t offset = ((y & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x & TILE_CHUNK_MASK);
+
+        int used = internal__count_used_tiles(tiles, count);
+
+        if (layer.compact)
+        {
+            bool encoded = true;
+            for (int i=0; i<count; ++i)
+            {
+                if (tiles[i] != last_id)
+                {
+                    if (!internal__add_tile_palette_index(layer, tiles[i], last_index))
+                    {
+                        encoded = false;
+                        break;
+                    }
+                    last_id = tiles[i];
+                }
+                indices[i] = last_index;
+            }
+            // Try this span again now that the layer can store the raw IDs.
+            if (!encoded)
+            {
+                internal__widen_tile_layer(layer);
+                continue;
+            }
+
+            // Don't allocate or duplicate a chunk if the tiles won't actually change.
+            const Tile_Chunk_Compact* current = layer.compact_chunks[chunk_index].get();
+            bool changed = (current) ? (memcmp(&current->indices[offset], indices, count*sizeof(u16)) != 0) : (used != 0);
+            if (changed)
+            {
+                Tile_Chunk_Compact* chunk = internal__get_writable_chunk(layer.compact_chunks, chunk_index, layer.owner.id);
+                u16* dst = &chunk->indices[offset];
+                chunk->used += used - internal__count_used_tiles(dst, count);
+                for (int i=0; i<count; ++i)
+                {
+                    if (dst[i] != indices[i])
+                    {
+                        layer.hash ^= internal__hash_tile(layer, x+i, y, layer.palette[dst[i]]) ^ internal__hash_tile(layer, x+i, y, tiles[i]);
+                        internal__update_tile_indices(layer, x+i, y, layer.palette[dst[i]], tiles[i]);
+                    }
+                }
+                memcpy(dst, indices, count*sizeof(u16));
+                internal__release_chunk_if_empty(layer.compact_chunks, chunk_index);
+            }
+        }
+        else
+        {
+            const Tile_Chunk* current = layer.chunks[chunk_index].get();
+            bool changed = (current) ? (memcmp(&current->tiles[offset], tiles, count*sizeof(Tile_ID)) != 0) : (used != 0);
+            if (changed)
+            {
+                Tile_Chunk* chunk = internal__get_writable_chunk(layer.chunks, chunk_index, layer.owner.id);
+                Tile_ID* dst = &chunk->tiles[offset];
+                chunk->used += used - internal__count_used_tiles(dst, count);
+                for (int i=0; i<count; ++i)
+                {
+                    if (dst[i] != tiles[i])
+                    {
+                        layer.hash ^= internal__hash_tile(layer, x+i, y, dst[i]) ^ internal__hash_tile(layer, x+i, y, tiles[i]);
+                        internal__update_tile_indices(layer, x+i, y, dst[i], tiles[i]);
+                    }
+                }
+                memcpy(dst, tiles, count*sizeof(Tile_ID));
+                internal__release_chunk_if_empty(layer.chunks, chunk_index);
+            }
+        }
+
+        tiles += count;
+        x     += count;
+    }
+}
+
+FILDEF void read_tile_rect (const Tile_Layer& layer, int x, int y, int w, int h, Tile_ID* tiles)
+{
+    for (int i=0; i<h; ++i) read_tile_row(layer, x, y+i, w, tiles+(CAST(size_t, i)*w));
+}
+
+FILDEF void write_tile_rect (Tile_Layer& layer, int x, int y, int w, int h, const Tile_ID* tiles)
+{
+    for (int i=0; i<h; ++i) write_tile_row(layer, x, y+i, w, tiles+(CAST(size_t, i)*w));
+}
+
+FILDEF bool is_tile_chunk_shared (const Tile_Layer& a, const Tile_Layer& b, int cx, int cy)
+{
+    ASSERT(a.chunks_w == b.chunks_w && a.chunks_h == b.chunks_h);
+
+    // Shared compact chunks mean the same thing in both layers because the
+    // palettes are only appended to after the layers were copied/diverged.
+    size_t index = cy*a.chunks_w+cx;
+    const void* chunk_a = (a.compact) ? CAST(const void*, a.compact_chunks[index].get()) : CAST(const void*, a.chunks[index].get());
+    const void* chunk_b = (b.compact) ? CAST(const void*, b.compact_chunks[index].get()) : CAST(const void*, b.chunks[index].get());
+
+    if (!chunk_a || !chunk_b) return (chunk_a == chunk_b);
+    return (a.compact == b.compact && chunk_a == chunk_b);
+}
+
+FILDEF bool get_tile_palette_index (const Tile_Layer& layer, Tile_ID id, u16& index)
+{
+    ASSERT(layer.compact);
+
+    if (id == 0) { index = 0; return true; }
+
+    auto it = std::lower_bound(layer.palette_lookup.begin(), layer.palette_lookup.end(), id,
+    [](const std::pair<Tile_ID, u16>& a, Tile_ID b)
+    {
+        return (a.first < b);
+    });
+    if (it == layer.palette_lookup.end() || it->first != id) return false;
+
+    index = it->second;
+    return true;
+}
+
+// Applies the remap table to a packed buffer of tiles in place and returns how
+// many of the tiles were changed. IDs outside of the table are left as is.
+
+STDDEF size_t remap_tiles (Tile_ID* tiles, size_t count, const Tile_Remap& remap)
+{
+    const Tile_ID* table = &remap[0];
+    const Tile_ID  size  = CAST(Tile_ID, remap.size());
+
+    size_t changed = 0;
+    size_t i = 0;
+
+    #if defined(SIMD_AVX2)
+    const __m256i limit = _mm256_set1_epi32(size);
+    const __m256i zero  = _mm256_setzero_si256();
+    for (; (i+8)<=count; i+=8)
+    {
+        __m256i id = _mm256_loadu_si256(CAST(const __m256i*, tiles+i));
+        // Out of range IDs gather from index zero and are then blended back.
+        __m256i in_range = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, id), _mm256_cmpgt_epi32(limit, id));
+        __m256i mapped = _mm256_i32gather_epi32(table, _mm256_and_si256(id, in_range), sizeof(Tile_ID));
+        mapped = _mm256_blendv_epi8(id, mapped, in_range);
+        int diff = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(mapped, id))) & 0xFF;
+        if (!diff) continue;
+        _mm256_storeu_si256(CAST(__m256i*, tiles+i), mapped);
+        for (; diff; diff&=diff-1) ++changed;
+    }
+    #endif
+
+    // There is no gather before AVX2 so otherwise the lookups get unrolled.
+    for (; (i+4)<=count; i+=4)
+    {
+        Tile_ID a = tiles[i  ], ma = (CAST(u32, a) < CAST(u32, size)) ? table[a] : a;
+        Tile_ID b = tiles[i+1], mb = (CAST(u32, b) < CAST(u32, size)) ? table[b] : b;
+        Tile_ID c = tiles[i+2], mc = (CAST(u32, c) < CAST(u32, size)) ? table[c] : c;
+        Tile_ID d = tiles[i+3], md = (CAST(u32, d) < CAST(u32, size)) ? table[d] : d;
+        changed += (ma != a) + (mb != b) + (mc != c) + (md != d);
+        tiles[i  ] = ma;
+        tiles[i+1] = mb;
+        tiles[i+2] = mc;
+        tiles[i+3] = md;
+    }
+
+    for (; i<count; ++i)
+    {
+        Tile_ID id = tiles[i], mapped = (CAST(u32, id) < CAST(u32, size)) ? table[id] : id;
+        changed += (mapped != id);
+        tiles[i] = mapped;
+    }
+
+    return changed;
+}
+
+STDDEF void reverse_tiles (Tile_ID* tiles, size_t count)
+{
+    // Vectors are taken from both ends, reversed and swapped over until they
+    // would meet in the middle and then whatever is left is done one by one.
+    Tile_ID* l = tiles;
+    Tile_ID* r = tiles+count;
+
+    #if defined(SIMD_AVX2)
+    const __m256i reverse = _mm256_setr_epi32(7,6,5,4,3,2,1,0);
+    for (; (r-l)>=16; l+=8, r-=8)
+    {
+        __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(CAST(const __m256i*, l  )), reverse);
+        __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(CAST(const __m256i*, r-8)), reverse);
+        _mm256_storeu_si256(CAST(__m256i*, l  ), b);
+        _mm256_storeu_si256(CAST(__m256i*, r-8), a);
+    }
+    #elif defined(SIMD_SSE2)
+    for (; (r-l)>=8; l+=4, r-=4)
+    {
+        __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(CAST(const __m128i*, l  )), _MM_SHUFFLE(0,1,2,3));
+        __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(CAST(const __m128i*, r-4)), _MM_SHUFFLE(0,1,2,3));
+        _mm_storeu_si128(CAST(__m128i*, l  ), b);
+        _mm_storeu_si128(CAST(__m128i*, r-4), a);
+    }
+    #elif defined(SIMD_NEON)
+    for (; (r-l)>=8; l+=4, r-=4)
+    {
+        int32x4_t a = vrev64q_s32(vld1q_s32(l  ));
+        int32x4_t b = vrev64q_s32(vld1q_s32(r-4));
+        vst1q_s32(l,   vextq_s32(b, b, 2));
+        vst1q_s32(r-4, vextq_s32(a, a, 2));
+    }
+    #endif
+
+    std::reverse(l, r);
+}
+
+template<typename T>
+FILDEF size_t internal__remap_tile_layer (const Tile_Layer& layer, const Tile_Remap& remap, T callback)
+{
+    ASSERT(remap.empty() || remap[0] == 0);
+
+    if (remap.empty()) return 0;
+
+    // Compact layers know every ID that could be in them, so if none of them
+    // get remapped we can skip the layer without looking at any of its tiles.
+    if (layer.compact)
+    {
+        bool needed = false;
+        for (Tile_ID id: layer.palette)
+        {
+            if (CAST(u32, id) < remap.size() && remap[id] != id) { needed = true; break; }
+        }
+        if (!needed) return 0;
+    }
+
+    size_t changed = 0;
+    std::vector<Tile_ID> tiles(TILE_CHUNK_AREA);
+
+    // The empty tile never gets remapped so we only visit allocated chunks.
+    for (int cy=0; cy<layer.chunks_h; ++cy)
+    {
+        for (int cx=0; cx<layer.chunks_w; ++cx)
+        {
+            size_t index = cy*layer.chunks_w+cx;
+            if ((layer.compact) ? !layer.compact_chunks[index] : !layer.chunks[index]) continue;
+
+            int x = cx << TILE_CHUNK_SHIFT;
+            int y = cy << TILE_CHUNK_SHIFT;
+            int w = std::min(TILE_CHUNK_SIZE, layer.width  - x);
+            int h = std::min(TILE_CHUNK_SIZE, layer.height - y);
+
+            read_tile_rect(layer, x, y, w, h, &tiles[0]);
+            size_t count = remap_tiles(&tiles[0], CAST(size_t, w)*h, remap);
+            if (count)
+            {
+                callback(x, y, w, h, &tiles[0]);
+                changed += count;
+            }
+        }
+    }
+
+    return changed;
+}
+
+FILDEF size_t remap_tile_layer (Tile_Layer& layer, const Tile_Remap& remap)
+{
+    // The chunk is only read before the callback so it's safe to write to it.
+    return internal__remap_tile_layer(layer, remap, [&layer](int x, int y, int w, int h, const Tile_ID* tiles)
+    {
+        write_tile_rect(layer, x, y, w, h, tiles);
+    });
+}
+
+FILDEF size_t count_remapped_tiles (const Tile_Layer& layer, const Tile_Remap& remap)
+{
+    return internal__remap_tile_layer(layer, remap, [](int x, int y, int w, int h, const Tile_ID* tiles) {});
+}
+
+FILDEF void load_tile_flip_table (const GonObject& data, Tile_Remap& flip)
+{
+    flip.assign(1, 0);
+
+    // The mappings work both ways and the first one that an ID is in is the
+    // one that counts, so go through them backwards to let the earlier win.
+    for (int i=CAST(int, data.children_array.size())-1; i>=0; --i)
+    {
+        Tile_ID a = CAST(Tile_ID, data[i][0].Int());
+        Tile_ID b = CAST(Tile_ID, data[i][1].Int());
+
+        if (a <= 0 || b <= 0) continue; // The empty tile never flips.
+
+        size_t size = flip.size();
+        if (CAST(size_t, std::max(a, b)) >= size)
+        {
+            flip.resize(std::max(a, b)+1);
+            for (size_t j=size; j<flip.size(); ++j) flip[j] = CAST(Tile_ID, j);
+        }
+
+        flip[a] = b;
+        flip[b] = a;
+    }
+}
+
+FILDEF void flip_tile_layer_h (Tile_Layer& layer, const Tile_Remap& flip)
+{
+    int w = layer.width;
+    int h = layer.height;
+
+    std::vector<Tile_ID> temp_row(w);
+
+    // Swap the tile columns from left-to-right for each row.
+    for (int y=0; y<h; ++y)
+    {
+        read_tile_row(layer, 0, y, w, &temp_row[0]);
+        reverse_tiles(&temp_row[0], w);
+        remap_tiles(&temp_row[0], w, flip);
+        write_tile_row(layer, 0, y, w, &temp_row[0]);
+    }
+}
+
+FILDEF void flip_tile_layer_v (Tile_Layer& layer, const Tile_Remap& flip)
+{
+    int w = layer.width;
+    int h = layer.height;
+
+    // The temp holds both of the rows being swapped.
+    std::vector<Tile_ID> temp_row(CAST(size_t, w)*2);
+
+    int b = 0;
+    int t = h-1;
+
+    // The middle row (if there is one) stays put but its tiles still flip.
+    while (b <= t)
+    {
+        read_tile_row(layer, 0, b, w, &temp_row[0]);
+        read_tile_row(layer, 0, t, w, &temp_row[w]);
+
+        remap_tiles(&temp_row[0], CAST(size_t, w)*2, flip);
+
+        write_tile_row(layer, 0, b, w, &temp_row[w]);
+        write_tile_row(layer, 0, t, w, &temp_row[0]);
+
+        ++b;
+        --t;
+    }
+}
+
+FILDEF void internal__add_tile_match_bits (int x, int bits, int count, int y, int& run_start, std::vector<Tile_Span>& spans)
+{
+    for (int i=0; i<count; ++i)
+    {
+        bool match = ((bits >> i) & 1);
+        if (match && run_start < 0) run_start = x+i;
+        if (!match && run_start >= 0)
+        {
+            spans.push_back({ run_start, y, (x+i)-run_start });
+            run_start = -1;
+        }
+    }
+}
+
+STDDEF void find_tile_spans (const Tile_ID* tiles, int count, int y, Tile_ID id, std::vector<Tile_Span>& spans)
+{
+    int run_start = -1;
+    int i = 0;
+
+    // Whole vectors that all match or all don't only need the run updating.
+    #if defined(SIMD_AVX2)
+    const __m256i find = _mm256_set1_epi32(id);
+    for (; (i+8)<=count; i+=8)
+    {
+        __m256i t = _mm256_loadu_si256(CAST(const __m256i*, tiles+i));
+        int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(t, find)));
+        if      (bits == 0xFF) { if (run_start < 0) run_start = i; }
+        else if (bits == 0x00) { if (run_start >= 0) { spans.push_back({ run_start, y, i-run_start }); run_start = -1; } }
+        else internal__add_tile_match_bits(i, bits, 8, y, run_start, spans);
+    }
+    #elif defined(SIMD_SSE2)
+    const __m128i find = _mm_set1_epi32(id);
+    for (; (i+4)<=count; i+=4)
+    {
+        __m128i t = _mm_loadu_si128(CAST(const __m128i*, tiles+i));
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(t, find)));
+        if      (bits == 0xF) { if (run_start < 0) run_start = i; }
+        else if (bits == 0x0) { if (run_start >= 0) { spans.push_back({ run_start, y, i-run_start }); run_start = -1; } }
+        else internal__add_tile_match_bits(i, bits, 4, y, run_start, spans);
+    }
+    #elif defined(SIMD_NEON)
+    const int32x4_t find = vdupq_n_s32(id);
+    for (; (i+4)<=count; i+=4)
+    {
+        uint32x4_t m = vceqq_s32(vld1q_s32(tiles+i), find);
+        int bits = ((vgetq_lane_u32(m,0) & 1)     ) | ((vgetq_lane_u32(m,1) & 1) << 1) |
+                   ((vgetq_lane_u32(m,2) & 1) << 2) | ((vgetq_lane_u32(m,3) & 1) << 3);
+        if      (bits == 0xF) { if (run_start < 0) run_start = i; }
+        else if (bits == 0x0) { if (run_start >= 0) { spans.push_back({ run_start, y, i-run_start }); run_start = -1; } }
+        else internal__add_tile_match_bits(i, bits, 4, y, run_start, spans);
+    }
+    #endif
+
+    for (; i<count; ++i)
+    {
+        internal__add_tile_match_bits(i, (tiles[i] == id), 1, y, run_start, spans);
+    }
+
+    if (run_start >= 0) spans.push_back({ run_start, y, count-run_start });
+}
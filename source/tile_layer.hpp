@@ -0,0 +1,474 @@
+#pragma once
+
+typedef s32 Tile_ID;
+
+// Tile layers are stored as a grid of square chunks of tiles and any chunks
+// that only contain empty tiles are never allocated. This means that huge
+// levels which are mostly empty (such as a new level at the maximum size)
+// only pay for the memory of the areas that actually have tiles placed.
+//
+// Chunks are shared between copies of a layer and are only duplicated when
+// one of the copies writes to them, so copying a level for the history or a
+// background save is cheap. Copies may be read from other threads as long as
+// no two threads write to (or copy from) the same copy of the layer.
+//
+// Whether a layer can write to a chunk in place is decided by which layer
+// created the chunk, rather than by the chunk's reference count, as another
+// thread could be copying or releasing a snapshot at the same time as the
+// count is read. Copying a layer gives both the copy and the original layer
+// new owner IDs, so neither of them owns any of the chunks they now share.
+
+GLOBAL constexpr int TILE_CHUNK_SHIFT = 5;
+GLOBAL constexpr int TILE_CHUNK_SIZE  = 1 << TILE_CHUNK_SHIFT; // 32x32 tiles.
+GLOBAL constexpr int TILE_CHUNK_MASK  = TILE_CHUNK_SIZE - 1;
+GLOBAL constexpr int TILE_CHUNK_AREA  = TILE_CHUNK_SIZE * TILE_CHUNK_SIZE;
+
+// A layer only ever holds a few hundred distinct tile IDs so by default the
+// chunks store 16-bit indices into a per-layer palette of IDs rather than the
+// IDs themselves, which halves the memory and bandwidth of scanning a layer.
+// If a layer ever needs more IDs than can be indexed it widens to raw IDs.
+//
+// The palette is only ever appended to, so indices in chunks that are shared
+// between copies of a layer always mean the same thing in each of the copies.
+// Index zero is always the empty tile.
+
+GLOBAL constexpr size_t TILE_PALETTE_MAX = 65536;
+
+struct Tile_Chunk
+{
+    Tile_ID tiles[TILE_CHUNK_AREA];
+    int used; // Number of non-empty tiles, the chunk is freed when it hits zero.
+    u64 owner; // ID of the layer that created the chunk and can write to it.
+};
+
+struct Tile_Chunk_Compact
+{
+    u16 indices[TILE_CHUNK_AREA];
+    int used;
+    u64 owner;
+};
+
+// Every layer gets a unique owner ID. Copies (in either direction) take new IDs
+// for both layers whereas moves hand the ID over, along with all the chunks.
+STDDEF u64 new_tile_chunk_owner ();
+
+struct Tile_Chunk_Owner
+{
+    mutable u64 id;
+
+    Tile_Chunk_Owner (): id(new_tile_chunk_owner()) {}
+
+    Tile_Chunk_Owner (const Tile_Chunk_Owner& other): id(new_tile_chunk_owner()) { other.id = new_tile_chunk_owner(); }
+    Tile_Chunk_Owner (Tile_Chunk_Owner&& other) noexcept: id(other.id) { other.id = new_tile_chunk_owner(); }
+
+    Tile_Chunk_Owner& operator= (const Tile_Chunk_Owner& other)
+    {
+        id = new_tile_chunk_owner();
+        other.id = new_tile_chunk_owner();
+        return *this;
+    }
+    Tile_Chunk_Owner& operator= (Tile_Chunk_Owner&& other) noexcept
+    {
+        if (this != &other)
+        {
+            id = other.id;
+            other.id = new_tile_chunk_owner();
+        }
+        return *this;
+    }
+};
+
+// Keeps count of the tiles with one particular ID on each row and column of a
+// layer so that the bounds of those tiles (e.g. the camera tiles in the tag
+// layer) can be found without scanning the layer. The index is built the first
+// time the bounds of an ID are requested and from then on every write to the
+// layer keeps it up to date, so copies of the layer carry it along with them.
+
+struct Tile_Marker_Index
+{
+    Tile_ID id = 0; // Zero if no ID is being tracked yet.
+    size_t count = 0;
+
+    std::vector<int> rows;
+    std::vector<int> cols;
+
+    // These only ever grow as tiles are added and are shrunk back down to the
+    // outermost non-empty rows and columns when the bounds are next requested.
+    int l = 0;
+    int t = 0;
+    int r = -1;
+    int b = -1;
+};
+
+// Keeps a sorted list for each chunk of the layer of where the tiles with IDs
+// from a threshold upwards are (e.g. the entities in the active layer), so the
+// ones within a rect can be visited without going through all of the tiles.
+// Like the marker index it is built the first time it is used and then kept
+// up to date by every write to the layer.
+
+struct Tile_Threshold_Index
+{
+    Tile_ID min_id = 0; // Zero if the index has not been built yet.
+
+    std::vector<std::vector<u16>> chunks; // Offsets of the tiles in each chunk.
+};
+
+struct Tile_Layer
+{
+    int width;
+    int height;
+
+    int chunks_w;
+    int chunks_h;
+
+    bool compact;
+
+    // XOR of the hashes of every non-empty tile and its position in the layer,
+    // this is kept up to date on each write so comparing content is cheap.
+    u64 hash;
+
+    std::vector<Tile_ID> palette;
+    std::vector<std::pair<Tile_ID, u16>> palette_lookup; // Sorted by the ID.
+
+    // Only one of these is in use depending on whether the layer is compact.
+    std::vector<std::shared_ptr<Tile_Chunk_Compact>> compact_chunks; // NULL if completely empty.
+    std::vector<std::shared_ptr<Tile_Chunk>>         chunks;         // NULL if completely empty.
+
+    Tile_Marker_Index    marker;
+    Tile_Threshold_Index threshold;
+
+    Tile_Chunk_Owner owner;
+};
+
+// Resizing a layer also clears all of its content.
+FILDEF void   resize_tile_layer      (Tile_Layer& layer, int w, int h);
+
+// Resizes the layer to nw*nh but keeps a w*h rect of its content, which gets
+// moved from sx,sy in the layer as it was to dx,dy in the resized layer. When
+// it is moved by a whole number of chunks (e.g. only the east or south edges
+// change) the chunks themselves are kept, otherwise rows are copied directly.
+FILDEF void   resize_tile_layer_keep (Tile_Layer& layer, int nw, int nh, int sx, int sy, int w, int h, int dx, int dy);
+FILDEF void   clear_tile_layer       (Tile_Layer& layer);
+FILDEF size_t get_tile_layer_size    (const Tile_Layer& layer);
+FILDEF bool   is_tile_layer_empty    (const Tile_Layer& layer);
+FILDEF u64    get_tile_layer_hash    (const Tile_Layer& layer);
+
+// Gets the inclusive bounds of every tile in the layer with the given (non-empty)
+// ID and how many there are, the outputs are left untouched if there are none.
+// The first call for an ID has to visit the layer, after that it is constant
+// time (amortized) as the layer's marker index gets updated by every write.
+FILDEF bool get_tile_bounds (Tile_Layer& layer, Tile_ID id, int& l, int& t, int& r, int& b, size_t* count = NULL);
+
+FILDEF Tile_ID get_tile (const Tile_Layer& layer, int x, int y);
+FILDEF void    set_tile (      Tile_Layer& layer, int x, int y, Tile_ID id);
+
+// Copy a horizontal span or a rectangle of tiles in and out of a layer. The
+// rect buffers are tightly packed rows of w tiles, h rows, in top-down order.
+FILDEF void read_tile_row   (const Tile_Layer& layer, int x, int y, int w,        Tile_ID* tiles);
+FILDEF void write_tile_row  (      Tile_Layer& layer, int x, int y, int w,  const Tile_ID* tiles);
+FILDEF void read_tile_rect  (const Tile_Layer& layer, int x, int y, int w, int h,       Tile_ID* tiles);
+FILDEF void write_tile_rect (      Tile_Layer& layer, int x, int y, int w, int h, const Tile_ID* tiles);
+
+// Whether the two layers are still sharing the same storage for a chunk (or
+// it is empty in both), in which case the tiles in it must be the same too.
+FILDEF bool is_tile_chunk_shared (const Tile_Layer& a, const Tile_Layer& b, int cx, int cy);
+
+// Roughly how many bytes the layer is using. If another layer of the same size
+// is passed in then any chunks still shared with it are left out of the count,
+// so a copy of a layer is only charged for the chunks it no longer shares.
+FILDEF size_t get_tile_layer_memory (const Tile_Layer& layer, const Tile_Layer* shared = NULL);
+
+FILDEF bool get_tile_palette_index (const Tile_Layer& layer, Tile_ID id, u16& index);
+
+// A dense table for rewriting tile IDs in bulk, indexed by the old tile ID and
+// holding the new ID. IDs past the end of the table are left as they are and
+// the empty tile must always map to itself. Both functions return how many of
+// the tiles in the layer are (or would be) changed by the remap.
+
+typedef std::vector<Tile_ID> Tile_Remap;
+
+FILDEF size_t remap_tile_layer     (      Tile_Layer& layer, const Tile_Remap& remap);
+FILDEF size_t count_remapped_tiles (const Tile_Layer& layer, const Tile_Remap& remap);
+
+// The same for a packed row of tiles, returning how many of them changed.
+STDDEF size_t remap_tiles          (Tile_ID* tiles, size_t count, const Tile_Remap& remap);
+
+// Reverses the order of a packed row of tiles, a whole vector at a time.
+STDDEF void   reverse_tiles        (Tile_ID* tiles, size_t count);
+
+// Flip tables are remaps from each tile ID to its mirrored tile, built from
+// the [a b] pairs in editor_flips.txt, which map both ways. A layer flip then
+// mirrors every row or column of the layer and maps the tiles through one.
+
+FILDEF void load_tile_flip_table (const GonObject& data, Tile_Remap& flip);
+
+FILDEF void flip_tile_layer_h    (Tile_Layer& layer, const Tile_Remap& flip);
+FILDEF void flip_tile_layer_v    (Tile_Layer& layer, const Tile_Remap& flip);
+
+// A horizontal run of w tiles starting at x on row y.
+struct Tile_Span
+{
+    int x;
+    int y;
+    int w;
+};
+
+// Appends the runs of tiles in the packed row that are equal to id, as spans
+// on row y. The row is compared a whole vector of tiles at a time so runs of
+// tiles that all match (or all don't) are skipped without looking at each.
+STDDEF void find_tile_spans (const Tile_ID* tiles, int count, int y, Tile_ID id, std::vector<Tile_Span>& spans);
+
+// Calls the callback for each run of tiles within the rect that is stored in
+// allocated chunks, runs never cross a chunk boundary. Empty chunks are skipped
+// entirely so callers that only care about placed tiles can use this to avoid
+// visiting large empty areas. The callback is of the following form:
+//
+//   void callback (int x, int y, const Tile_ID* tiles, int count);
+
+template<typename T>
+FILDEF void for_each_tile_run (const Tile_Layer& layer, int x, int y, int w, int h, T callback)
+{
+    if (w <= 0 || h <= 0) return;
+
+    int cx0 = x >> TILE_CHUNK_SHIFT, cx1 = (x+w-1) >> TILE_CHUNK_SHIFT;
+    int cy0 = y >> TILE_CHUNK_SHIFT, cy1 = (y+h-1) >> TILE_CHUNK_SHIFT;
+
+    Tile_ID decoded[TILE_CHUNK_SIZE];
+
+    // The runs are visited in row-major order so that callers drawing tiles
+    // still get them in the same top-to-bottom, left-to-right stacking order.
+    for (int cy=cy0; cy<=cy1; ++cy)
+    {
+        int y0 = std::max(y,     cy    << TILE_CHUNK_SHIFT);
+        int y1 = std::min(y+h, (cy+1) << TILE_CHUNK_SHIFT);
+
+        for (int iy=y0; iy<y1; ++iy)
+        {
+            for (int cx=cx0; cx<=cx1; ++cx)
+            {
+                int x0 = std::max(x,     cx    << TILE_CHUNK_SHIFT);
+                int x1 = std::min(x+w, (cx+1) << TILE_CHUNK_SHIFT);
+
+                size_t chunk_index = cy*layer.chunks_w+cx;
+                size_t offset = ((iy & TILE_CHUNK_MASK) << TILE_CHUNK_SHIFT) + (x0 & TILE_CHUNK_MASK);
+
+                if (layer.compact)
+                {
+                    const Tile_Chunk_Compact* chunk = layer.compact_chunks[chunk_index].get();
+                    if (!chunk) continue;
+                    const u16* indices = &chunk->indices[offset];
+                    for (int i=0; i<(x1-x0); ++i) decoded[i] = layer.palette[indices[i]];
+                    callback(x0, iy, decoded, x1-x0);
+                }
+                else
+                {
+                    const Tile_Chunk* chunk = layer.chunks[chunk_index].get();
+                    if (!chunk) continue;
+                    callback(x0, iy, &chunk->tiles[offset], x1-x0);
+                }
+            }
+        }
+    }
+}
+
+template<typename T>
+FILDEF void for_each_tile_run (const Tile_Layer& layer, T callback)
+{
+    for_each_tile_run(layer, 0, 0, layer.width, layer.height, callback);
+}
+
+// Calls the callback with the position of every tile in the layer that has the
+// given (non-empty) ID. Compact layers compare the 16-bit indices directly and
+// return straight away if the ID is not in the palette. The callback is of the
+// following form:
+//
+//   void callback (int x, int y);
+
+template<typename T>
+FILDEF void for_each_tile_with_id (const Tile_Layer& layer, Tile_ID id, T callback)
+{
+    ASSERT(id != 0);
+
+    u16 index = 0;
+    if (layer.compact && !get_tile_palette_index(layer, id, index)) return;
+
+    for (int cy=0; cy<layer.chunks_h; ++cy)
+    {
+        int y0 = cy << TILE_CHUNK_SHIFT;
+        int y1 = std::min(y0+TILE_CHUNK_SIZE, layer.height);
+
+        for (int cx=0; cx<layer.chunks_w; ++cx)
+        {
+            int x0 = cx << TILE_CHUNK_SHIFT;
+            int x1 = std::min(x0+TILE_CHUNK_SIZE, layer.width);
+
+            size_t chunk_index = cy*layer.chunks_w+cx;
+
+            if (layer.compact)
+            {
+                const Tile_Chunk_Compact* chunk = layer.compact_chunks[chunk_index].get();
+                if (!chunk) continue;
+                for (int iy=y0; iy<y1; ++iy)
+                {
+                    const u16* row = &chunk->indices[(iy-y0) << TILE_CHUNK_SHIFT];
+                    for (int ix=x0; ix<x1; ++ix) if (row[ix-x0] == index) callback(ix, iy);
+                }
+            }
+            else
+            {
+                const Tile_Chunk* chunk = layer.chunks[chunk_index].get();
+                if (!chunk) continue;
+                for (int iy=y0; iy<y1; ++iy)
+                {
+                    const Tile_ID* row = &chunk->tiles[(iy-y0) << TILE_CHUNK_SHIFT];
+                    for (int ix=x0; ix<x1; ++ix) if (row[ix-x0] == id) callback(ix, iy);
+                }
+            }
+        }
+    }
+}
+
+// Builds the layer's threshold index for tiles with IDs from min_id upwards, it
+// does nothing if the index has already been built for the same ID.
+FILDEF void index_tiles_from_id (Tile_Layer& layer, Tile_ID min_id);
+
+// Calls the callback for every tile within the rect that has an ID from min_id
+// upwards, taking time in proportion to the number of them rather than the
+// area of the rect. They are visited a chunk at a time, in row-major order
+// within each chunk. The callback is of the following form:
+//
+//   void callback (int x, int y, Tile_ID id);
+
+template<typename T>
+FILDEF void for_each_tile_from_id (Tile_Layer& layer, Tile_ID min_id, int x, int y, int w, int h, T callback)
+{
+    index_tiles_from_id(layer, min_id);
+
+    int x0 = std::max(x, 0), x1 = std::min(x+w, layer.width);
+    int y0 = std::max(y, 0), y1 = std::min(y+h, layer.height);
+
+    if (x0 >= x1 || y0 >= y1) return;
+
+    for (int cy=(y0 >> TILE_CHUNK_SHIFT); cy<=((y1-1) >> TILE_CHUNK_SHIFT); ++cy)
+    {
+        int oy0 = std::max(y0 - (cy << TILE_CHUNK_SHIFT), 0);
+        int oy1 = std::min(y1 - (cy << TILE_CHUNK_SHIFT), TILE_CHUNK_SIZE);
+
+        for (int cx=(x0 >> TILE_CHUNK_SHIFT); cx<=((x1-1) >> TILE_CHUNK_SHIFT); ++cx)
+        {
+            const auto& offsets = layer.threshold.chunks[cy*layer.chunks_w+cx];
+            if (offsets.empty()) continue;
+
+            int ox0 = std::max(x0 - (cx << TILE_CHUNK_SHIFT), 0);
+            int ox1 = std::min(x1 - (cx << TILE_CHUNK_SHIFT), TILE_CHUNK_SIZE);
+
+            // The offsets are sorted so we can skip straight to the first row.
+            auto it = std::lower_bound(offsets.begin(), offsets.end(), CAST(u16, oy0 << TILE_CHUNK_SHIFT));
+            for (; it!=offsets.end(); ++it)
+            {
+                int oy = *it >> TILE_CHUNK_SHIFT;
+                int ox = *it &  TILE_CHUNK_MASK;
+
+                if (oy >= oy1) break;
+                if (ox < ox0 || ox >= ox1) continue;
+
+                int tx = (cx << TILE_CHUNK_SHIFT) + ox;
+                int ty = (cy << TILE_CHUNK_SHIFT) + oy;
+
+                callback(tx, ty, get_tile(layer, tx, ty));
+            }
+        }
+    }
+}
+
+// Finds the region of tiles 4-connected to x,y that share its ID, as a list of
+// horizontal spans. This is a scanline fill, so each row of the region gets
+// grown out as a whole span and only the rows directly above and below it are
+// searched for more. The tiles already in the region are tracked as the spans
+// found on each row (rather than a bitmap of the whole layer) so the time and
+// memory it takes are in proportion to the region's size, not the layer's.
+// Tiles can be kept out of the region with the callback, of the following form:
+//
+//   bool include (int x, int y);
+
+template<typename T>
+FILDEF void get_tile_fill_spans (const Tile_Layer& layer, int x, int y, T include, std::vector<Tile_Span>& spans)
+{
+    spans.clear();
+
+    if (x < 0 || x >= layer.width || y < 0 || y >= layer.height || !include(x, y)) return;
+
+    int w = layer.width;
+    int h = layer.height;
+
+    Tile_ID id = get_tile(layer, x, y);
+
+    // The inclusive left and right of each span in a row, sorted by the left.
+    typedef std::vector<std::pair<int,int>> Fill_Row;
+    std::unordered_map<int, Fill_Row> filled;
+
+    auto get_filled_row = [&](int iy) -> const Fill_Row*
+    {
+        auto it = filled.find(iy);
+        return (it != filled.end()) ? &it->second : NULL;
+    };
+    auto is_fillable = [&](const Fill_Row* row, int ix, int iy)
+    {
+        if (row)
+        {
+            auto it = std::upper_bound(row->begin(), row->end(), ix, [](int v, const std::pair<int,int>& span)
+            {
+                return (v < span.first);
+            });
+            if (it != row->begin() && ix <= (it-1)->second) return false;
+        }
+        return (get_tile(layer, ix, iy) == id && include(ix, iy));
+    };
+
+    std::vector<std::pair<int,int>> seeds;
+    seeds.push_back({ x, y });
+
+    while (!seeds.empty())
+    {
+        int sx = seeds.back().first;
+        int sy = seeds.back().second;
+        seeds.pop_back();
+
+        const Fill_Row* seed_row = get_filled_row(sy);
+        if (!is_fillable(seed_row, sx, sy)) continue;
+
+        int l = sx, r = sx;
+        while (l > 0     && is_fillable(seed_row, l-1, sy)) --l;
+        while (r < (w-1) && is_fillable(seed_row, r+1, sy)) ++r;
+
+        Fill_Row& row = filled[sy];
+        row.insert(std::upper_bound(row.begin(), row.end(), std::make_pair(l, r)), { l, r });
+        spans.push_back({ l, sy, (r-l)+1 });
+
+        // Only one seed is needed for each run of fillable tiles next to the span.
+        for (int ny: { sy-1, sy+1 })
+        {
+            if (ny < 0 || ny >= h) continue;
+            const Fill_Row* next_row = get_filled_row(ny);
+            size_t next_span = 0;
+            bool in_run = false;
+            for (int ix=l; ix<=r; ++ix)
+            {
+                // The spans are walked alongside, so filled tiles get skipped.
+                if (next_row)
+                {
+                    while (next_span < next_row->size() && (*next_row)[next_span].second < ix) ++next_span;
+                    if (next_span < next_row->size() && (*next_row)[next_span].first <= ix)
+                    {
+                        ix = (*next_row)[next_span].second;
+                        in_run = false;
+                        continue;
+                    }
+                }
+                bool fillable = (get_tile(layer, ix, ny) == id && include(ix, ny));
+                if (fillable && !in_run) seeds.push_back({ ix, ny });
+                in_run = fillable;
+            }
+        }
+    }
+}
@@ -8,8 +8,6 @@ GLOBAL constexpr float TILE_PANEL_INNER_PAD  =    3;
 GLOBAL constexpr float TILE_PANEL_LABEL_H    =   20;
 GLOBAL constexpr float TILE_PANEL_INACTIVE_A = .33f;
 
-typedef std::pair<Tile_ID, Tile_ID> Tile_Flip_Map;
-
 struct Tile_Group
 {
     std::string              name;
@@ -20,8 +18,10 @@ struct Tile_Group
 
 struct Tile_Panel
 {
-    std::vector<Tile_Flip_Map> flip_map_horz;
-    std::vector<Tile_Flip_Map> flip_map_vert;
+    // Dense tables of the flipped ID for each tile ID (see <tile_layer.hpp>),
+    // so flipping a tile or a whole row of tiles doesn't need to search.
+    Tile_Remap flip_horz;
+    Tile_Remap flip_vert;
 
     std::map<Tile_Category, std::vector<Tile_Group>> category;
 
@@ -175,17 +175,6 @@ FILDEF float internal__do_tile_panel_category (vec2& cursor, Tile_Category categ
     return h;
 }
 
-FILDEF void internal__load_flip_data (const GonObject& data, std::vector<Tile_Flip_Map>& flip)
-{
-    for (int i=0; i<CAST(int, data.children_array.size()); ++i)
-    {
-        Tile_ID a = CAST(Tile_ID, data[i][0].Int());
-        Tile_ID b = CAST(Tile_ID, data[i][1].Int());
-
-        flip.push_back(Tile_Flip_Map(a, b));
-    }
-}
-
 FILDEF float internal__calculate_tile_panel_height ()
 {
     float height = TILE_PANEL_INNER_PAD;
@@ -247,8 +236,8 @@ FILDEF void internal__jump_to_category (Tile_Category category)
 
 FILDEF bool init_tile_panel ()
 {
-    tile_panel.flip_map_horz.clear();
-    tile_panel.flip_map_vert.clear();
+    tile_panel.flip_horz.assign(1, 0);
+    tile_panel.flip_vert.assign(1, 0);
 
     tile_panel.category.clear();
 
@@ -282,8 +271,8 @@ FILDEF bool init_tile_panel ()
         // Load flip mappings between the tile IDs for smart level flipping.
         GonObject flip_gon_data = GonObject::LoadFromBuffer(load_string_resource(FLIP_DATA_FILE))["flip"];
 
-        internal__load_flip_data(flip_gon_data["horz"], tile_panel.flip_map_horz);
-        internal__load_flip_data(flip_gon_data["vert"], tile_panel.flip_map_vert);
+        load_tile_flip_table(flip_gon_data["horz"], tile_panel.flip_horz);
+        load_tile_flip_table(flip_gon_data["vert"], tile_panel.flip_vert);
     }
     catch (const char* msg)
     {
@@ -641,27 +630,20 @@ FILDEF void decrement_selected_category ()
 
 FILDEF Tile_ID get_tile_horizontal_flip (Tile_ID id)
 {
-    if (id)
-    {
-        for (const auto& pair: tile_panel.flip_map_horz)
-        {
-            if (id == pair.first)  return pair.second;
-            if (id == pair.second) return pair.first;
-        }
-    }
-    return id;
+    return (CAST(u32, id) < tile_panel.flip_horz.size()) ? tile_panel.flip_horz[id] : id;
 }
 FILDEF Tile_ID get_tile_vertical_flip (Tile_ID id)
 {
-    if (id)
-    {
-        for (const auto& pair: tile_panel.flip_map_vert)
-        {
-            if (id == pair.first)  return pair.second;
-            if (id == pair.second) return pair.first;
-        }
-    }
-    return id;
+    return (CAST(u32, id) < tile_panel.flip_vert.size()) ? tile_panel.flip_vert[id] : id;
+}
+
+FILDEF const Tile_Remap& get_tile_horizontal_flip_table ()
+{
+    return tile_panel.flip_horz;
+}
+FILDEF const Tile_Remap& get_tile_vertical_flip_table ()
+{
+    return tile_panel.flip_vert;
 }
 
 FILDEF void jump_to_category_basic ()
@@ -44,6 +44,10 @@ FILDEF void decrement_selected_category ();
 FILDEF Tile_ID get_tile_horizontal_flip (Tile_ID id);
 FILDEF Tile_ID get_tile_vertical_flip   (Tile_ID id);
 
+// The flips for every tile ID at once, for flipping many tiles in bulk.
+FILDEF const Tile_Remap& get_tile_horizontal_flip_table ();
+FILDEF const Tile_Remap& get_tile_vertical_flip_table   ();
+
 FILDEF void jump_to_category_basic   ();
 FILDEF void jump_to_category_tag     ();
 FILDEF void jump_to_category_overlay ();
@@ -19,6 +19,18 @@
 #define FORCE_INLINE inline
 #endif
 
+// Which vector instruction set we are allowed to use for any of the bulk tile
+// operations. These are all compile-time so there is no dispatch overhead and
+// every SIMD code path must always have a plain scalar fallback alongside it.
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#define SIMD_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIMD_NEON
+#endif
+
 #define STDDEF INTERNAL
 #define INLDEF INTERNAL       INLINE
 #define FILDEF INTERNAL FORCE_INLINE
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+
+import sys
+import os
+import struct
+
+from argparse import ArgumentParser
+
+parser = ArgumentParser(description="Flatten a delta level backup (.lvd) into a plain level file.")
+parser.add_argument("input", help="the delta backup (or keyframe) to flatten")
+parser.add_argument("output", help="the name and location of the resulting level")
+args = parser.parse_args()
+
+INPUT_BACKUP = args.input
+OUTPUT_LEVEL = args.output
+
+DELTA_MAGIC = 0x544C4454
+DELTA_VERSION = 1
+DELTA_MAX_CHAIN = 64
+DELTA_INDEX_BITS = 25
+DELTA_INDEX_MASK = (1 << DELTA_INDEX_BITS) - 1
+
+LAYER_TOTAL = 5
+
+# The layers are stored in the files in this order (see level.cpp).
+LAYER_IO_ORDER = [3, 2, 0, 1, 4]
+
+def fail (message):
+    print("Error: " + message)
+    sys.exit(1)
+
+def checksum_level (layers):
+    level_hash = 2166136261
+    for layer in layers:
+        layer_hash = 2166136261
+        for tile in layer:
+            layer_hash = ((layer_hash ^ (tile & 0xffffffff)) * 16777619) & 0xffffffff
+        level_hash = ((level_hash ^ layer_hash) * 16777619) & 0xffffffff
+    return level_hash
+
+def split_slot (file_name):
+    slot_name = os.path.splitext(file_name)[0]
+    pos = slot_name.rfind(".bak")
+    if pos == -1 or not slot_name[pos+4:].isdigit():
+        fail("'" + file_name + "' is not named like a backup file!")
+    return slot_name[:pos], int(slot_name[pos+4:])
+
+# This has to match internal__get_backup_slot_file in level.cpp so both rebuild
+# the same level. A slot only holds both files if a write was interrupted before
+# the old one was removed, in which case the newer file wins (the delta on a tie).
+def find_slot_file (base_name, slot):
+    slot_name = base_name + ".bak" + str(slot)
+    delta_name = slot_name + ".lvd"
+    full_name = slot_name + ".lvl"
+    if not os.path.isfile(delta_name):
+        return full_name
+    if not os.path.isfile(full_name):
+        return delta_name
+    if os.stat(delta_name).st_mtime_ns >= os.stat(full_name).st_mtime_ns:
+        return delta_name
+    return full_name
+
+def read_level (file_name):
+    with open(file_name, mode='rb') as file:
+        content = file.read()
+    if len(content) < 16:
+        fail("'" + file_name + "' is too small to be a level!")
+    header = list(struct.unpack(">4i", content[:16]))
+    count = header[1] * header[2]
+    if len(content) < 16 + (count * 4 * LAYER_TOTAL):
+        fail("'" + file_name + "' is truncated!")
+    layers = [None] * LAYER_TOTAL
+    offset = 16
+    for layer in LAYER_IO_ORDER:
+        layers[layer] = list(struct.unpack(">" + str(count) + "i", content[offset:offset+count*4]))
+        offset += count * 4
+    return header, layers
+
+def read_backup (file_name, depth):
+    if depth >= DELTA_MAX_CHAIN:
+        fail("The delta chain is too long or contains a cycle!")
+    if not file_name.endswith(".lvd"):
+        return read_level(file_name)
+
+    with open(file_name, mode='rb') as file:
+        content = file.read()
+    if len(content) < 40:
+        fail("'" + file_name + "' is too small to be a delta backup!")
+
+    magic, version, base_slot, base_checksum, result_checksum = struct.unpack("<5I", content[:20])
+    delta_header = list(struct.unpack("<4i", content[20:36]))
+    change_count = struct.unpack("<I", content[36:40])[0]
+    if magic != DELTA_MAGIC or version != DELTA_VERSION:
+        fail("'" + file_name + "' is not a supported delta backup!")
+    if len(content) < 40 + (change_count * 8):
+        fail("'" + file_name + "' is truncated!")
+
+    base_name, slot = split_slot(file_name)
+    if slot == base_slot:
+        fail("'" + file_name + "' is a delta of itself!")
+
+    base_file = find_slot_file(base_name, base_slot)
+    if not os.path.isfile(base_file):
+        fail("Missing base backup '" + base_file + "'!")
+
+    header, layers = read_backup(base_file, depth + 1)
+    if checksum_level(layers) != base_checksum:
+        fail("Base backup '" + base_file + "' does not match the delta!")
+    if header[1] != delta_header[1] or header[2] != delta_header[2]:
+        fail("Base backup '" + base_file + "' is a different size to the delta!")
+
+    for packed, tile in struct.iter_unpack("<Ii", content[40:40+change_count*8]):
+        layer = packed >> DELTA_INDEX_BITS
+        index = packed & DELTA_INDEX_MASK
+        if layer >= LAYER_TOTAL or index >= len(layers[layer]):
+            fail("'" + file_name + "' contains an out of bounds change!")
+        layers[layer][index] = tile
+
+    if checksum_level(layers) != result_checksum:
+        fail("'" + file_name + "' did not rebuild correctly!")
+
+    print("Applied " + file_name + " (" + str(change_count) + " changes)")
+    return delta_header, layers
+
+header, layers = read_backup(INPUT_BACKUP, 0)
+
+level = bytearray(struct.pack(">4i", *header))
+for layer in LAYER_IO_ORDER:
+    level.extend(struct.pack(">" + str(len(layers[layer])) + "i", *layers[layer]))
+
+with open(OUTPUT_LEVEL, "wb") as file:
+    file.write(level)